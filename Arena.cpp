@@ -0,0 +1,87 @@
+/*
+    Arena.cpp
+
+    Implementation file for a bump allocator of character data
+*/
+
+#include "Arena.hpp"
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+
+// arena allocating blocks of at least blockSize bytes
+Arena::Arena(std::size_t blockSize)
+    : currentBlock(0), next(nullptr), end(nullptr), blockSize(blockSize), bytesUsed(0), bytesStored(0), valuesStored(0), resets(0)
+{
+}
+
+// copy characters into the arena
+std::string_view Arena::store(std::string_view characters)
+{
+    if (next == nullptr || static_cast<std::size_t>(end - next) < characters.size())
+        nextBlock(characters.size());
+    char* const stored = next;
+    std::memcpy(stored, characters.data(), characters.size());
+    next += characters.size();
+    bytesUsed += characters.size();
+    bytesStored += characters.size();
+    ++valuesStored;
+    return std::string_view(stored, characters.size());
+}
+
+// release all stored values, keeping the blocks for reuse
+void Arena::reset()
+{
+    currentBlock = 0;
+    next = blocks.empty() ? nullptr : blocks.front().get();
+    end = blocks.empty() ? nullptr : next + blockSizes.front();
+    bytesUsed = 0;
+    ++resets;
+}
+
+// Get method for bytes in use since the last reset
+long long Arena::getBytesUsed() const
+{
+    return bytesUsed;
+}
+
+// Get method for total bytes stored, over all resets
+long long Arena::getBytesStored() const
+{
+    return bytesStored;
+}
+
+// Get method for bytes allocated for blocks
+long long Arena::getBytesReserved() const
+{
+    return std::accumulate(blockSizes.begin(), blockSizes.end(), 0LL);
+}
+
+// Get method for total values stored, over all resets
+long long Arena::getValuesStored() const
+{
+    return valuesStored;
+}
+
+// Get method for the number of resets
+long long Arena::getResets() const
+{
+    return resets;
+}
+
+// make room for at least size bytes
+void Arena::nextBlock(std::size_t size)
+{
+    // reuse the following blocks kept from before a reset
+    if (next != nullptr)
+        ++currentBlock;
+    while (currentBlock < blocks.size() && blockSizes[currentBlock] < size)
+        ++currentBlock;
+    if (currentBlock == blocks.size()) {
+        const auto newSize = std::max(blockSize, size);
+        blocks.push_back(std::make_unique<char[]>(newSize));
+        blockSizes.push_back(newSize);
+    }
+    next = blocks[currentBlock].get();
+    end = next + blockSizes[currentBlock];
+}
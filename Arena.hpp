@@ -0,0 +1,67 @@
+/*
+    Arena.hpp
+
+    Include file for a bump allocator of character data
+
+    Characters are copied into large blocks, so storing a value costs a
+    memcpy instead of a heap allocation. Stored values stay valid until
+    the arena is reset, which releases everything at once.
+*/
+
+#ifndef INCLUDED_ARENA_HPP
+#define INCLUDED_ARENA_HPP
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+class Arena
+{
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<std::size_t> blockSizes;
+    std::size_t currentBlock;
+    char* next;
+    char* end;
+    std::size_t blockSize;
+    long long bytesUsed;
+    long long bytesStored;
+    long long valuesStored;
+    long long resets;
+
+public:
+    // arena allocating blocks of at least blockSize bytes
+    Arena(std::size_t blockSize = 64 * 1024);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // copy characters into the arena
+    std::string_view store(std::string_view characters);
+
+    // release all stored values, keeping the blocks for reuse
+    void reset();
+
+    // Get method for bytes in use since the last reset
+    long long getBytesUsed() const;
+
+    // Get method for total bytes stored, over all resets
+    long long getBytesStored() const;
+
+    // Get method for bytes allocated for blocks
+    long long getBytesReserved() const;
+
+    // Get method for total values stored, over all resets
+    long long getValuesStored() const;
+
+    // Get method for the number of resets
+    long long getResets() const;
+
+private:
+    // make room for at least size bytes
+    void nextBlock(std::size_t size);
+};
+
+#endif
@@ -0,0 +1,290 @@
+/*
+    Checkpoint.cpp
+
+    Implementation file for checkpoints of a srcFacts pass over an archive
+*/
+
+#include "Checkpoint.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std::literals::string_view_literals;
+
+namespace {
+
+    constexpr std::string_view MAGIC = "srcFacts checkpoint 2"sv;
+
+    // start of the hash of the input
+    constexpr std::uint64_t HASH_BASIS = 0xcbf29ce484222325ULL;
+
+    // counters of the facts, in the order of the checkpoint
+    constexpr std::int64_t FactCounters::* COUNTERS[] = {
+        &FactCounters::bytes, &FactCounters::textsize, &FactCounters::loc, &FactCounters::files,
+        &FactCounters::exprCount, &FactCounters::functionCount, &FactCounters::classCount,
+        &FactCounters::unitCount, &FactCounters::archiveUnitCount, &FactCounters::declCount,
+        &FactCounters::commentCount, &FactCounters::lineCommentCount, &FactCounters::returnCount,
+        &FactCounters::literalCount
+    };
+
+    // hash continued with a word of the input, with the high bits folded down
+    inline std::uint64_t hashWord(std::uint64_t hash, std::uint64_t word) {
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        return hash ^ (hash >> 29);
+    }
+
+    // hash continued with the whole words of the input in [first, last), for a last that is a multiple of words from first
+    std::uint64_t hashWords(std::uint64_t hash, const char* first, const char* last) {
+        for (; first != last; first += sizeof(std::uint64_t)) {
+            std::uint64_t word;
+            std::memcpy(&word, first, sizeof(word));
+            hash = hashWord(hash, word);
+        }
+        return hash;
+    }
+
+    /*
+        Hash of the input before the offset, from the hash of its whole words
+        @param[in] input Whole input
+        @param[in] offset Offset of the end of the hash
+        @param[in] wordsHash Hash of the whole words of the input before the offset
+        @return Hash with the bytes after the whole words
+    */
+    std::uint64_t hashBefore(std::string_view input, long long offset, std::uint64_t wordsHash) {
+
+        std::uint64_t hash = wordsHash;
+        for (const char c : input.substr(offset - offset % sizeof(std::uint64_t), offset % sizeof(std::uint64_t)))
+            hash = hashWord(hash, static_cast<unsigned char>(c));
+        return hash;
+    }
+
+    // hash of all of the input before the offset
+    std::uint64_t hashBefore(std::string_view input, long long offset) {
+
+        return hashBefore(input, offset, hashWords(HASH_BASIS, input.data(), input.data() + (offset - offset % sizeof(std::uint64_t))));
+    }
+
+    // append text, prefixed by its size, so any characters are allowed
+    void appendText(std::string& out, std::string_view text) {
+        out += ' ';
+        out += std::to_string(text.size());
+        out += ':';
+        out += text;
+    }
+
+    // read text written by appendText()
+    std::string readText(std::istream& in) {
+
+        std::size_t size = 0;
+        if (!(in >> size) || in.get() != ':')
+            return std::string();
+        std::string text(size, ' ');
+        in.read(text.data(), size);
+        return text;
+    }
+
+    // append the counters of a set of facts, with the counters of the configured measures
+    void appendFacts(std::string& out, const FactCounters& facts, std::size_t measures) {
+        for (const auto counter : COUNTERS) {
+            out += ' ';
+            out += std::to_string(facts.*counter);
+        }
+        for (std::size_t i = 0; i < measures; ++i) {
+            out += ' ';
+            out += std::to_string(facts.measures[i]);
+        }
+        out += '\n';
+    }
+
+    // read the counters of a set of facts, with the counters of the configured measures
+    bool readFacts(std::istream& in, FactCounters& facts, std::size_t measures) {
+        for (const auto counter : COUNTERS) {
+            if (!(in >> facts.*counter))
+                return false;
+        }
+        for (std::size_t i = 0; i < measures; ++i) {
+            if (!(in >> facts.measures[i]))
+                return false;
+        }
+        return true;
+    }
+}
+
+/*
+    Read a checkpoint
+    @param[in] path Path of the checkpoint
+    @param[out] checkpoint Checkpoint read
+    @return false when there is no checkpoint at the path
+*/
+bool readCheckpoint(const std::string& path, Checkpoint& checkpoint) {
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    std::string line;
+    bool isValid = std::getline(in, line) && line == MAGIC;
+    std::string field;
+    while (isValid && in >> field && field != "end"sv) {
+        if (field == "input"sv) {
+            isValid = static_cast<bool>(in >> checkpoint.inputSize >> checkpoint.inputHash);
+        } else if (field == "offset"sv) {
+            isValid = static_cast<bool>(in >> checkpoint.offset >> checkpoint.depth);
+        } else if (field == "namespace"sv) {
+            auto prefix = readText(in);
+            checkpoint.namespaces.emplace_back(std::move(prefix), readText(in));
+        } else if (field == "measure"sv) {
+            auto spec = readText(in);
+            checkpoint.measures.emplace_back(std::move(spec), readText(in));
+            isValid = checkpoint.measures.size() <= MAX_MEASURES;
+        } else if (field == "url"sv) {
+            checkpoint.facts.url = readText(in);
+        } else if (field == "filename"sv) {
+            checkpoint.facts.filename = readText(in);
+        } else if (field == "facts"sv) {
+            isValid = readFacts(in, checkpoint.facts.facts, checkpoint.measures.size());
+        } else if (field == "language"sv) {
+            LanguageFacts entry;
+            entry.language = readText(in);
+            isValid = readFacts(in, entry.facts, checkpoint.measures.size());
+            checkpoint.facts.languages.push_back(std::move(entry));
+        } else {
+            isValid = false;
+        }
+    }
+    if (!isValid || field != "end"sv) {
+        std::cerr << "srcFacts: Invalid checkpoint " << path << '\n';
+        exit(1);
+    }
+    return true;
+}
+
+/*
+    Check that a checkpoint is of the input
+    @param[in] checkpoint Checkpoint read
+    @param[in] input Whole input
+    @return false for a checkpoint of another input, or a changed input
+*/
+bool isCheckpointOf(const Checkpoint& checkpoint, std::string_view input) {
+
+    return checkpoint.inputSize == static_cast<long long>(input.size())
+        && checkpoint.offset >= 0 && checkpoint.offset <= checkpoint.inputSize
+        && checkpoint.inputHash == hashBefore(input, checkpoint.offset);
+}
+
+/*
+    Checkpoints of a pass over an input
+    @param[in] path Path of the checkpoint
+    @param[in] interval Bytes of input between checkpoints, at least
+    @param[in] input Whole input
+    @param[in] base Checkpoint the pass resumed from, or an empty checkpoint
+*/
+Checkpointer::Checkpointer(const std::string& path, long long interval, std::string_view input, const Checkpoint& base)
+    : path(path), interval(interval), input(input), base(base), lastOffset(base.offset), wordsHash(HASH_BASIS), hashedOffset(0),
+      checkpoints(0), seconds(0)
+{}
+
+// add a namespace declared on the root element, for the namespace context of later checkpoints
+void Checkpointer::addNamespace(std::string_view prefix, std::string_view uri)
+{
+    base.namespaces.emplace_back(prefix, uri);
+}
+
+/*
+    Write the checkpoint at the end of a unit
+    @param[in] rangeOffset Offset in the range after the unit
+    @param[in] range Facts of the range up to the offset
+*/
+void Checkpointer::write(long long rangeOffset, const RangeFacts& range)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // facts before the start of the range merged with the facts of the range, as finishFile() does
+    RangeFacts facts = base.facts;
+    facts.facts += range.facts;
+    if (!range.url.empty())
+        facts.url = range.url;
+    if (facts.filename.empty())
+        facts.filename = range.filename;
+    mergeLanguages(facts.languages, range.languages);
+
+    // hash of the whole input before the offset, extended from the last checkpoint
+    const long long offset = base.offset + rangeOffset;
+    const long long wordsEnd = offset - offset % sizeof(std::uint64_t);
+    wordsHash = hashWords(wordsHash, input.data() + hashedOffset, input.data() + wordsEnd);
+    hashedOffset = wordsEnd;
+
+    text.assign(MAGIC);
+    text += "\ninput ";
+    text += std::to_string(input.size());
+    text += ' ';
+    text += std::to_string(hashBefore(input, offset, wordsHash));
+    text += "\noffset ";
+    text += std::to_string(offset);
+    text += " 1\n";
+    for (const auto& [prefix, uri] : base.namespaces) {
+        text += "namespace"sv;
+        appendText(text, prefix);
+        appendText(text, uri);
+        text += '\n';
+    }
+    for (const auto& [spec, label] : base.measures) {
+        text += "measure"sv;
+        appendText(text, spec);
+        appendText(text, label);
+        text += '\n';
+    }
+    text += "url"sv;
+    appendText(text, facts.url);
+    text += "\nfilename"sv;
+    appendText(text, facts.filename);
+    text += "\nfacts"sv;
+    appendFacts(text, facts.facts, base.measures.size());
+    for (const auto& entry : facts.languages) {
+        text += "language"sv;
+        appendText(text, entry.language);
+        appendFacts(text, entry.facts, base.measures.size());
+    }
+    text += "end\n"sv;
+
+    // replace the last checkpoint only with a complete one
+    const std::string temporaryPath = path + ".tmp";
+    const int fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool isWritten = fd != -1;
+    for (std::size_t written = 0; isWritten && written < text.size(); ) {
+        const ssize_t bytes = ::write(fd, text.data() + written, text.size() - written);
+        if (bytes == -1 && errno == EINTR)
+            continue;
+        isWritten = bytes > 0;
+        written += isWritten ? bytes : 0;
+    }
+    isWritten = isWritten && fsync(fd) == 0;
+    if (fd != -1)
+        isWritten = close(fd) == 0 && isWritten;
+    if (!isWritten || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "srcFacts: Unable to write checkpoint " << path << '\n';
+        exit(1);
+    }
+
+    lastOffset = offset;
+    ++checkpoints;
+    seconds += std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() - start).count();
+}
+
+// Get method for the number of checkpoints written
+int Checkpointer::getCheckpoints() const
+{
+    return checkpoints;
+}
+
+// Get method for the time spent writing checkpoints
+double Checkpointer::getSeconds() const
+{
+    return seconds;
+}
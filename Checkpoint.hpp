@@ -0,0 +1,110 @@
+/*
+    Checkpoint.hpp
+
+    Include file for checkpoints of a srcFacts pass over an archive
+
+    A checkpoint is taken at the end of a unit of an archive, at depth 1,
+    where nothing of a unit is open. It has the offset of the input after
+    the unit, the depth, the namespaces declared on the root element, and
+    the facts of the input before the offset, as the facts of a range. A
+    resumed pass parses the input after the offset as a second range at
+    depth 1, and the two ranges are merged as the ranges of a split file.
+
+    The checkpoint is only used for the same input, checked by its size
+    and a hash of all of the input before the offset, which the pass
+    extends at each checkpoint, and with the same configured
+    measures, since their counts are in the facts. Each checkpoint replaces
+    the last one by a rename, so a preempted pass leaves a complete one.
+*/
+
+#ifndef INCLUDED_CHECKPOINT_HPP
+#define INCLUDED_CHECKPOINT_HPP
+
+#include "FactsHandler.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+struct Checkpoint {
+    long long inputSize = 0;
+    std::uint64_t inputHash = 0;
+    long long offset = 0;
+    int depth = 0;
+    std::vector<std::pair<std::string, std::string>> namespaces;
+
+    // element spec and label of each configured measure, as a resumed pass must have them
+    std::vector<std::pair<std::string, std::string>> measures;
+    RangeFacts facts;
+};
+
+/*
+    Read a checkpoint
+    @param[in] path Path of the checkpoint
+    @param[out] checkpoint Checkpoint read
+    @return false when there is no checkpoint at the path
+*/
+bool readCheckpoint(const std::string& path, Checkpoint& checkpoint);
+
+/*
+    Check that a checkpoint is of the input
+    @param[in] checkpoint Checkpoint read
+    @param[in] input Whole input
+    @return false for a checkpoint of another input, or a changed input
+*/
+bool isCheckpointOf(const Checkpoint& checkpoint, std::string_view input);
+
+class Checkpointer
+{
+
+private:
+    std::string path;
+    long long interval;
+    std::string_view input;
+
+    // checkpoint the pass resumed from, with the facts before the start of the range
+    Checkpoint base;
+    long long lastOffset;
+
+    // hash of the whole words of the input before hashedOffset
+    std::uint64_t wordsHash;
+    long long hashedOffset;
+    std::string text;
+
+    int checkpoints;
+    double seconds;
+
+public:
+    /*
+        Checkpoints of a pass over an input
+        @param[in] path Path of the checkpoint
+        @param[in] interval Bytes of input between checkpoints, at least
+        @param[in] input Whole input
+        @param[in] base Checkpoint the pass resumed from, or an empty checkpoint
+    */
+    Checkpointer(const std::string& path, long long interval, std::string_view input, const Checkpoint& base);
+
+    // add a namespace declared on the root element, for the namespace context of later checkpoints
+    void addNamespace(std::string_view prefix, std::string_view uri);
+
+    // predicate for a checkpoint at the offset in the range after a unit
+    bool isDue(long long rangeOffset) const {
+        return base.offset + rangeOffset - lastOffset >= interval;
+    }
+
+    /*
+        Write the checkpoint at the end of a unit
+        @param[in] rangeOffset Offset in the range after the unit
+        @param[in] range Facts of the range up to the offset
+    */
+    void write(long long rangeOffset, const RangeFacts& range);
+
+    // Get method for the number of checkpoints written
+    int getCheckpoints() const;
+
+    // Get method for the time spent writing checkpoints
+    double getSeconds() const;
+};
+
+#endif
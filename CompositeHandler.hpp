@@ -0,0 +1,204 @@
+/*
+    CompositeHandler.hpp
+
+    Include file for a parser that dispatches each event to several handlers
+
+    Each handler is an independent consumer of the events of a single
+    parse, with its own state. A handler defines a member function only
+    for the events it uses:
+
+        startDocument(depth)
+        startTag(depth, qName, prefix, localName)
+        attribute(depth, qName, prefix, localName, value)
+        characters(depth, characters, newlines)
+        cdata(depth, characters, newlines)
+        charEntityRef(depth, characters)
+        namespaceDeclaration(depth, prefix, uri)
+        comment(depth, comment)
+        declaration(depth, version, encoding, standalone)
+        processingInstruction(depth, target, data)
+        endTag(depth, prefix, qName, localName)
+        endDocument(depth)
+        bufferRelease(parsed)
+
+    and attach(context) to be given the EventContext of the events, e.g.,
+    for the source or offset of the current event. Whether a handler has
+    a member function is decided at compile time, so there is no call,
+    test, or virtual dispatch for the events a handler does not use.
+    Handlers are called in the order given.
+*/
+
+#ifndef INCLUDED_COMPOSITEHANDLER_HPP
+#define INCLUDED_COMPOSITEHANDLER_HPP
+
+#include "XMLParser.hpp"
+#include <tuple>
+#include <type_traits>
+#include <string_view>
+#include <optional>
+
+// calls of each handler member function, only valid for handlers that have it,
+// shared by the dispatchers of events to handlers
+namespace HandlerCall {
+
+    inline constexpr auto ATTACH = [](auto& handler, const EventContext& context) -> decltype(handler.attach(context)) {
+        handler.attach(context);
+    };
+    inline constexpr auto START_DOCUMENT = [](auto& handler, int depth) -> decltype(handler.startDocument(depth)) {
+        handler.startDocument(depth);
+    };
+    inline constexpr auto START_TAG = [](auto& handler, int depth, std::string_view qName, std::string_view prefix, std::string_view localName)
+        -> decltype(handler.startTag(depth, qName, prefix, localName)) {
+        handler.startTag(depth, qName, prefix, localName);
+    };
+    inline constexpr auto ATTRIBUTE = [](auto& handler, int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value)
+        -> decltype(handler.attribute(depth, qName, prefix, localName, value)) {
+        handler.attribute(depth, qName, prefix, localName, value);
+    };
+    inline constexpr auto CHARACTERS = [](auto& handler, int depth, std::string_view characters, int newlines)
+        -> decltype(handler.characters(depth, characters, newlines)) {
+        handler.characters(depth, characters, newlines);
+    };
+    inline constexpr auto CDATA = [](auto& handler, int depth, std::string_view characters, int newlines)
+        -> decltype(handler.cdata(depth, characters, newlines)) {
+        handler.cdata(depth, characters, newlines);
+    };
+    inline constexpr auto CHAR_ENTITY_REF = [](auto& handler, int depth, std::string_view characters)
+        -> decltype(handler.charEntityRef(depth, characters)) {
+        handler.charEntityRef(depth, characters);
+    };
+    inline constexpr auto NAMESPACE = [](auto& handler, int depth, std::string_view prefix, std::string_view uri)
+        -> decltype(handler.namespaceDeclaration(depth, prefix, uri)) {
+        handler.namespaceDeclaration(depth, prefix, uri);
+    };
+    inline constexpr auto COMMENT = [](auto& handler, int depth, std::string_view comment) -> decltype(handler.comment(depth, comment)) {
+        handler.comment(depth, comment);
+    };
+    inline constexpr auto DECLARATION = [](auto& handler, int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone)
+        -> decltype(handler.declaration(depth, version, encoding, standalone)) {
+        handler.declaration(depth, version, encoding, standalone);
+    };
+    inline constexpr auto PI = [](auto& handler, int depth, std::string_view target, std::string_view data)
+        -> decltype(handler.processingInstruction(depth, target, data)) {
+        handler.processingInstruction(depth, target, data);
+    };
+    inline constexpr auto END_TAG = [](auto& handler, int depth, std::string_view prefix, std::string_view qName, std::string_view localName)
+        -> decltype(handler.endTag(depth, prefix, qName, localName)) {
+        handler.endTag(depth, prefix, qName, localName);
+    };
+    inline constexpr auto END_DOCUMENT = [](auto& handler, int depth) -> decltype(handler.endDocument(depth)) {
+        handler.endDocument(depth);
+    };
+    inline constexpr auto BUFFER_RELEASE = [](auto& handler, std::string_view parsed) -> decltype(handler.bufferRelease(parsed)) {
+        handler.bufferRelease(parsed);
+    };
+
+    // call a single handler, when it has the member function
+    template <typename Call, typename Handler, typename... Args>
+    void dispatchTo(const Call& call, Handler& handler, Args&&... args) {
+        if constexpr (std::is_invocable_v<const Call&, Handler&, Args...>)
+            call(handler, args...);
+    }
+
+    // predicate for a member function of the handler
+    template <typename Call, typename Handler, typename... Args>
+    constexpr bool isHandledBy() {
+        return std::is_invocable_v<const Call&, Handler&, Args...>;
+    }
+}
+
+template <typename... Handlers>
+class CompositeHandler
+{
+
+private:
+    std::tuple<Handlers&...> handlers;
+    XMLParser parser;
+
+    // call each handler that has the member function, in order
+    template <typename Call, typename... Args>
+    void dispatch(const Call& call, Args&&... args) {
+        std::apply([&](auto&... handler) {
+            (HandlerCall::dispatchTo(call, handler, args...), ...);
+        }, handlers);
+    }
+
+    // predicate for a member function of at least one handler
+    template <typename Call, typename... Args>
+    static constexpr bool isHandled() {
+        return (HandlerCall::isHandledBy<Call, Handlers, Args...>() || ...);
+    }
+
+public:
+    // parser that dispatches each event to the handlers
+    CompositeHandler(Handlers&... handlers)
+        : handlers(handlers...),
+          parser(
+            [this](int depth, std::string_view qName, std::string_view prefix, std::string_view localName) {
+                dispatch(HandlerCall::START_TAG, depth, qName, prefix, localName);
+            },
+            [this](int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value) {
+                dispatch(HandlerCall::ATTRIBUTE, depth, qName, prefix, localName, value);
+            },
+            [this](int depth, std::string_view characters, int newlines) {
+                dispatch(HandlerCall::CHARACTERS, depth, characters, newlines);
+            },
+            [this](int depth, std::string_view characters, int newlines) {
+                dispatch(HandlerCall::CDATA, depth, characters, newlines);
+            },
+            [this](int depth, std::string_view characters) {
+                dispatch(HandlerCall::CHAR_ENTITY_REF, depth, characters);
+            },
+            [this](int depth, std::string_view prefix, std::string_view uri) {
+                dispatch(HandlerCall::NAMESPACE, depth, prefix, uri);
+            },
+            [this](int depth, std::string_view comment) {
+                dispatch(HandlerCall::COMMENT, depth, comment);
+            },
+            [this](int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone) {
+                dispatch(HandlerCall::DECLARATION, depth, version, encoding, standalone);
+            },
+            [this](int depth, std::string_view target, std::string_view data) {
+                dispatch(HandlerCall::PI, depth, target, data);
+            },
+            [this](int depth, std::string_view prefix, std::string_view qName, std::string_view localName) {
+                dispatch(HandlerCall::END_TAG, depth, prefix, qName, localName);
+            },
+            [this](int depth) {
+                dispatch(HandlerCall::START_DOCUMENT, depth);
+            },
+            [this](int depth) {
+                dispatch(HandlerCall::END_DOCUMENT, depth);
+            })
+    {
+        // only a handler for the buffer release keeps it from being skipped
+        if constexpr (isHandled<decltype(HandlerCall::BUFFER_RELEASE), std::string_view>()) {
+            parser.setBufferReleaseHandler([this](std::string_view parsed) {
+                dispatch(HandlerCall::BUFFER_RELEASE, parsed);
+            });
+        }
+        dispatch(HandlerCall::ATTACH, static_cast<const EventContext&>(parser));
+    }
+
+    // the handlers are referenced by the parser handlers
+    CompositeHandler(const CompositeHandler&) = delete;
+    CompositeHandler& operator=(const CompositeHandler&) = delete;
+
+    // Parse the XML read from file descriptor fd
+    void parse(int fd = 0) {
+        parser.parse(fd);
+    }
+
+    // Parse a range of XML in memory that starts outside of any markup at
+    // element depth startDepth, with errors located in its document, when given
+    void parse(std::string_view range, int startDepth, std::string_view document = std::string_view()) {
+        parser.parse(range, startDepth, document);
+    }
+
+    // the parser shared by the handlers
+    XMLParser& getParser() {
+        return parser;
+    }
+};
+
+#endif
@@ -0,0 +1,51 @@
+/*
+    EventContext.hpp
+
+    Include file for the context of the current event, for handlers
+
+    Handlers that need more than the parameters of an event, e.g., the
+    source or offset of the current event, ask the context they were
+    attached to. The context is the XMLParser when the handlers are
+    called by the parser, and a replay of the event otherwise, e.g., on
+    a consumer thread of a pipeline. Only these calls are virtual, not
+    the calls of the handlers.
+
+    The views given to handlers are only valid during the handler. A
+    handler that keeps a value retains it in the context instead of
+    copying it into a std::string, which costs a memcpy into an arena
+    that is reset all at once at the end of its lifetime.
+*/
+
+#ifndef INCLUDED_EVENTCONTEXT_HPP
+#define INCLUDED_EVENTCONTEXT_HPP
+
+#include <string_view>
+
+class EventContext
+{
+
+public:
+    // lifetime of a retained value
+    enum Lifetime {
+        UNIT,       // until the next start tag at depth 1, i.e., a unit of a srcML archive
+        DOCUMENT    // until the start of the next document
+    };
+
+
+    // raw source of the current event, valid only during its handler
+    virtual std::string_view getEventSource() const = 0;
+
+    // offset in the input of the start of the current event
+    virtual long long getEventOffset() const = 0;
+
+    // Get method for total bytes
+    virtual long long getTotalBytes() const = 0;
+
+    // copy of a value of an event that stays valid for the lifetime
+    virtual std::string_view retain(std::string_view value, Lifetime lifetime) const = 0;
+
+protected:
+    ~EventContext() = default;
+};
+
+#endif
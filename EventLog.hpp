@@ -0,0 +1,205 @@
+/*
+    EventLog.hpp
+
+    Include file for the binary format of a log of XMLParser events
+
+    A log is written by the EventLogWriter on a single parse, and replayed
+    to handlers by the EventLogReader any number of times without parsing.
+
+    Layout of a log:
+
+        header   magic, version
+        events   one record per event
+        names    name table of the interned element and attribute names
+        trailer  offset of the name table, counts, and the size and hash
+                 of the source, then the magic again
+
+    A record starts with a tag byte of the kind of event, with flags in
+    the high bits, then the varint zigzag delta of the depth, and of the
+    offset in the source, from the previous event, and the varint size
+    of the source of the event. Then the fields of the kind of event:
+
+        START_TAG, END_TAG  varint name id
+        ATTRIBUTE           varint name id, value
+        CHARACTERS, CDATA   varint newlines, characters
+        CHAR_ENTITY_REF     characters
+        NAMESPACE           prefix, uri
+        COMMENT             comment
+        DECLARATION         version, encoding and standalone when flagged
+        PI                  target, data
+        START_DOCUMENT,
+        END_DOCUMENT        none
+
+    where text fields are a varint size followed by the characters. Each
+    entry of the name table is the varint size of the prefix, then the
+    qName as a text field.
+
+    The source of an event is not copied into the log. Replay views it
+    in the source, which must be the same as when the log was written, so
+    the log keeps its size and hash.
+*/
+
+#ifndef INCLUDED_EVENTLOG_HPP
+#define INCLUDED_EVENTLOG_HPP
+
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+
+namespace EventLog {
+
+    // version of the layout, changed when the layout changes
+    constexpr std::uint32_t VERSION = 1;
+
+    // magic at the start and end of a log
+    constexpr char MAGIC[8] = { 'X', 'M', 'L', 'E', 'V', 'L', 'O', 'G' };
+
+    // kind of event in the tag byte of a record
+    enum Kind : std::uint8_t {
+        START_DOCUMENT, START_TAG, ATTRIBUTE, CHARACTERS, CDATA, CHAR_ENTITY_REF,
+        NAMESPACE, COMMENT, DECLARATION, PI, END_TAG, END_DOCUMENT
+    };
+
+    // mask of the kind in the tag byte
+    constexpr std::uint8_t KIND_MASK = 0x0F;
+
+    // flags of the optional fields of a DECLARATION in the tag byte
+    constexpr std::uint8_t HAS_ENCODING = 0x10;
+    constexpr std::uint8_t HAS_STANDALONE = 0x20;
+
+    // start of a log
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+    };
+
+    // end of a log
+    struct Trailer {
+        std::uint64_t nameTableOffset;
+        std::uint64_t nameCount;
+        std::uint64_t eventCount;
+        std::uint64_t sourceSize;
+        std::uint64_t sourceHash;
+        char magic[8];
+    };
+
+    // append a value as a varint, 7 bits per byte, low bits first
+    inline void appendVarint(std::string& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    // append a signed value as a varint of its zigzag encoding, so small
+    // negative values are small
+    inline void appendSigned(std::string& out, std::int64_t value) {
+        appendVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    // append characters with their size
+    inline void appendText(std::string& out, std::string_view text) {
+        appendVarint(out, text.size());
+        out.append(text);
+    }
+
+    // read a varint, advancing p past it
+    inline std::uint64_t readVarint(const char*& p) {
+        std::uint64_t value = static_cast<unsigned char>(*p++);
+        if (value < 0x80)
+            return value;
+        value &= 0x7F;
+        for (int shift = 7; ; shift += 7) {
+            const std::uint64_t byte = static_cast<unsigned char>(*p++);
+            value |= (byte & 0x7F) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+    }
+
+    // read a zigzag varint, advancing p past it
+    inline std::int64_t readSigned(const char*& p) {
+        const std::uint64_t value = readVarint(p);
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    // read characters with their size, advancing p past them
+    inline std::string_view readText(const char*& p) {
+        const auto size = readVarint(p);
+        const std::string_view text(p, size);
+        p += size;
+        return text;
+    }
+
+    // hash of the source, updated with consecutive parts of it. Four
+    // independent lanes of 8-byte words, so the multiplies overlap.
+    class SourceHash {
+
+    private:
+        static constexpr std::uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+        static constexpr std::size_t BLOCK_SIZE = 32;
+
+        std::uint64_t lanes[4] = { 1, 2, 3, 4 };
+        char pending[BLOCK_SIZE];
+        std::size_t pendingSize = 0;
+        std::uint64_t size = 0;
+
+        // mix a word into a lane
+        static std::uint64_t mix(std::uint64_t lane, std::uint64_t word) {
+            lane = (lane ^ word) * MULTIPLIER;
+            return lane ^ (lane >> 32);
+        }
+
+        // mix a block of 4 words into the lanes
+        void block(const char* p) {
+            std::uint64_t words[4];
+            std::memcpy(words, p, sizeof(words));
+            for (int i = 0; i < 4; ++i)
+                lanes[i] = mix(lanes[i], words[i]);
+        }
+
+    public:
+        // hash the next part of the source
+        void update(std::string_view data) {
+            size += data.size();
+            const char* p = data.data();
+            const char* const end = p + data.size();
+            if (pendingSize) {
+                const auto count = std::min<std::size_t>(BLOCK_SIZE - pendingSize, end - p);
+                std::memcpy(pending + pendingSize, p, count);
+                pendingSize += count;
+                p += count;
+                if (pendingSize < BLOCK_SIZE)
+                    return;
+                block(pending);
+                pendingSize = 0;
+            }
+            for (; end - p >= static_cast<std::ptrdiff_t>(BLOCK_SIZE); p += BLOCK_SIZE)
+                block(p);
+            std::memcpy(pending, p, end - p);
+            pendingSize = end - p;
+        }
+
+        // hash of the source so far, with its size
+        std::uint64_t finish() const {
+            char last[BLOCK_SIZE] = {};
+            std::memcpy(last, pending, pendingSize);
+            SourceHash copy = *this;
+            copy.block(last);
+            std::uint64_t result = size * MULTIPLIER;
+            for (const auto lane : copy.lanes)
+                result = mix(result, lane);
+            return result;
+        }
+
+        // Get method for the size of the source so far
+        std::uint64_t getSize() const {
+            return size;
+        }
+    };
+}
+
+#endif
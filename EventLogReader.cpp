@@ -0,0 +1,169 @@
+/*
+    EventLogReader.cpp
+
+    Implementation file for the replay of a binary event log to handlers
+*/
+
+#include "EventLogReader.hpp"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+    /*
+        Map a whole file into memory
+        @param[in] fd File descriptor of a regular file
+        @param[in] name Name of the file for errors
+        @return View of the file, empty for an empty file
+    */
+    std::string_view mapFile(int fd, const char* name) {
+
+        struct stat status;
+        if (fstat(fd, &status) == -1 || !S_ISREG(status.st_mode)) {
+            std::cerr << "eventlog error : " << name << " is not a regular file\n";
+            exit(1);
+        }
+        if (status.st_size == 0)
+            return std::string_view();
+        void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            std::cerr << "eventlog error : Unable to map " << name << '\n';
+            exit(1);
+        }
+        madvise(data, status.st_size, MADV_SEQUENTIAL);
+        return std::string_view(static_cast<const char*>(data), status.st_size);
+    }
+
+    // unmap a file mapped by mapFile()
+    void unmapFile(std::string_view file) {
+        if (!file.empty())
+            munmap(const_cast<char*>(file.data()), file.size());
+    }
+}
+
+/*
+    Map a log and its source, rejecting a log not written from the source
+    @param[in] logPath Path of the log
+    @param[in] sourceFD File descriptor of the source, a regular file
+*/
+EventLogReader::EventLogReader(const char* logPath, int sourceFD)
+    : logPath(logPath), trailer(), recordsEnd(nullptr), offset(0)
+{
+    const int logFD = open(logPath, O_RDONLY);
+    if (logFD == -1) {
+        std::cerr << "eventlog error : Unable to open " << logPath << '\n';
+        exit(1);
+    }
+    log = mapFile(logFD, logPath);
+    close(logFD);
+    readNames();
+
+    // a stale log is rejected by the size before the whole source is hashed
+    text = mapFile(sourceFD, "source");
+    if (text.size() != trailer.sourceSize) {
+        std::cerr << "eventlog error : " << logPath << " is stale, written from a source of " << trailer.sourceSize
+                  << " bytes, not " << text.size() << " bytes\n";
+        exit(1);
+    }
+    EventLog::SourceHash sourceHash;
+    sourceHash.update(text);
+    if (sourceHash.finish() != trailer.sourceHash) {
+        std::cerr << "eventlog error : " << logPath << " is stale, written from a source with a different hash\n";
+        exit(1);
+    }
+}
+
+// unmap the log and the source
+EventLogReader::~EventLogReader()
+{
+    unmapFile(log);
+    unmapFile(text);
+}
+
+// check the header and trailer of the log, and read its name table
+void EventLogReader::readNames()
+{
+    EventLog::Header header;
+    if (log.size() >= sizeof(header) + sizeof(trailer)) {
+        std::memcpy(&header, log.data(), sizeof(header));
+        std::memcpy(&trailer, log.data() + log.size() - sizeof(trailer), sizeof(trailer));
+    }
+    if (log.size() < sizeof(header) + sizeof(trailer)
+        || std::memcmp(header.magic, EventLog::MAGIC, sizeof(header.magic)) != 0
+        || std::memcmp(trailer.magic, EventLog::MAGIC, sizeof(trailer.magic)) != 0) {
+        std::cerr << "eventlog error : " << logPath << " is not a complete event log\n";
+        exit(1);
+    }
+    if (header.version != EventLog::VERSION) {
+        std::cerr << "eventlog error : " << logPath << " is version " << header.version << ", expected " << EventLog::VERSION << '\n';
+        exit(1);
+    }
+
+    // entries of the name table, with the prefix and local name split once
+    const char* const end = log.data() + log.size() - sizeof(trailer);
+    if (trailer.nameTableOffset < sizeof(header) || trailer.nameTableOffset > static_cast<std::uint64_t>(end - log.data())) {
+        std::cerr << "eventlog error : " << logPath << " has an invalid name table\n";
+        exit(1);
+    }
+    recordsEnd = log.data() + trailer.nameTableOffset;
+    const char* p = recordsEnd;
+    names.reserve(trailer.nameCount);
+    for (std::uint64_t i = 0; i < trailer.nameCount; ++i) {
+        const auto prefixSize = p < end ? EventLog::readVarint(p) : 0;
+        const auto qName = p < end ? EventLog::readText(p) : std::string_view();
+        if (p > end || (prefixSize && prefixSize >= qName.size())) {
+            std::cerr << "eventlog error : " << logPath << " has an invalid name table\n";
+            exit(1);
+        }
+        names.push_back({ qName, qName.substr(0, prefixSize), prefixSize ? qName.substr(prefixSize + 1) : qName });
+    }
+}
+
+// raw source of the current event, valid only during its handler
+std::string_view EventLogReader::getEventSource() const
+{
+    return source;
+}
+
+// offset in the input of the start of the current event
+long long EventLogReader::getEventOffset() const
+{
+    return offset;
+}
+
+// Get method for total bytes, the whole source
+long long EventLogReader::getTotalBytes() const
+{
+    return text.size();
+}
+
+// the value itself, since the log and source are mapped for the
+// lifetime of the reader
+std::string_view EventLogReader::retain(std::string_view value, Lifetime lifetime) const
+{
+    return value;
+}
+
+// Get method for the number of events in the log
+std::uint64_t EventLogReader::getEventCount() const
+{
+    return trailer.eventCount;
+}
+
+// Get method for the size of the log
+long long EventLogReader::getLogSize() const
+{
+    return log.size();
+}
+
+// damaged record of the log, a replay error
+void EventLogReader::invalid() const
+{
+    std::cerr << "eventlog error : " << logPath << " is not a valid event log\n";
+    exit(1);
+}
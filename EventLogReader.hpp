@@ -0,0 +1,229 @@
+/*
+    EventLogReader.hpp
+
+    Include file for the replay of a binary event log to handlers
+
+    The log and its source are mapped into memory, and a replay decodes
+    the records in a single pass, calling the handlers as the parser
+    would, with the same handler interface as the CompositeHandler. Text
+    and names are views of the log, and the source of each event is a
+    view of the source, so nothing is copied.
+
+    A log is only replayed with the source it was written from, checked
+    by its size and hash. Each record is checked as it is decoded, against
+    the end of the records, the name table, and the source, so a damaged
+    log is an error instead of a read out of bounds. Since the whole source is in memory, there is a
+    single buffer release, of the whole source, before the end of the
+    document.
+*/
+
+#ifndef INCLUDED_EVENTLOGREADER_HPP
+#define INCLUDED_EVENTLOGREADER_HPP
+
+#include "CompositeHandler.hpp"
+#include "EventContext.hpp"
+#include "EventLog.hpp"
+#include <string>
+#include <string_view>
+#include <optional>
+#include <vector>
+#include <tuple>
+
+class EventLogReader : public EventContext
+{
+
+private:
+    // interned name, with its prefix and local name
+    struct Name {
+        std::string_view qName;
+        std::string_view prefix;
+        std::string_view localName;
+    };
+
+    std::string logPath;
+    std::string_view log;
+    std::string_view text;
+    EventLog::Trailer trailer;
+    std::vector<Name> names;
+
+    // end of the records, at the start of the name table
+    const char* recordsEnd;
+
+    // context of the event being replayed
+    std::string_view source;
+    long long offset;
+
+public:
+    /*
+        Map a log and its source, rejecting a log not written from the source
+        @param[in] logPath Path of the log
+        @param[in] sourceFD File descriptor of the source, a regular file
+    */
+    EventLogReader(const char* logPath, int sourceFD);
+
+    EventLogReader(const EventLogReader&) = delete;
+    EventLogReader& operator=(const EventLogReader&) = delete;
+
+    // unmap the log and the source
+    ~EventLogReader();
+
+    // replay the events of the log to each handler that has the member function, in order
+    template <typename... Handlers>
+    void replay(Handlers&... handlers) {
+        using namespace HandlerCall;
+        auto dispatch = [&](const auto& call, const auto&... args) {
+            (dispatchTo(call, handlers, args...), ...);
+        };
+        dispatch(ATTACH, static_cast<const EventContext&>(*this));
+
+        const char* p = log.data() + sizeof(EventLog::Header);
+        int depth = 0;
+        offset = 0;
+        while (true) {
+            if (p >= recordsEnd)
+                invalid();
+            // the depth changes by at most one level from event to event, and the
+            // source is in the source file, with a negative offset as a large unsigned one
+            const auto tag = static_cast<std::uint8_t>(*p++);
+            const auto depthChange = readSigned(p);
+            depth += static_cast<int>(depthChange);
+            offset += readSigned(p);
+            const auto sourceSize = readVarint(p);
+            if (p > recordsEnd || static_cast<std::uint64_t>(depthChange + 1) > 2 || depth < 0
+                || static_cast<std::uint64_t>(offset) > text.size() || sourceSize > text.size() - offset)
+                invalid();
+            source = std::string_view(text.data() + offset, sourceSize);
+            switch (tag & EventLog::KIND_MASK) {
+            case EventLog::START_DOCUMENT:
+                dispatch(START_DOCUMENT, depth);
+                break;
+            case EventLog::START_TAG: {
+                const auto& name = readName(p);
+                dispatch(START_TAG, depth, name.qName, name.prefix, name.localName);
+                break;
+            }
+            case EventLog::ATTRIBUTE: {
+                const auto& name = readName(p);
+                const auto value = readText(p);
+                dispatch(ATTRIBUTE, depth, name.qName, name.prefix, name.localName, value);
+                break;
+            }
+            case EventLog::CHARACTERS: {
+                const int newlines = static_cast<int>(readVarint(p));
+                dispatch(CHARACTERS, depth, readText(p), newlines);
+                break;
+            }
+            case EventLog::CDATA: {
+                const int newlines = static_cast<int>(readVarint(p));
+                dispatch(CDATA, depth, readText(p), newlines);
+                break;
+            }
+            case EventLog::CHAR_ENTITY_REF:
+                dispatch(CHAR_ENTITY_REF, depth, readText(p));
+                break;
+            case EventLog::NAMESPACE: {
+                const auto prefix = readText(p);
+                dispatch(NAMESPACE, depth, prefix, readText(p));
+                break;
+            }
+            case EventLog::COMMENT:
+                dispatch(COMMENT, depth, readText(p));
+                break;
+            case EventLog::DECLARATION: {
+                const auto version = readText(p);
+                const auto encoding = tag & EventLog::HAS_ENCODING ? std::optional<std::string_view>(readText(p)) : std::nullopt;
+                const auto standalone = tag & EventLog::HAS_STANDALONE ? std::optional<std::string_view>(readText(p)) : std::nullopt;
+                dispatch(DECLARATION, depth, version, encoding, standalone);
+                break;
+            }
+            case EventLog::PI: {
+                const auto target = readText(p);
+                dispatch(PI, depth, target, readText(p));
+                break;
+            }
+            case EventLog::END_TAG: {
+                const auto& name = readName(p);
+                dispatch(END_TAG, depth, name.prefix, name.qName, name.localName);
+                break;
+            }
+            case EventLog::END_DOCUMENT:
+                dispatch(BUFFER_RELEASE, text);
+                dispatch(END_DOCUMENT, depth);
+                return;
+            default:
+                invalid();
+            }
+        }
+    }
+
+    // raw source of the current event, valid only during its handler
+    std::string_view getEventSource() const override;
+
+    // offset in the input of the start of the current event
+    long long getEventOffset() const override;
+
+    // Get method for total bytes, the whole source
+    long long getTotalBytes() const override;
+
+    // the value itself, since the log and source are mapped for the
+    // lifetime of the reader
+    std::string_view retain(std::string_view value, Lifetime lifetime) const override;
+
+    // Get method for the number of events in the log
+    std::uint64_t getEventCount() const;
+
+    // Get method for the size of the log
+    long long getLogSize() const;
+
+private:
+    // check the header and trailer of the log, and read its name table
+    void readNames();
+
+    // read a varint of a record, advancing p past it. A varint is at most
+    // 10 bytes, and the name table and trailer follow the records, so the
+    // few varints read before p is checked against the end of the records
+    // stay in the log.
+    std::uint64_t readVarint(const char*& p) const {
+        static_assert(sizeof(EventLog::Trailer) >= 3 * 10, "varints of a record header read past the log");
+        std::uint64_t value = static_cast<unsigned char>(*p++);
+        if (value < 0x80)
+            return value;
+        value &= 0x7F;
+        for (int shift = 7; shift < 64; shift += 7) {
+            const std::uint64_t byte = static_cast<unsigned char>(*p++);
+            value |= (byte & 0x7F) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+        invalid();
+    }
+
+    // read a zigzag varint of a record, advancing p past it
+    std::int64_t readSigned(const char*& p) const {
+        const std::uint64_t value = readVarint(p);
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    // read characters of a record with their size, advancing p past them
+    std::string_view readText(const char*& p) const {
+        const auto size = readVarint(p);
+        if (p > recordsEnd || size > static_cast<std::uint64_t>(recordsEnd - p))
+            invalid();
+        const std::string_view value(p, size);
+        p += size;
+        return value;
+    }
+
+    // read the index of a name of a record, advancing p past it
+    const Name& readName(const char*& p) const {
+        const auto index = readVarint(p);
+        if (index >= names.size())
+            invalid();
+        return names[index];
+    }
+
+    // damaged record of the log, a replay error
+    [[noreturn]] void invalid() const;
+};
+
+#endif
@@ -0,0 +1,216 @@
+/*
+    EventLogWriter.cpp
+
+    Implementation file for the handler of XMLParser events that writes
+    them to a binary event log
+*/
+
+#include "EventLogWriter.hpp"
+#include <iostream>
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+
+namespace {
+
+    // size of the buffer written at once
+    constexpr std::size_t FLUSH_SIZE = 1024 * 1024;
+}
+
+// log written to the file descriptor fd
+EventLogWriter::EventLogWriter(int fd)
+    : fd(fd), bytesWritten(0), context(nullptr), nameCount(0), lastDepth(0), lastOffset(0), eventCount(0)
+{
+    buffer.reserve(FLUSH_SIZE + 64 * 1024);
+    EventLog::Header header{};
+    std::memcpy(header.magic, EventLog::MAGIC, sizeof(header.magic));
+    header.version = EventLog::VERSION;
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+// context of the events, for their offset and source
+void EventLogWriter::attach(const EventContext& context)
+{
+    this->context = &context;
+}
+
+// start a record with its tag, depth, offset, and source size. The start
+// and end of the document have no source.
+void EventLogWriter::startRecord(std::uint8_t tag, int depth)
+{
+    const bool isDocument = tag == EventLog::START_DOCUMENT || tag == EventLog::END_DOCUMENT;
+    const auto source = isDocument ? std::string_view() : context->getEventSource();
+    const auto offset = isDocument ? lastOffset : context->getEventOffset();
+    buffer += static_cast<char>(tag);
+    EventLog::appendSigned(buffer, depth - lastDepth);
+    EventLog::appendSigned(buffer, offset - lastOffset);
+    EventLog::appendVarint(buffer, source.size());
+    lastDepth = depth;
+    lastOffset = offset;
+    ++eventCount;
+}
+
+// id of a name, added to the name table when new
+std::uint64_t EventLogWriter::nameId(std::string_view qName, std::string_view prefix)
+{
+    auto& id = nameIds[qName];
+    if (!id) {
+        id = ++nameCount;
+        EventLog::appendVarint(names, prefix.size());
+        EventLog::appendText(names, qName);
+    }
+    return id - 1;
+}
+
+// log the start of the document
+void EventLogWriter::startDocument(int depth)
+{
+    startRecord(EventLog::START_DOCUMENT, depth);
+}
+
+// log a start tag
+void EventLogWriter::startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName)
+{
+    startRecord(EventLog::START_TAG, depth);
+    EventLog::appendVarint(buffer, nameId(qName, prefix));
+    flush();
+}
+
+// log an attribute
+void EventLogWriter::attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value)
+{
+    startRecord(EventLog::ATTRIBUTE, depth);
+    EventLog::appendVarint(buffer, nameId(qName, prefix));
+    EventLog::appendText(buffer, value);
+    flush();
+}
+
+// log text
+void EventLogWriter::characters(int depth, std::string_view characters, int newlines)
+{
+    startRecord(EventLog::CHARACTERS, depth);
+    EventLog::appendVarint(buffer, newlines);
+    EventLog::appendText(buffer, characters);
+    flush();
+}
+
+// log CDATA
+void EventLogWriter::cdata(int depth, std::string_view characters, int newlines)
+{
+    startRecord(EventLog::CDATA, depth);
+    EventLog::appendVarint(buffer, newlines);
+    EventLog::appendText(buffer, characters);
+    flush();
+}
+
+// log a character entity reference
+void EventLogWriter::charEntityRef(int depth, std::string_view characters)
+{
+    startRecord(EventLog::CHAR_ENTITY_REF, depth);
+    EventLog::appendText(buffer, characters);
+    flush();
+}
+
+// log a namespace declaration
+void EventLogWriter::namespaceDeclaration(int depth, std::string_view prefix, std::string_view uri)
+{
+    startRecord(EventLog::NAMESPACE, depth);
+    EventLog::appendText(buffer, prefix);
+    EventLog::appendText(buffer, uri);
+    flush();
+}
+
+// log an XML comment
+void EventLogWriter::comment(int depth, std::string_view comment)
+{
+    startRecord(EventLog::COMMENT, depth);
+    EventLog::appendText(buffer, comment);
+    flush();
+}
+
+// log the XML declaration
+void EventLogWriter::declaration(int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone)
+{
+    startRecord(EventLog::DECLARATION | (encoding ? EventLog::HAS_ENCODING : 0) | (standalone ? EventLog::HAS_STANDALONE : 0), depth);
+    EventLog::appendText(buffer, version);
+    if (encoding)
+        EventLog::appendText(buffer, *encoding);
+    if (standalone)
+        EventLog::appendText(buffer, *standalone);
+    flush();
+}
+
+// log a processing instruction
+void EventLogWriter::processingInstruction(int depth, std::string_view target, std::string_view data)
+{
+    startRecord(EventLog::PI, depth);
+    EventLog::appendText(buffer, target);
+    EventLog::appendText(buffer, data);
+    flush();
+}
+
+// log an end tag
+void EventLogWriter::endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName)
+{
+    startRecord(EventLog::END_TAG, depth);
+    EventLog::appendVarint(buffer, nameId(qName, prefix));
+    flush();
+}
+
+// log the end of the document, then write the name table and trailer
+void EventLogWriter::endDocument(int depth)
+{
+    startRecord(EventLog::END_DOCUMENT, depth);
+
+    EventLog::Trailer trailer{};
+    trailer.nameTableOffset = bytesWritten + buffer.size();
+    buffer.append(names);
+    trailer.nameCount = nameCount;
+    trailer.eventCount = eventCount;
+    trailer.sourceSize = sourceHash.getSize();
+    trailer.sourceHash = sourceHash.finish();
+    std::memcpy(trailer.magic, EventLog::MAGIC, sizeof(trailer.magic));
+    buffer.append(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+    flush(true);
+}
+
+// hash the parsed part of the buffer before each refill. The unparsed
+// part is moved to the start of the buffer, so consecutive parsed parts
+// are consecutive parts of the source.
+void EventLogWriter::bufferRelease(std::string_view parsed)
+{
+    sourceHash.update(parsed);
+}
+
+// Get method for the number of events logged
+std::uint64_t EventLogWriter::getEventCount() const
+{
+    return eventCount;
+}
+
+// Get method for bytes written
+long long EventLogWriter::getBytesWritten() const
+{
+    return bytesWritten + buffer.size();
+}
+
+// write the buffer when full, or always with isFinal
+void EventLogWriter::flush(bool isFinal)
+{
+    if (buffer.size() < FLUSH_SIZE && !isFinal)
+        return;
+
+    std::size_t written = 0;
+    while (written < buffer.size()) {
+        const ssize_t result = write(fd, buffer.data() + written, buffer.size() - written);
+        if (result == -1 && errno == EINTR)
+            continue;
+        if (result <= 0) {
+            std::cerr << "eventlog error : File output error\n";
+            exit(1);
+        }
+        written += result;
+    }
+    bytesWritten += buffer.size();
+    buffer.clear();
+}
@@ -0,0 +1,109 @@
+/*
+    EventLogWriter.hpp
+
+    Include file for the handler of XMLParser events that writes them to
+    a binary event log
+
+    Records are appended to a buffer written with write(2) as it fills.
+    Element and attribute names are interned, so a name is in the log
+    once, in the name table, and records have its id. The source is
+    hashed as the parser releases the buffer, and the name table and the
+    trailer with the size and hash of the source are written at the end
+    of the document. The format is in EventLog.hpp.
+*/
+
+#ifndef INCLUDED_EVENTLOGWRITER_HPP
+#define INCLUDED_EVENTLOGWRITER_HPP
+
+#include "EventContext.hpp"
+#include "EventLog.hpp"
+#include "NameTable.hpp"
+#include <string>
+#include <string_view>
+#include <optional>
+
+class EventLogWriter
+{
+
+private:
+    int fd;
+    std::string buffer;
+    long long bytesWritten;
+    const EventContext* context;
+
+    // interned names, with the id + 1 as the count, and the name table
+    NameTable nameIds;
+    std::string names;
+    std::uint64_t nameCount;
+
+    // previous event, for the deltas
+    int lastDepth;
+    long long lastOffset;
+    std::uint64_t eventCount;
+
+    EventLog::SourceHash sourceHash;
+
+public:
+    // log written to the file descriptor fd
+    EventLogWriter(int fd);
+
+    // context of the events, for their offset and source
+    void attach(const EventContext& context);
+
+    // log the start of the document
+    void startDocument(int depth);
+
+    // log a start tag
+    void startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName);
+
+    // log an attribute
+    void attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value);
+
+    // log text
+    void characters(int depth, std::string_view characters, int newlines);
+
+    // log CDATA
+    void cdata(int depth, std::string_view characters, int newlines);
+
+    // log a character entity reference
+    void charEntityRef(int depth, std::string_view characters);
+
+    // log a namespace declaration
+    void namespaceDeclaration(int depth, std::string_view prefix, std::string_view uri);
+
+    // log an XML comment
+    void comment(int depth, std::string_view comment);
+
+    // log the XML declaration
+    void declaration(int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone);
+
+    // log a processing instruction
+    void processingInstruction(int depth, std::string_view target, std::string_view data);
+
+    // log an end tag
+    void endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName);
+
+    // log the end of the document, then write the name table and trailer
+    void endDocument(int depth);
+
+    // hash the parsed part of the buffer before each refill
+    void bufferRelease(std::string_view parsed);
+
+    // Get method for the number of events logged
+    std::uint64_t getEventCount() const;
+
+    // Get method for bytes written
+    long long getBytesWritten() const;
+
+private:
+    // start a record with its tag, depth, offset, and source size
+    void startRecord(std::uint8_t tag, int depth);
+
+    // id of a name, added to the name table when new
+    std::uint64_t nameId(std::string_view qName, std::string_view prefix);
+
+    // write the buffer when full, or always with isFinal
+    void flush(bool isFinal = false);
+};
+
+#endif
@@ -0,0 +1,102 @@
+/*
+    EventRing.cpp
+
+    Implementation file for a lock-free single-producer, single-consumer ring
+*/
+
+#include "EventRing.hpp"
+#include <thread>
+#include <algorithm>
+
+namespace {
+
+    // spins before a waiting thread yields its core
+    const int SPIN_LIMIT = 64;
+
+    // wait a little longer each time, first spinning, then yielding
+    void backoff(int& spins) {
+        if (++spins < SPIN_LIMIT) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// ring with room for capacity records, rounded up to a power of 2
+EventRing::EventRing(std::size_t capacity)
+    : capacity(1), head(0), tail(0), producerHead(0), cachedTail(0), cachedHead(0), emptyWaits(0)
+{
+    while (this->capacity < capacity)
+        this->capacity <<= 1;
+    mask = this->capacity - 1;
+    records = std::make_unique<EventRecord[]>(this->capacity);
+}
+
+// wait for the consumer to release a record
+void EventRing::waitNotFull()
+{
+    cachedTail = tail.load(std::memory_order_acquire);
+    if (producerHead - cachedTail < capacity)
+        return;
+    ++statistics.fullWaits;
+    int spins = 0;
+    while (producerHead - (cachedTail = tail.load(std::memory_order_acquire)) == capacity)
+        backoff(spins);
+}
+
+// wait until the consumer has released every published record
+bool EventRing::waitEmpty()
+{
+    cachedTail = tail.load(std::memory_order_acquire);
+    if (cachedTail == producerHead)
+        return false;
+    int spins = 0;
+    while ((cachedTail = tail.load(std::memory_order_acquire)) != producerHead)
+        backoff(spins);
+    return true;
+}
+
+// wait for at least one published record, and return the number published
+std::uint64_t EventRing::waitRecords()
+{
+    const std::uint64_t current = tail.load(std::memory_order_relaxed);
+    if (cachedHead == current) {
+        cachedHead = head.load(std::memory_order_acquire);
+        if (cachedHead == current) {
+            ++emptyWaits;
+            int spins = 0;
+            while ((cachedHead = head.load(std::memory_order_acquire)) == current)
+                backoff(spins);
+        }
+    }
+    return cachedHead - current;
+}
+
+// count the current occupancy
+void EventRing::sampleOccupancy()
+{
+    cachedTail = tail.load(std::memory_order_acquire);
+    const std::uint64_t occupancy = producerHead - cachedTail;
+    statistics.maxOccupancy = std::max(statistics.maxOccupancy, occupancy);
+    ++statistics.occupancySamples;
+    statistics.occupancyTotal += occupancy;
+    ++statistics.occupancyCounts[std::min<std::uint64_t>(occupancy * OCCUPANCY_BUCKETS / capacity, OCCUPANCY_BUCKETS - 1)];
+}
+
+// number of records the ring holds
+std::size_t EventRing::getCapacity() const
+{
+    return capacity;
+}
+
+// statistics of the ring, valid once the consumer has stopped
+EventRing::Statistics EventRing::getStatistics() const
+{
+    Statistics result = statistics;
+    result.records = producerHead;
+    result.emptyWaits = emptyWaits;
+    return result;
+}
@@ -0,0 +1,159 @@
+/*
+    EventRing.hpp
+
+    Include file for a lock-free single-producer, single-consumer ring of
+    compact event records
+
+    The producer, the parser thread, writes records into a fixed ring
+    and publishes them by advancing the head. The consumer reads the
+    published records and releases them by advancing the tail. Head and
+    tail are on their own cache lines, and each side keeps a cached copy
+    of the other side's index, so the shared lines are only read when
+    the ring looks full or empty. A full ring makes the producer wait,
+    which is the backpressure of the pipeline.
+
+    Records only hold views into the parser buffer, so the buffer must
+    stay in place until the consumer releases the records that view it.
+*/
+
+#ifndef INCLUDED_EVENTRING_HPP
+#define INCLUDED_EVENTRING_HPP
+
+#include "FactCounters.hpp"
+#include <atomic>
+#include <memory>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// compact record of a single event, with views into the parser buffer
+struct EventRecord {
+    enum Kind : std::uint8_t {
+        START_DOCUMENT, START_TAG, ATTRIBUTE, CHARACTERS, CDATA, CHAR_ENTITY_REF, NAMESPACE,
+        COMMENT, DECLARATION, PI, END_TAG, END_DOCUMENT, BUFFER_RELEASE
+    };
+
+    // optional parts of a declaration that are present
+    enum Flags : std::uint8_t { HAS_ENCODING = 1, HAS_STANDALONE = 2 };
+
+    // qName of tags and attributes, prefix of a namespace, target of a PI,
+    // and encoding of a declaration
+    const char* name;
+
+    // value of an attribute, text, uri of a namespace, comment, data of a PI,
+    // version of a declaration, and the parsed part of a buffer release
+    const char* value;
+
+    // raw source of the event, or the standalone of a declaration
+    const char* source;
+
+    // offset of the event in the input, or total bytes for the end and buffer release
+    long long offset;
+
+    std::uint32_t nameSize;
+    std::uint32_t valueSize;
+    std::uint32_t sourceSize;
+
+    // size of the prefix of name, with the local name after the ':'
+    std::uint32_t prefixSize;
+    int depth;
+    int newlines;
+    Kind kind;
+    std::uint8_t flags;
+};
+
+class EventRing
+{
+
+public:
+    // occupancy samples in buckets of eighths of the capacity
+    static constexpr int OCCUPANCY_BUCKETS = 8;
+
+    // push statistics, updated only by the producer
+    struct Statistics {
+        long long records = 0;
+        long long fullWaits = 0;
+        long long emptyWaits = 0;
+        std::uint64_t maxOccupancy = 0;
+        long long occupancySamples = 0;
+        long long occupancyTotal = 0;
+        std::array<long long, OCCUPANCY_BUCKETS> occupancyCounts{};
+    };
+
+    // records between samples of the occupancy
+    static constexpr std::uint64_t SAMPLE_INTERVAL = 256;
+
+private:
+    std::unique_ptr<EventRecord[]> records;
+    std::uint64_t capacity;
+    std::uint64_t mask;
+
+    // index of the next record written, by the producer
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> head;
+
+    // index of the next record read, by the consumer
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> tail;
+
+    // producer state
+    alignas(CACHE_LINE_SIZE) std::uint64_t producerHead;
+    std::uint64_t cachedTail;
+    Statistics statistics;
+
+    // consumer state
+    alignas(CACHE_LINE_SIZE) std::uint64_t cachedHead;
+    long long emptyWaits;
+
+public:
+    // ring with room for capacity records, rounded up to a power of 2
+    EventRing(std::size_t capacity);
+
+    EventRing(const EventRing&) = delete;
+    EventRing& operator=(const EventRing&) = delete;
+
+    // slot for the next record of the producer, waiting while the ring is full
+    EventRecord& claim() {
+        if (producerHead - cachedTail == capacity)
+            waitNotFull();
+        return records[producerHead & mask];
+    }
+
+    // publish the claimed record to the consumer
+    void publish() {
+        ++producerHead;
+        head.store(producerHead, std::memory_order_release);
+        if ((producerHead & (SAMPLE_INTERVAL - 1)) == 0)
+            sampleOccupancy();
+    }
+
+    // wait until the consumer has released every published record
+    // @return true when the producer had to wait
+    bool waitEmpty();
+
+    // wait for at least one published record, and return the number published
+    std::uint64_t waitRecords();
+
+    // published record at position i after the tail
+    const EventRecord& record(std::uint64_t i) const {
+        return records[(tail.load(std::memory_order_relaxed) + i) & mask];
+    }
+
+    // release the first count records after the tail to the producer
+    void release(std::uint64_t count) {
+        tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // number of records the ring holds
+    std::size_t getCapacity() const;
+
+    // statistics of the ring, valid once the consumer has stopped
+    Statistics getStatistics() const;
+
+private:
+    // wait for the consumer to release a record
+    void waitNotFull();
+
+    // count the current occupancy
+    void sampleOccupancy();
+};
+
+#endif
@@ -0,0 +1,159 @@
+/*
+    EventTrace.cpp
+
+    Implementation file for the sampled binary trace of XMLParser events
+*/
+
+#include "EventTrace.hpp"
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+    // traces for the signal handlers and dumps on errors, with a slot for each trace
+    std::array<std::atomic<EventTrace*>, EventTrace::MAX_TRACES> traces{};
+
+    // write all of the data, with a call that is safe in a signal handler
+    bool writeAll(int fd, const void* data, std::size_t size) {
+
+        auto p = static_cast<const char*>(data);
+        while (size) {
+            const auto written = write(fd, p, size);
+            if (written == -1)
+                return false;
+            p += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    // dump all traces on the dump signal
+    extern "C" void dumpSignalHandler(int) {
+        EventTrace::dumpAll();
+    }
+
+    // turn all traces off and on with the toggle signal
+    extern "C" void toggleSignalHandler(int) {
+        for (auto& slot : traces) {
+            auto trace = slot.load();
+            if (trace)
+                trace->setEnabled(!trace->isOn());
+        }
+    }
+}
+
+/*
+    Trace of at least capacity records, registered for the signals and errors
+    @param[in] dumpPath Path of the file the ring is dumped to
+    @param[in] capacity Records kept, rounded up to a power of 2
+    @param[in] sampleInterval Records one in every sampleInterval events
+    @param[in] firstOffset Start of the offsets of the traced events
+    @param[in] lastOffset End of the offsets of the traced events
+*/
+EventTrace::EventTrace(const std::string& dumpPath, std::size_t capacity, std::uint64_t sampleInterval,
+                       long long firstOffset, long long lastOffset)
+    : recorded(0), sampleInterval(std::max<std::uint64_t>(1, sampleInterval)), countdown(1),
+      firstOffset(firstOffset), lastOffset(lastOffset), isEnabled(1),
+      start(std::chrono::steady_clock::now()), dumpPath(dumpPath)
+{
+    std::size_t size = 1;
+    while (size < capacity)
+        size *= 2;
+    ring.resize(size);
+    mask = size - 1;
+
+    // a trace without a slot would never be dumped or toggled
+    const bool isRegistered = std::any_of(traces.begin(), traces.end(), [this](std::atomic<EventTrace*>& slot) {
+        EventTrace* empty = nullptr;
+        return slot.compare_exchange_strong(empty, this);
+    });
+    if (!isRegistered) {
+        std::cerr << "trace error : More than " << MAX_TRACES << " traces\n";
+        exit(1);
+    }
+}
+
+// unregister the trace
+EventTrace::~EventTrace()
+{
+    for (auto& slot : traces) {
+        EventTrace* self = this;
+        if (slot.compare_exchange_strong(self, nullptr))
+            break;
+    }
+}
+
+// turn tracing on or off
+void EventTrace::setEnabled(bool enabled)
+{
+    isEnabled = enabled;
+}
+
+// predicate for tracing being on
+bool EventTrace::isOn() const
+{
+    return isEnabled;
+}
+
+// Get method for the records recorded, including the overwritten ones
+std::uint64_t EventTrace::getRecorded() const
+{
+    return recorded;
+}
+
+// write the ring to the dump file, only with calls that are safe in a signal handler
+bool EventTrace::dump() const
+{
+    const int fd = open(dumpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return false;
+
+    // records oldest first, from the record after the newest when the ring wrapped
+    const std::uint64_t count = recorded;
+    const std::uint64_t records = std::min<std::uint64_t>(count, ring.size());
+    const std::uint64_t oldest = count - records;
+    Header header{};
+    std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+    header.version = VERSION;
+    header.recordSize = sizeof(Record);
+    header.records = records;
+    header.recorded = count;
+    header.sampleInterval = sampleInterval;
+    header.firstOffset = firstOffset;
+    header.lastOffset = lastOffset;
+    const std::uint64_t first = oldest & mask;
+    const std::uint64_t firstPart = std::min<std::uint64_t>(records, ring.size() - first);
+    const bool isWritten = writeAll(fd, &header, sizeof(header))
+                        && writeAll(fd, ring.data() + first, firstPart * sizeof(Record))
+                        && writeAll(fd, ring.data(), (records - firstPart) * sizeof(Record));
+    close(fd);
+    return isWritten;
+}
+
+// dump the rings of all traces, e.g., on an error
+void EventTrace::dumpAll()
+{
+    for (auto& slot : traces) {
+        const auto trace = slot.load();
+        if (trace)
+            trace->dump();
+    }
+}
+
+// dump all traces on the dump signal, and turn all traces off and on with the toggle signal
+void EventTrace::installSignalHandlers(int dumpSignal, int toggleSignal)
+{
+    // restarted, so a read of the input is not interrupted by a signal
+    struct sigaction action{};
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    action.sa_handler = dumpSignalHandler;
+    sigaction(dumpSignal, &action, nullptr);
+    action.sa_handler = toggleSignalHandler;
+    sigaction(toggleSignal, &action, nullptr);
+}
@@ -0,0 +1,149 @@
+/*
+    EventTrace.hpp
+
+    Include file for the sampled binary trace of XMLParser events
+
+    A trace attached to a parser records a compact record of the kind,
+    depth, offset, source length, and time of its events into a fixed-size
+    ring in memory, overwriting the oldest records, so it can stay on for
+    a whole pass over a large input. Events are sampled, one in every
+    sample interval of events with an offset in the traced range of bytes,
+    so a range with a problem can be traced in full, and the rest of the
+    input sparsely or not at all.
+
+    The ring is dumped to its file on a parse error, and on a signal, with
+    another signal to turn tracing off and on while the parser runs. A
+    parser without a trace pays a single test of a pointer per event.
+
+    Layout of a dump:
+
+        header   magic, version, record size, records, events recorded,
+                 sample interval, and the traced range of offsets
+        records  the records in the ring, oldest first
+
+    where the numbers are in the byte order of the machine, as tracedump
+    reads them on the same machine.
+*/
+
+#ifndef INCLUDED_EVENTTRACE_HPP
+#define INCLUDED_EVENTTRACE_HPP
+
+#include "EventLog.hpp"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+
+class EventTrace
+{
+
+public:
+    // version of the layout of a dump, changed when the layout changes
+    static constexpr std::uint32_t VERSION = 1;
+
+    // magic at the start of a dump
+    static constexpr char MAGIC[8] = { 'X', 'M', 'L', 'T', 'R', 'A', 'C', 'E' };
+
+    // traces registered at once, in a fixed registry that the signal handlers can walk
+    static constexpr std::size_t MAX_TRACES = 64;
+
+    // record of a single event
+    struct Record {
+        std::int64_t offset;        // offset of the source of the event in the input
+        std::uint64_t timestamp;    // nanoseconds since the trace started
+        std::uint32_t length;       // size of the source of the event
+        std::int16_t depth;         // element depth of the event
+        EventLog::Kind kind;        // kind of the event
+        std::uint8_t reserved;
+    };
+
+    // header of a dump
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t recordSize;
+        std::uint64_t records;      // records in the dump
+        std::uint64_t recorded;     // records recorded, more than in the dump when the ring wrapped
+        std::uint64_t sampleInterval;
+        std::int64_t firstOffset;
+        std::int64_t lastOffset;
+    };
+
+private:
+    // ring of a power of 2 records, indexed by the records recorded
+    std::vector<Record> ring;
+    std::uint64_t mask;
+    std::uint64_t recorded;
+
+    // sampling of one in every sampleInterval events in [firstOffset, lastOffset)
+    std::uint64_t sampleInterval;
+    std::uint64_t countdown;
+    long long firstOffset;
+    long long lastOffset;
+
+    // changed by the toggle signal
+    volatile std::sig_atomic_t isEnabled;
+
+    std::chrono::steady_clock::time_point start;
+    std::string dumpPath;
+
+public:
+    /*
+        Trace of at least capacity records, registered for the signals and errors
+        @param[in] dumpPath Path of the file the ring is dumped to
+        @param[in] capacity Records kept, rounded up to a power of 2
+        @param[in] sampleInterval Records one in every sampleInterval events
+        @param[in] firstOffset Start of the offsets of the traced events
+        @param[in] lastOffset End of the offsets of the traced events
+    */
+    EventTrace(const std::string& dumpPath, std::size_t capacity, std::uint64_t sampleInterval,
+               long long firstOffset, long long lastOffset);
+
+    // unregister the trace
+    ~EventTrace();
+
+    EventTrace(const EventTrace&) = delete;
+    EventTrace& operator=(const EventTrace&) = delete;
+
+    /*
+        Record an event when tracing is on, the event is in the traced range, and it is sampled
+        @param[in] kind Kind of the event
+        @param[in] depth Element depth of the event
+        @param[in] offset Offset of the source of the event in the input
+        @param[in] length Size of the source of the event
+    */
+    void record(EventLog::Kind kind, int depth, long long offset, std::size_t length) {
+        if (!isEnabled || offset < firstOffset || offset >= lastOffset || --countdown)
+            return;
+        countdown = sampleInterval;
+        Record& event = ring[recorded & mask];
+        event.offset = offset;
+        event.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        event.length = static_cast<std::uint32_t>(length);
+        event.depth = static_cast<std::int16_t>(depth);
+        event.kind = kind;
+        event.reserved = 0;
+        ++recorded;
+    }
+
+    // turn tracing on or off
+    void setEnabled(bool enabled);
+
+    // predicate for tracing being on
+    bool isOn() const;
+
+    // Get method for the records recorded, including the overwritten ones
+    std::uint64_t getRecorded() const;
+
+    // write the ring to the dump file, only with calls that are safe in a signal handler
+    bool dump() const;
+
+    // dump the rings of all traces, e.g., on an error
+    static void dumpAll();
+
+    // dump all traces on the dump signal, and turn all traces off and on with the toggle signal
+    static void installSignalHandlers(int dumpSignal = SIGUSR2, int toggleSignal = SIGUSR1);
+};
+
+#endif
@@ -0,0 +1,110 @@
+/*
+    FactCounters.hpp
+
+    Include file for the set of counters in the srcFacts report
+
+    Counters are 64 bit, since text sizes of multi-GB archives pass 2^31.
+    Each set is aligned to its own cache lines so that sets updated by
+    different worker threads do not share a line. Workers count into
+    their own set, and the sets are merged at the end.
+
+    The counts of the measures configured at startup follow the built-in
+    counts, up to MAX_MEASURES, in the order of the MeasureSet.
+*/
+
+#ifndef INCLUDED_FACTCOUNTERS_HPP
+#define INCLUDED_FACTCOUNTERS_HPP
+
+#include <cstdint>
+#include <algorithm>
+#include <array>
+
+// size of a cache line on current x86-64 and ARM processors
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// most measures configured, one bit each in the masks of a MeasureSet
+constexpr std::size_t MAX_MEASURES = 32;
+
+struct alignas(CACHE_LINE_SIZE) FactCounters {
+    std::int64_t bytes = 0;
+    std::int64_t textsize = 0;
+    std::int64_t loc = 0;
+    std::int64_t files = 0;
+    std::int64_t exprCount = 0;
+    std::int64_t functionCount = 0;
+    std::int64_t classCount = 0;
+    std::int64_t unitCount = 0;
+    std::int64_t archiveUnitCount = 0;
+    std::int64_t declCount = 0;
+    std::int64_t commentCount = 0;
+    std::int64_t lineCommentCount = 0;
+    std::int64_t returnCount = 0;
+    std::int64_t literalCount = 0;
+    std::array<std::int64_t, MAX_MEASURES> measures{};
+
+    // add the counts of another set of counters
+    FactCounters& operator+=(const FactCounters& other) {
+        bytes            += other.bytes;
+        textsize         += other.textsize;
+        loc              += other.loc;
+        files            += other.files;
+        exprCount        += other.exprCount;
+        functionCount    += other.functionCount;
+        classCount       += other.classCount;
+        unitCount        += other.unitCount;
+        archiveUnitCount += other.archiveUnitCount;
+        declCount        += other.declCount;
+        commentCount     += other.commentCount;
+        lineCommentCount += other.lineCommentCount;
+        returnCount      += other.returnCount;
+        literalCount     += other.literalCount;
+        for (std::size_t i = 0; i < MAX_MEASURES; ++i)
+            measures[i] += other.measures[i];
+        return *this;
+    }
+
+    // subtract the counts of another set of counters
+    FactCounters& operator-=(const FactCounters& other) {
+        bytes            -= other.bytes;
+        textsize         -= other.textsize;
+        loc              -= other.loc;
+        files            -= other.files;
+        exprCount        -= other.exprCount;
+        functionCount    -= other.functionCount;
+        classCount       -= other.classCount;
+        unitCount        -= other.unitCount;
+        archiveUnitCount -= other.archiveUnitCount;
+        declCount        -= other.declCount;
+        commentCount     -= other.commentCount;
+        lineCommentCount -= other.lineCommentCount;
+        returnCount      -= other.returnCount;
+        literalCount     -= other.literalCount;
+        for (std::size_t i = 0; i < MAX_MEASURES; ++i)
+            measures[i] -= other.measures[i];
+        return *this;
+    }
+
+    // largest count, which sets the width of the report column
+    std::int64_t maxCount() const {
+        return std::max({ bytes, textsize, loc, files, exprCount, functionCount, classCount,
+                          unitCount, declCount, commentCount, lineCommentCount, returnCount, literalCount,
+                          *std::max_element(measures.begin(), measures.end()) });
+    }
+};
+
+/*
+    Width of a report column for values up to maxValue, including
+    the thousands separators of the output locale
+    @param[in] maxValue Largest value in the column
+    @return Width of the column, at least 5
+*/
+inline int reportWidth(std::int64_t maxValue) {
+
+    int digits = 1;
+    for (auto value = maxValue; value >= 10; value /= 10)
+        ++digits;
+
+    return std::max(5, digits + (digits - 1) / 3);
+}
+
+#endif
@@ -0,0 +1,391 @@
+/*
+    FactsHandler.cpp
+
+    Implementation file for the srcFacts handler of XMLParser events
+*/
+
+#include "FactsHandler.hpp"
+#include "Checkpoint.hpp"
+#include <iomanip>
+#include <iterator>
+#include <charconv>
+
+using namespace std::literals::string_view_literals;
+
+namespace {
+
+    // append a CSV field, quoted when needed
+    void appendCSV(std::string& row, std::string_view field) {
+
+        if (field.find_first_of(",\"\n"sv) == std::string_view::npos) {
+            row += field;
+            return;
+        }
+        row += '"';
+        for (const char c : field) {
+            if (c == '"')
+                row += '"';
+            row += c;
+        }
+        row += '"';
+    }
+
+    // append a CSV number field
+    void appendCSV(std::string& row, std::int64_t value) {
+
+        char digits[24];
+        const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+        row.append(digits, result.ptr);
+    }
+
+    // append a JSON string
+    void appendJSON(std::string& row, std::string_view value) {
+
+        static const char hexDigits[] = "0123456789abcdef";
+        row += '"';
+        for (const char c : value) {
+            if (c == '"' || c == '\\') {
+                row += '\\';
+                row += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                row += "\\u00"sv;
+                row += hexDigits[c >> 4];
+                row += hexDigits[c & 0xF];
+            } else {
+                row += c;
+            }
+        }
+        row += '"';
+    }
+
+    // names of the per-unit fields, in the order of the CSV columns
+    constexpr const char* UNIT_FIELDS[] = { "file", "language", "bytes", "characters", "loc", "classes", "functions", "declarations",
+                                            "expressions", "comments", "lineComments", "returns", "literals" };
+}
+
+// context of the events, for the offsets of units
+void FactsHandler::attach(const EventContext& context)
+{
+    this->context = &context;
+}
+
+// reset the counts before parsing a range of the input path
+void FactsHandler::startRange(const std::string& path)
+{
+    facts = FactCounters();
+    active = &facts;
+    languages.clear();
+    language = std::string_view();
+    url = std::string_view();
+    functions.clear();
+    this->path = path;
+    filename = path;
+}
+
+// move the counts of the parsed range into the range facts
+void FactsHandler::finishRange(RangeFacts& range)
+{
+    finishRange(range, context->getTotalBytes());
+}
+
+// copy the counts of the range parsed up to the offset in the range into the range facts
+void FactsHandler::finishRange(RangeFacts& range, long long rangeOffset)
+{
+    // bytes outside of the units of a language
+    facts.bytes = rangeOffset;
+    for (const auto& entry : languages)
+        facts.bytes -= entry.facts.bytes;
+
+    range.url = url;
+    range.filename = filename;
+    range.facts = facts;
+    for (const auto& entry : languages)
+        range.facts += entry.facts;
+    range.languages.assign(languages.begin(), languages.end());
+}
+
+/*
+    Resume a unit of an archive that is open at the start of the range. The
+    unit start tag was counted in an earlier range, so only its language and
+    filename are set, and its bytes are counted from its start tag by the
+    range with its end tag.
+    @param[in] language Language of the unit
+    @param[in] filename Filename of the unit
+    @param[in] unitOffset Offset of the unit start tag, before the range, so negative
+*/
+void FactsHandler::resumeUnit(std::string_view language, std::string_view filename, long long unitOffset)
+{
+    if (!language.empty())
+        active = &languageFacts(language);
+    this->language = language;
+    if (!filename.empty())
+        this->filename = filename;
+    unitStart = *active;
+    unitStartOffset = unitOffset;
+}
+
+// start of a unit of an archive at depth 1, with its facts from here
+void FactsHandler::startUnit()
+{
+    ++active->archiveUnitCount;
+    filename = path;
+    language = std::string_view();
+    unitStart = *active;
+    unitStartOffset = context->getEventOffset();
+}
+
+// namespaces of the root element, for the context of checkpoints
+void FactsHandler::namespaceDeclaration(int depth, std::string_view prefix, std::string_view uri)
+{
+    if (checkpoints && depth == 0)
+        checkpoints->addNamespace(prefix, uri);
+}
+
+// end of a unit of an archive at depth 1, with its bytes counted for its language,
+// and its facts output
+void FactsHandler::finishUnit()
+{
+    const long long bytes = context->getEventOffset() + context->getEventSource().size() - unitStartOffset;
+    if (active != &facts)
+        active->bytes += bytes;
+    if (unitsOutput) {
+        FactCounters unitFacts = *active;
+        unitFacts -= unitStart;
+        unitFacts.bytes = bytes;
+        writeUnitRecord(row, *unitsOutput, isUnitsJSON, filename, language, unitFacts, *measures);
+    }
+    active = &facts;
+
+    // checkpoint at the end of the unit, where no unit or function is open
+    if (checkpoints && checkpoints->isDue(unitStartOffset + bytes)) {
+        RangeFacts range;
+        finishRange(range, unitStartOffset + bytes);
+        checkpoints->write(unitStartOffset + bytes, range);
+    }
+}
+
+/*
+    Switch the active counters to the set of the language of the current unit.
+    The unit start tag was counted before its language was known, so its
+    counts move with it.
+    @param[in] depth Depth of the unit
+    @param[in] language Language attribute of the unit
+*/
+void FactsHandler::switchLanguage(int depth, std::string_view language)
+{
+    FactCounters& next = languageFacts(language);
+    if (&next != active) {
+        if (depth == 1)
+            unitStart = next;
+        --active->unitCount;
+        ++next.unitCount;
+        if (depth == 1) {
+            --active->archiveUnitCount;
+            ++next.archiveUnitCount;
+        }
+        active = &next;
+    }
+    this->language = retain(depth, language);
+}
+
+// counters of a language, added when new
+FactCounters& FactsHandler::languageFacts(std::string_view language)
+{
+    auto entry = std::find_if(languages.begin(), languages.end(), [language](const LanguageFacts& entry) {
+        return entry.language == language;
+    });
+    if (entry == languages.end()) {
+        languages.push_back({ std::string(language), FactCounters() });
+        entry = std::prev(languages.end());
+    }
+    return entry->facts;
+}
+
+// value of an attribute at depth retained until the end of its unit, or
+// of the document outside of the units of an archive
+std::string_view FactsHandler::retain(int depth, std::string_view value) const
+{
+    return context->retain(value, depth < 1 ? EventContext::DOCUMENT : EventContext::UNIT);
+}
+
+// count the configured measures of a start tag with a filter on its prefix or an attribute
+void FactsHandler::countFiltered(const MeasureSet::Element& element, std::string_view prefix)
+{
+    countMeasures(measures->matchPrefix(element, prefix, pendingMeasures));
+}
+
+// write the CSV row of a completed function as a single write, so rows of workers do not mix
+void FactsHandler::writeFunctionRow(const FunctionStack::Metrics& function)
+{
+    row.clear();
+    appendCSV(row, filename);
+    row += ',';
+    appendCSV(row, function.name());
+    row += ',';
+    appendCSV(row, function.loc);
+    row += ',';
+    appendCSV(row, function.statements);
+    row += ',';
+    appendCSV(row, function.maxNesting);
+    row += ',';
+    appendCSV(row, function.complexity);
+    row += ',';
+    appendCSV(row, function.returns);
+    row += '\n';
+    functionsOutput->write(row);
+}
+
+// merge the facts of the ranges of a file in order
+void finishFile(FileFacts& file) {
+
+    for (auto& range : file.ranges) {
+        file.facts += range.facts;
+        if (!range.url.empty())
+            file.url = std::move(range.url);
+        if (file.filename.empty())
+            file.filename = std::move(range.filename);
+        mergeLanguages(file.languages, range.languages);
+    }
+    file.ranges.clear();
+    file.facts.files = file.facts.unitCount;
+    if (file.facts.archiveUnitCount)
+        --file.facts.files;
+
+    // the language of a file that is not an archive is the language of the whole file,
+    // including ranges that started after its unit start tag
+    if (!file.facts.archiveUnitCount && file.languages.size() == 1)
+        file.languages.front().facts = file.facts;
+    for (auto& entry : file.languages)
+        entry.facts.files = entry.facts.archiveUnitCount ? entry.facts.archiveUnitCount : entry.facts.unitCount;
+}
+
+// write the CSV header of the per-unit output, with a field for each configured measure
+void writeUnitHeader(OutputWriter& output, const MeasureSet& measures) {
+
+    std::string header;
+    for (const auto field : UNIT_FIELDS) {
+        if (!header.empty())
+            header += ',';
+        header += field;
+    }
+    for (const auto& measure : measures.getMeasures()) {
+        header += ',';
+        appendCSV(header, measure.label);
+    }
+    header += '\n';
+    output.write(header);
+}
+
+/*
+    Write the per-unit record of the facts of a unit as a single write
+    @param[in,out] row Reused storage of the record
+    @param[in,out] output Destination of the record
+    @param[in] isJSON JSON lines, otherwise CSV
+    @param[in] filename Filename of the unit
+    @param[in] language Language of the unit
+    @param[in] facts Facts of the unit
+    @param[in] measures Configured measures, a field each after the built-in fields
+*/
+void writeUnitRecord(std::string& row, OutputWriter& output, bool isJSON, std::string_view filename, std::string_view language,
+                     const FactCounters& facts, const MeasureSet& measures) {
+
+    const std::int64_t values[] = { facts.bytes, facts.textsize, facts.loc, facts.classCount, facts.functionCount, facts.declCount,
+                                    facts.exprCount, facts.commentCount, facts.lineCommentCount, facts.returnCount, facts.literalCount };
+    row.clear();
+    if (isJSON) {
+        row += "{\"file\":"sv;
+        appendJSON(row, filename);
+        row += ",\"language\":"sv;
+        appendJSON(row, language);
+        for (std::size_t i = 0; i < std::size(values); ++i) {
+            row += ",\""sv;
+            row += UNIT_FIELDS[i + 2];
+            row += "\":"sv;
+            appendCSV(row, values[i]);
+        }
+        for (std::size_t i = 0; i < measures.getMeasures().size(); ++i) {
+            row += ',';
+            appendJSON(row, measures.getMeasures()[i].label);
+            row += ':';
+            appendCSV(row, facts.measures[i]);
+        }
+        row += "}\n"sv;
+    } else {
+        appendCSV(row, filename);
+        row += ',';
+        appendCSV(row, language);
+        for (const auto value : values) {
+            row += ',';
+            appendCSV(row, value);
+        }
+        for (std::size_t i = 0; i < measures.getMeasures().size(); ++i) {
+            row += ',';
+            appendCSV(row, facts.measures[i]);
+        }
+        row += '\n';
+    }
+    output.write(row);
+}
+
+/*
+    Output the markdown report of the facts
+    @param[in,out] out Destination of the report
+    @param[in] url URL of the input
+    @param[in] total Facts of all the input
+    @param[in] languages Facts of each language, a column each when there is more than one
+    @param[in] measures Configured measures, a row each after the built-in measures
+*/
+void writeFactsReport(std::ostream& out, std::string_view url, const FactCounters& total, const std::vector<LanguageFacts>& languages,
+                      const MeasureSet& measures) {
+
+    // columns of the report, a column for each language when there is more than one, and the total
+    std::vector<std::pair<std::string_view, const FactCounters*>> columns;
+    if (languages.size() > 1) {
+        for (const auto& entry : languages)
+            columns.emplace_back(entry.language, &entry.facts);
+        columns.emplace_back("Total"sv, &total);
+    } else {
+        columns.emplace_back("Value"sv, &total);
+    }
+    const std::pair<std::string_view, std::int64_t FactCounters::*> builtins[] = {
+        { "srcML bytes"sv, &FactCounters::bytes },
+        { "Characters"sv, &FactCounters::textsize },
+        { "Files"sv, &FactCounters::files },
+        { "LOC"sv, &FactCounters::loc },
+        { "Classes"sv, &FactCounters::classCount },
+        { "Functions"sv, &FactCounters::functionCount },
+        { "Declarations"sv, &FactCounters::declCount },
+        { "Expressions"sv, &FactCounters::exprCount },
+        { "Comments"sv, &FactCounters::commentCount },
+        { "Line Comments"sv, &FactCounters::lineCommentCount },
+        { "Returns"sv, &FactCounters::returnCount },
+        { "Literals"sv, &FactCounters::literalCount },
+    };
+
+    // labels of the configured measures wider than the built-in labels widen the label column
+    int labelWidth = 13;
+    for (const auto& measure : measures.getMeasures())
+        labelWidth = std::max(labelWidth, static_cast<int>(measure.label.size()) + 1);
+
+    std::vector<int> valueWidths;
+    for (const auto& column : columns)
+        valueWidths.push_back(std::max(reportWidth(column.second->maxCount()), static_cast<int>(column.first.size())));
+    out << "# srcFacts: " << url << '\n';
+    out << "| " << std::left << std::setw(labelWidth) << "Measure" << std::right << '|';
+    for (std::size_t i = 0; i < columns.size(); ++i)
+        out << ' ' << std::setw(valueWidths[i]) << columns[i].first << " |";
+    out << "\n|:" << std::string(labelWidth, '-') << '|';
+    for (std::size_t i = 0; i < columns.size(); ++i)
+        out << std::string(valueWidths[i] + 1, '-') << ":|";
+    out << '\n';
+    const auto writeRow = [&](std::string_view label, const auto& count) {
+        out << "| " << std::left << std::setw(labelWidth) << label << std::right << '|';
+        for (std::size_t i = 0; i < columns.size(); ++i)
+            out << ' ' << std::setw(valueWidths[i]) << count(*columns[i].second) << " |";
+        out << '\n';
+    };
+    for (const auto& [label, counter] : builtins)
+        writeRow(label, [counter = counter](const FactCounters& facts) { return facts.*counter; });
+    for (std::size_t i = 0; i < measures.getMeasures().size(); ++i)
+        writeRow(measures.getMeasures()[i].label, [i](const FactCounters& facts) { return facts.measures[i]; });
+}
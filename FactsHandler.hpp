@@ -0,0 +1,283 @@
+/*
+    FactsHandler.hpp
+
+    Include file for the srcFacts handler of XMLParser events
+
+    Counts the srcFacts measures of a range of srcML, with a set of
+    counters for each unit language. Handlers count into the active set:
+    the set of the language of the current unit, or the facts outside of
+    any unit with a language. A deque keeps the active set in place when
+    a new language is added. The url, filename, and language are
+    retained in the context, for the document or the unit, instead of
+    copied into strings.
+
+    Optionally writes the metrics of each function as a CSV row as soon
+    as the function ends, and the facts of each unit of an archive as a
+    CSV or JSON lines record as soon as the unit ends.
+
+    Optionally checkpoints the facts at the end of units of an archive.
+
+    Start tags are counted by a lookup of their name in a MeasureSet, with
+    the built-in measures and the configured measures. A configured
+    measure with an attribute filter stays pending after its start tag
+    until one of the attributes of the start tag matches.
+
+    The handlers of the events are defined in the class, so they inline
+    into the dispatch of each event, with the start and end of units, and
+    the output, out of line.
+*/
+
+#ifndef INCLUDED_FACTSHANDLER_HPP
+#define INCLUDED_FACTSHANDLER_HPP
+
+#include "EventContext.hpp"
+#include "FactCounters.hpp"
+#include "MeasureSet.hpp"
+#include "FunctionStack.hpp"
+#include "OutputWriter.hpp"
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+
+class Checkpointer;
+
+// facts of the units of a single language
+struct LanguageFacts {
+    std::string language;
+    FactCounters facts;
+};
+
+// facts of a range of an input file
+struct RangeFacts {
+    std::string url;
+    std::string filename;
+    FactCounters facts;
+    std::vector<LanguageFacts> languages;
+};
+
+// facts of a single input file, merged from the facts of its ranges
+struct FileFacts {
+    std::string path;
+    std::string url;
+    std::string filename;
+    FactCounters facts;
+    std::vector<LanguageFacts> languages;
+    std::vector<RangeFacts> ranges;
+};
+
+// counts of a range, reused for every range parsed with the same parser
+struct FactsHandler {
+    FactCounters facts;
+    FactCounters* active = &facts;
+    std::deque<LanguageFacts> languages;
+    std::string_view language;
+    std::string_view url;
+    const EventContext* context = nullptr;
+    std::string path;
+    std::string_view filename;
+    std::string row;
+
+    // measures counted for start tags, with the configured measures of the
+    // current start tag that wait for a matching attribute
+    const MeasureSet* measures = &MeasureSet::standard();
+    std::uint32_t pendingMeasures = 0;
+
+    // per-function metrics, when functionsOutput is set
+    FunctionStack functions;
+    std::unique_ptr<OutputWriter> functionsOutput;
+
+    // per-unit facts, when unitsOutput is set
+    FactCounters unitStart;
+    long long unitStartOffset = 0;
+    bool isUnitsJSON = false;
+    std::unique_ptr<OutputWriter> unitsOutput;
+
+    // checkpoints at the end of units, when set
+    Checkpointer* checkpoints = nullptr;
+
+    // context of the events, for the offsets of units
+    void attach(const EventContext& context);
+
+    // reset the counts before parsing a range of the input path
+    void startRange(const std::string& path);
+
+    // move the counts of the parsed range into the range facts
+    void finishRange(RangeFacts& range);
+
+    // copy the counts of the range parsed up to the offset in the range into the range facts
+    void finishRange(RangeFacts& range, long long rangeOffset);
+
+    /*
+        Resume a unit of an archive that is open at the start of the range
+        @param[in] language Language of the unit
+        @param[in] filename Filename of the unit
+        @param[in] unitOffset Offset of the unit start tag, before the range, so negative
+    */
+    void resumeUnit(std::string_view language, std::string_view filename, long long unitOffset);
+
+    // count a start tag
+    void startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName) {
+        pendingMeasures = 0;
+        if (const auto element = measures->find(localName)) {
+            FactCounters& facts = *active;
+            switch (element->builtin) {
+            case MeasureSet::EXPR:
+                ++facts.exprCount;
+                break;
+            case MeasureSet::DECL:
+                ++facts.declCount;
+                break;
+            case MeasureSet::COMMENT:
+                ++facts.commentCount;
+                break;
+            case MeasureSet::FUNCTION:
+                ++facts.functionCount;
+                break;
+            case MeasureSet::UNIT:
+                ++facts.unitCount;
+                if (depth == 1)
+                    startUnit();
+                break;
+            case MeasureSet::CLASS:
+                ++facts.classCount;
+                break;
+            case MeasureSet::RETURN:
+                ++facts.returnCount;
+                break;
+            case MeasureSet::LITERAL:
+                ++facts.literalCount;
+                break;
+            default:
+                break;
+            }
+            countMeasures(element->counted);
+            if (element->filtered)
+                countFiltered(*element, prefix);
+        }
+        if (functionsOutput)
+            functions.startElement(depth, localName);
+    }
+
+    // check url, filename, and language, and count line comments
+    void attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value) {
+        if (localName == "language" && depth <= 1)
+            switchLanguage(depth, value);
+        if (localName == "url")
+            url = context->retain(value, EventContext::DOCUMENT);
+        if (localName == "filename")
+            filename = retain(depth, value);
+        if (value == "line")
+            ++active->lineCommentCount;
+        if (pendingMeasures) {
+            const auto matched = measures->matchAttribute(pendingMeasures, localName, value);
+            countMeasures(matched);
+            pendingMeasures &= ~matched;
+        }
+    }
+
+    // count text size and loc
+    void characters(int depth, std::string_view characters, int newlines) {
+        FactCounters& facts = *active;
+        facts.textsize += characters.size();
+        facts.loc += newlines;
+        if (!functions.empty())
+            functions.characters(characters, newlines);
+    }
+
+    // count text size and loc of CDATA
+    void cdata(int depth, std::string_view characters, int newlines) {
+        FactCounters& facts = *active;
+        facts.textsize += characters.size();
+        facts.loc += newlines;
+        if (!functions.empty())
+            functions.characters(characters, newlines);
+    }
+
+    // count a character entity reference as a single character
+    void charEntityRef(int depth, std::string_view characters) {
+        ++active->textsize;
+        if (!functions.empty())
+            functions.characters(characters, 0);
+    }
+
+    // namespaces of the root element, for the context of checkpoints
+    void namespaceDeclaration(int depth, std::string_view prefix, std::string_view uri);
+
+    // finish units and functions
+    void endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName) {
+        if (depth == 1 && localName == "unit")
+            finishUnit();
+
+        // output the metrics of a completed function
+        if (functions.empty())
+            return;
+        if (const auto function = functions.endElement(depth, localName))
+            writeFunctionRow(*function);
+    }
+
+private:
+    // start of a unit of an archive at depth 1, with its facts from here
+    void startUnit();
+
+    // end of a unit of an archive at depth 1, with its bytes counted for its language,
+    // and its facts output
+    void finishUnit();
+
+    // switch the active counters to the set of the language of the current unit
+    void switchLanguage(int depth, std::string_view language);
+
+    // counters of a language, added when new
+    FactCounters& languageFacts(std::string_view language);
+
+    // value of an attribute at depth retained until the end of its unit, or
+    // of the document outside of the units of an archive
+    std::string_view retain(int depth, std::string_view value) const;
+
+    // count the configured measures of a start tag with a filter on its prefix or an attribute
+    void countFiltered(const MeasureSet::Element& element, std::string_view prefix);
+
+    // count configured measures
+    void countMeasures(std::uint32_t mask) {
+        for (; mask; mask &= mask - 1)
+            ++active->measures[__builtin_ctz(mask)];
+    }
+
+    // write the CSV row of a completed function
+    void writeFunctionRow(const FunctionStack::Metrics& function);
+};
+
+// add the facts of each language to the facts of the same language
+template <typename Languages>
+void mergeLanguages(std::vector<LanguageFacts>& languages, const Languages& other) {
+
+    for (const auto& entry : other) {
+        auto languageFacts = std::find_if(languages.begin(), languages.end(), [&entry](const LanguageFacts& existing) {
+            return existing.language == entry.language;
+        });
+        if (languageFacts == languages.end())
+            languages.push_back(entry);
+        else
+            languageFacts->facts += entry.facts;
+    }
+}
+
+// merge the facts of the ranges of a file in order
+void finishFile(FileFacts& file);
+
+// write the CSV header of the per-unit output, with a field for each configured measure
+void writeUnitHeader(OutputWriter& output, const MeasureSet& measures);
+
+// write the per-unit record of the facts of a unit as a single write
+void writeUnitRecord(std::string& row, OutputWriter& output, bool isJSON, std::string_view filename, std::string_view language,
+                     const FactCounters& facts, const MeasureSet& measures);
+
+// output the markdown report of the facts, with a column for each language when there is more than one,
+// and a row for each configured measure
+void writeFactsReport(std::ostream& out, std::string_view url, const FactCounters& total, const std::vector<LanguageFacts>& languages,
+                      const MeasureSet& measures = MeasureSet::standard());
+
+#endif
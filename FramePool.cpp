@@ -0,0 +1,64 @@
+/*
+    FramePool.cpp
+
+    Implementation file for a per-thread pool of coroutine frames
+*/
+
+#include "FramePool.hpp"
+#include <new>
+
+namespace {
+
+    // size of a frame, stored in front of the frame so a larger
+    // frame can be reused for a smaller coroutine
+    struct alignas(std::max_align_t) FrameHeader {
+        std::size_t capacity;
+    };
+
+    // free frames of the current thread
+    struct Pool {
+        FrameHeader* frames[FramePool::MAX_FRAMES];
+        int size = 0;
+        long long allocations = 0;
+
+        ~Pool() {
+            for (int i = 0; i < size; ++i)
+                ::operator delete(frames[i]);
+        }
+    };
+
+    thread_local Pool pool;
+}
+
+// frame of at least size bytes, reusing a free frame when one is large enough
+void* FramePool::allocate(std::size_t size)
+{
+    for (int i = pool.size - 1; i >= 0; --i) {
+        FrameHeader* const header = pool.frames[i];
+        if (header->capacity >= size) {
+            pool.frames[i] = pool.frames[--pool.size];
+            return header + 1;
+        }
+    }
+    ++pool.allocations;
+    FrameHeader* const header = static_cast<FrameHeader*>(::operator new(sizeof(FrameHeader) + size));
+    header->capacity = size;
+    return header + 1;
+}
+
+// return a frame to the pool of the current thread
+void FramePool::deallocate(void* frame)
+{
+    FrameHeader* const header = static_cast<FrameHeader*>(frame) - 1;
+    if (pool.size == MAX_FRAMES) {
+        ::operator delete(header);
+        return;
+    }
+    pool.frames[pool.size++] = header;
+}
+
+// Get method for the number of frames allocated from the heap by this thread
+long long FramePool::getAllocations()
+{
+    return pool.allocations;
+}
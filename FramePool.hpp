@@ -0,0 +1,32 @@
+/*
+    FramePool.hpp
+
+    Include file for a per-thread pool of coroutine frames
+
+    A frame that is freed is kept for the next coroutine on the same
+    thread, so repeated parses reuse the frame of the first instead of
+    allocating a new one. The pool holds at most MAX_FRAMES free frames.
+*/
+
+#ifndef INCLUDED_FRAMEPOOL_HPP
+#define INCLUDED_FRAMEPOOL_HPP
+
+#include <cstddef>
+
+class FramePool
+{
+
+public:
+    static constexpr int MAX_FRAMES = 8;
+
+    // frame of at least size bytes, reusing a free frame when one is large enough
+    static void* allocate(std::size_t size);
+
+    // return a frame to the pool of the current thread
+    static void deallocate(void* frame);
+
+    // Get method for the number of frames allocated from the heap by this thread
+    static long long getAllocations();
+};
+
+#endif
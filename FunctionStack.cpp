@@ -0,0 +1,152 @@
+/*
+    FunctionStack.cpp
+
+    Implementation file for the metrics of the open functions in srcML
+*/
+
+#include "FunctionStack.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace std::literals::string_view_literals;
+
+// empty stack
+FunctionStack::FunctionStack()
+    : size(0), skipped(0)
+{
+    kinds.fill(OTHER);
+}
+
+// remove all open functions
+void FunctionStack::clear()
+{
+    size = 0;
+    skipped = 0;
+    kinds.fill(OTHER);
+}
+
+/*
+    Update for a start tag. Statements are the *_stmt elements and the
+    control and jump statements. Complexity starts at 1, with 1 more for
+    each if, while, for, case, catch, and ternary. Nesting is the number
+    of open control statements, where the if of an if_stmt is part of it.
+    @param[in] depth Depth of the start tag
+    @param[in] localName Local name of the element
+*/
+void FunctionStack::startElement(int depth, std::string_view localName)
+{
+    // start a new function
+    if (localName == "function"sv) {
+        if (depth < MAX_DEPTH)
+            kinds[depth] = OTHER;
+        if (size == MAX_FUNCTIONS) {
+            ++skipped;
+            return;
+        }
+        auto& function = functions[size++];
+        function.depth = depth;
+        function.nameDepth = -1;
+        function.hasName = false;
+        function.nameSize = 0;
+        function.loc = 1;
+        function.statements = 0;
+        function.complexity = 1;
+        function.returns = 0;
+        function.nesting = 0;
+        function.maxNesting = 0;
+        return;
+    }
+    if (size == 0)
+        return;
+
+    // the name of the function is its first name child
+    auto& function = functions[size - 1];
+    if (!function.hasName && depth == function.depth + 1 && localName == "name"sv) {
+        function.nameDepth = depth;
+        if (depth < MAX_DEPTH)
+            kinds[depth] = OTHER;
+        return;
+    }
+
+    Kind kind = OTHER;
+    if (localName.size() > 5 && localName.substr(localName.size() - 5) == "_stmt"sv) {
+        ++function.statements;
+        if (localName == "if_stmt"sv)
+            kind = IF_STATEMENT;
+    } else if (localName == "if"sv) {
+        ++function.complexity;
+        if (depth == 0 || depth > MAX_DEPTH || kinds[depth - 1] != IF_STATEMENT) {
+            ++function.statements;
+            kind = CONTROL;
+        }
+    } else if (localName == "while"sv || localName == "for"sv) {
+        ++function.statements;
+        ++function.complexity;
+        kind = CONTROL;
+    } else if (localName == "do"sv || localName == "switch"sv || localName == "try"sv) {
+        ++function.statements;
+        kind = CONTROL;
+    } else if (localName == "case"sv || localName == "catch"sv || localName == "ternary"sv) {
+        ++function.complexity;
+    } else if (localName == "return"sv) {
+        ++function.statements;
+        ++function.returns;
+    } else if (localName == "break"sv || localName == "continue"sv || localName == "goto"sv || localName == "throw"sv) {
+        ++function.statements;
+    }
+    if (depth < MAX_DEPTH)
+        kinds[depth] = kind;
+    if (kind != OTHER) {
+        ++function.nesting;
+        function.maxNesting = std::max(function.maxNesting, function.nesting);
+    }
+}
+
+/*
+    Update for an end tag
+    @param[in] depth Depth of the end tag, the same as its start tag
+    @param[in] localName Local name of the element
+    @return Metrics of the function it ends, or nullptr
+*/
+const FunctionStack::Metrics* FunctionStack::endElement(int depth, std::string_view localName)
+{
+    if (size == 0)
+        return nullptr;
+
+    // end of a function nested too deep to track
+    if (skipped && localName == "function"sv) {
+        --skipped;
+        return nullptr;
+    }
+
+    auto& function = functions[size - 1];
+    if (depth == function.depth) {
+
+        // lines of a nested function are also lines of the enclosing function
+        --size;
+        if (size)
+            functions[size - 1].loc += function.loc - 1;
+        return &function;
+    }
+    if (depth == function.nameDepth) {
+        function.nameDepth = -1;
+        function.hasName = true;
+    }
+    if (depth < MAX_DEPTH && kinds[depth] != OTHER) {
+        kinds[depth] = OTHER;
+        --function.nesting;
+    }
+    return nullptr;
+}
+
+// update for text in the current function
+void FunctionStack::characters(std::string_view characters, int newlines)
+{
+    auto& function = functions[size - 1];
+    function.loc += newlines;
+    if (function.nameDepth != -1) {
+        const auto copied = std::min(characters.size(), MAX_NAME_SIZE - function.nameSize);
+        std::memcpy(function.nameCharacters.data() + function.nameSize, characters.data(), copied);
+        function.nameSize += copied;
+    }
+}
@@ -0,0 +1,79 @@
+/*
+    FunctionStack.hpp
+
+    Include file for the metrics of the open functions in srcML
+
+    The stack has a fixed capacity, so memory is bounded by the nesting
+    of functions and elements, not by the size of the input, and no
+    event allocates. Elements deeper than MAX_DEPTH and functions nested
+    deeper than MAX_FUNCTIONS are not tracked.
+*/
+
+#ifndef INCLUDED_FUNCTIONSTACK_HPP
+#define INCLUDED_FUNCTIONSTACK_HPP
+
+#include <string_view>
+#include <array>
+#include <cstdint>
+
+class FunctionStack
+{
+
+public:
+    static constexpr int MAX_FUNCTIONS = 32;
+    static constexpr int MAX_DEPTH = 256;
+    static constexpr std::size_t MAX_NAME_SIZE = 256;
+
+    // metrics of a single function
+    struct Metrics {
+        int depth;
+        int nameDepth;
+        bool hasName;
+        std::size_t nameSize;
+        std::array<char, MAX_NAME_SIZE> nameCharacters;
+        std::int64_t loc;
+        std::int64_t statements;
+        std::int64_t complexity;
+        std::int64_t returns;
+        int nesting;
+        int maxNesting;
+
+        // name of the function, truncated to MAX_NAME_SIZE
+        std::string_view name() const {
+            return std::string_view(nameCharacters.data(), nameSize);
+        }
+    };
+
+private:
+    // kind of open element, by depth
+    enum Kind : std::uint8_t { OTHER, CONTROL, IF_STATEMENT };
+
+    std::array<Metrics, MAX_FUNCTIONS> functions;
+    std::array<Kind, MAX_DEPTH> kinds;
+    int size;
+    int skipped;
+
+public:
+    // empty stack
+    FunctionStack();
+
+    // remove all open functions
+    void clear();
+
+    // predicate for no open functions
+    bool empty() const {
+        return size == 0;
+    }
+
+    // update for a start tag, starting a new function for a function element
+    void startElement(int depth, std::string_view localName);
+
+    // update for an end tag, returning the metrics when it ends a function, or nullptr.
+    // The metrics are valid until the next start tag.
+    const Metrics* endElement(int depth, std::string_view localName);
+
+    // update for text in the current function
+    void characters(std::string_view characters, int newlines);
+};
+
+#endif
@@ -0,0 +1,167 @@
+/*
+    Generator.hpp
+
+    Include file for a C++20 coroutine generator
+
+    A Generator<T> is a lazy input range of the values a coroutine yields
+    with co_yield. The coroutine runs only as the range is iterated, and
+    yielded values are referenced, not copied, so a value is valid until
+    the iterator is incremented. Frames come from the FramePool.
+*/
+
+#ifndef INCLUDED_GENERATOR_HPP
+#define INCLUDED_GENERATOR_HPP
+
+#if __cplusplus < 202002L
+#error "Generator.hpp requires C++20, configure with -DCOROUTINES=ON"
+#endif
+
+#include "FramePool.hpp"
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <cstddef>
+
+template <typename T>
+class Generator
+{
+
+public:
+    // state of the coroutine shared with the generator
+    struct promise_type {
+        const T* value = nullptr;
+        std::exception_ptr exception;
+
+        // coroutine frame from the frame pool
+        static void* operator new(std::size_t size) {
+            return FramePool::allocate(size);
+        }
+
+        // return the coroutine frame to the frame pool
+        static void operator delete(void* frame) {
+            FramePool::deallocate(frame);
+        }
+
+        Generator get_return_object() {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        // lazy, the coroutine starts on the first begin()
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        // reference the yielded value, valid while the coroutine is suspended
+        std::suspend_always yield_value(const T& yielded) noexcept {
+            value = std::addressof(yielded);
+            return {};
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+        // disallow co_await in a generator
+        void await_transform() = delete;
+    };
+
+    // end of the range
+    struct sentinel {};
+
+    // input iterator over the yielded values
+    class iterator {
+
+    private:
+        std::coroutine_handle<promise_type> coroutine;
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using reference = const T&;
+        using pointer = const T*;
+
+        iterator() = default;
+
+        explicit iterator(std::coroutine_handle<promise_type> coroutine)
+            : coroutine(coroutine)
+        {}
+
+        // current yielded value
+        reference operator*() const {
+            return *coroutine.promise().value;
+        }
+
+        pointer operator->() const {
+            return coroutine.promise().value;
+        }
+
+        // resume the coroutine for the next value
+        iterator& operator++() {
+            coroutine.resume();
+            if (coroutine.done())
+                rethrow();
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        friend bool operator==(const iterator& it, sentinel) noexcept {
+            return !it.coroutine || it.coroutine.done();
+        }
+
+    private:
+        // rethrow an exception that ended the coroutine
+        void rethrow() {
+            if (coroutine.promise().exception)
+                std::rethrow_exception(coroutine.promise().exception);
+        }
+
+        friend class Generator;
+    };
+
+private:
+    std::coroutine_handle<promise_type> coroutine;
+
+    explicit Generator(std::coroutine_handle<promise_type> coroutine)
+        : coroutine(coroutine)
+    {}
+
+public:
+    Generator(Generator&& other) noexcept
+        : coroutine(other.coroutine)
+    {
+        other.coroutine = nullptr;
+    }
+
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    // destroying the generator destroys a suspended coroutine
+    ~Generator() {
+        if (coroutine)
+            coroutine.destroy();
+    }
+
+    // start the coroutine, up to its first value
+    iterator begin() {
+        iterator it(coroutine);
+        ++it;
+        return it;
+    }
+
+    sentinel end() noexcept {
+        return {};
+    }
+};
+
+#endif
@@ -0,0 +1,167 @@
+/*
+    IdentityHandler.cpp
+
+    Implementation file for the identity handler of XMLParser events
+*/
+
+#include "IdentityHandler.hpp"
+
+using namespace std::literals::string_view_literals;
+
+// identity written to the file descriptor fd, rebuilt from the events with isRebuild
+IdentityHandler::IdentityHandler(int fd, bool isRebuild)
+    : isRebuild(isRebuild), passthrough(fd), output(fd), context(nullptr), isStartTagOpen(false)
+{}
+
+// context of the events, for their source
+void IdentityHandler::attach(const EventContext& context)
+{
+    this->context = &context;
+}
+
+// close an open start tag
+void IdentityHandler::closeStartTag()
+{
+    if (isStartTagOpen) {
+        output.write('>');
+        isStartTagOpen = false;
+    }
+}
+
+// rebuild a start tag, open until its attributes are written
+void IdentityHandler::startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName)
+{
+    if (!isRebuild)
+        return;
+    closeStartTag();
+    output.write('<');
+    output.write(qName);
+    isStartTagOpen = true;
+}
+
+// rebuild an attribute from its source
+void IdentityHandler::attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value)
+{
+    // values are not unescaped by the parser, so copy the source
+    // with the original delimiters
+    if (!isRebuild)
+        return;
+    output.write(' ');
+    output.write(context->getEventSource());
+}
+
+// rebuild text, escaped
+void IdentityHandler::characters(int depth, std::string_view characters, int newlines)
+{
+    if (!isRebuild)
+        return;
+    closeStartTag();
+    output.writeEscaped(characters);
+}
+
+// rebuild CDATA from its source
+void IdentityHandler::cdata(int depth, std::string_view characters, int newlines)
+{
+    // CDATA may be split over several events, so copy the source
+    // with the CDATA start and end that it contains
+    if (!isRebuild)
+        return;
+    closeStartTag();
+    output.write(context->getEventSource());
+}
+
+// rebuild a character entity reference, escaped
+void IdentityHandler::charEntityRef(int depth, std::string_view characters)
+{
+    if (!isRebuild)
+        return;
+    closeStartTag();
+    output.writeEscaped(characters);
+}
+
+// rebuild a namespace declaration from its source
+void IdentityHandler::namespaceDeclaration(int depth, std::string_view prefix, std::string_view uri)
+{
+    if (!isRebuild)
+        return;
+    output.write(' ');
+    output.write(context->getEventSource());
+}
+
+// rebuild an XML comment from its source
+void IdentityHandler::comment(int depth, std::string_view comment)
+{
+    // comments may be split over several events, so copy the source
+    // with the comment start and end that it contains
+    if (!isRebuild)
+        return;
+    closeStartTag();
+    output.write(context->getEventSource());
+}
+
+// rebuild the XML declaration
+void IdentityHandler::declaration(int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone)
+{
+    if (!isRebuild)
+        return;
+    output.write("<?xml version=\""sv);
+    output.write(version);
+    output.write('"');
+    if (encoding) {
+        output.write(" encoding=\""sv);
+        output.write(*encoding);
+        output.write('"');
+    }
+    if (standalone) {
+        output.write(" standalone=\""sv);
+        output.write(*standalone);
+        output.write('"');
+    }
+    output.write("?>\n"sv);
+}
+
+// rebuild a processing instruction
+void IdentityHandler::processingInstruction(int depth, std::string_view target, std::string_view data)
+{
+    if (!isRebuild)
+        return;
+    closeStartTag();
+    output.write("<?"sv);
+    output.write(target);
+    if (!data.empty()) {
+        output.write(' ');
+        output.write(data);
+    }
+    output.write("?>"sv);
+}
+
+// rebuild an end tag, or close an empty element
+void IdentityHandler::endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName)
+{
+    if (!isRebuild)
+        return;
+    if (isStartTagOpen) {
+        output.write("/>"sv);
+        isStartTagOpen = false;
+        return;
+    }
+    output.write("</"sv);
+    output.write(qName);
+    output.write('>');
+}
+
+// finish the rebuilt output
+void IdentityHandler::endDocument(int depth)
+{
+    if (!isRebuild)
+        return;
+    output.write('\n');
+    output.flush();
+}
+
+// copy the input from the parser buffer before each refill
+void IdentityHandler::bufferRelease(std::string_view parsed)
+{
+    if (!isRebuild)
+        passthrough.release(parsed);
+}
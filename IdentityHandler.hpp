@@ -0,0 +1,86 @@
+/*
+    IdentityHandler.hpp
+
+    Include file for the identity handler of XMLParser events, which
+    writes XML equivalent to the input
+
+    By default no event is changed, so the output is the input copied
+    directly from the parser buffer by a PassthroughWriter. With rebuild,
+    the output is rebuilt from the parsed events through an OutputWriter,
+    escaping text. Attribute values are not unescaped by the parser, so
+    they are copied with their source.
+
+    Limitation of rebuild:
+    * Whitespace inside of tags and around the root element is normalized
+*/
+
+#ifndef INCLUDED_IDENTITYHANDLER_HPP
+#define INCLUDED_IDENTITYHANDLER_HPP
+
+#include "EventContext.hpp"
+#include "PassthroughWriter.hpp"
+#include "OutputWriter.hpp"
+#include <string_view>
+#include <optional>
+
+class IdentityHandler
+{
+
+private:
+    bool isRebuild;
+    PassthroughWriter passthrough;
+    OutputWriter output;
+    const EventContext* context;
+
+    // start tag waiting for its attributes, closed by the next event
+    bool isStartTagOpen;
+
+public:
+    // identity written to the file descriptor fd, rebuilt from the events with isRebuild
+    IdentityHandler(int fd, bool isRebuild);
+
+    // context of the events, for their source
+    void attach(const EventContext& context);
+
+    // rebuild a start tag, open until its attributes are written
+    void startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName);
+
+    // rebuild an attribute from its source
+    void attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value);
+
+    // rebuild text, escaped
+    void characters(int depth, std::string_view characters, int newlines);
+
+    // rebuild CDATA from its source
+    void cdata(int depth, std::string_view characters, int newlines);
+
+    // rebuild a character entity reference, escaped
+    void charEntityRef(int depth, std::string_view characters);
+
+    // rebuild a namespace declaration from its source
+    void namespaceDeclaration(int depth, std::string_view prefix, std::string_view uri);
+
+    // rebuild an XML comment from its source
+    void comment(int depth, std::string_view comment);
+
+    // rebuild the XML declaration
+    void declaration(int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone);
+
+    // rebuild a processing instruction
+    void processingInstruction(int depth, std::string_view target, std::string_view data);
+
+    // rebuild an end tag, or close an empty element
+    void endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName);
+
+    // finish the rebuilt output
+    void endDocument(int depth);
+
+    // copy the input from the parser buffer before each refill
+    void bufferRelease(std::string_view parsed);
+
+private:
+    // close an open start tag
+    void closeStartTag();
+};
+
+#endif
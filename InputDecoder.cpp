@@ -0,0 +1,365 @@
+/*
+    InputDecoder.cpp
+
+    Implementation file for the input stage of XMLParser that decodes the
+    input to validated UTF-8 as the buffer is refilled
+*/
+
+#include "InputDecoder.hpp"
+#include "refillBuffer.hpp"
+#include "ParseDiagnostic.hpp"
+#include "EventTrace.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+    // end of the run of whole blocks of ASCII at first
+    inline const unsigned char* skipASCII(const unsigned char* first, const unsigned char* last) {
+#if defined(__AVX2__)
+        for (; last - first >= 32; first += 32) {
+            if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first))))
+                break;
+        }
+#elif defined(__SSE2__)
+        for (; last - first >= 16; first += 16) {
+            if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first))))
+                break;
+        }
+#endif
+        return first;
+    }
+
+    // append the UTF-8 of the code point at out
+    inline char* appendUTF8(char* out, std::uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            *out++ = static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            *out++ = static_cast<char>(0xC0 | (codePoint >> 6));
+            *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            *out++ = static_cast<char>(0xE0 | (codePoint >> 12));
+            *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            *out++ = static_cast<char>(0xF0 | (codePoint >> 18));
+            *out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        return out;
+    }
+}
+
+// decoder with no input
+InputDecoder::InputDecoder()
+    : fd(-1), encoding(UTF8), isDetected(false), rawSize(0), needed(0), lower(0x80), upper(0xBF), bytesRead(0),
+      decodedBytes(0), window(nullptr), isWindowAtStart(true)
+{}
+
+// start decoding the input read from the file descriptor fd, or the input in memory when fd is -1
+void InputDecoder::start(int fd, std::string_view input)
+{
+    this->fd = fd;
+    this->input = input;
+    encoding = UTF8;
+    isDetected = false;
+    rawSize = 0;
+    needed = 0;
+    lower = 0x80;
+    upper = 0xBF;
+    bytesRead = 0;
+    decodedBytes = 0;
+}
+
+/*
+    Refill the buffer with decoded input, as refillBuffer()
+    @param[in,out] cursor Iterator to current position in buffer
+    @param[in,out] cursorEnd Iterator to end of the data in the buffer
+    @param[in,out] buffer Container for characters
+    @param[in] sentinelSize Size of the sentinel written after the data
+    @return Number of bytes of UTF-8 added, 0 at the end of the input, -1 for a read error
+*/
+int InputDecoder::refill(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer, std::size_t sentinelSize)
+{
+    // move unprocessed characters, [cursor, cursorEnd), to start of the buffer
+    const auto unprocessed = std::distance(cursor, cursorEnd);
+    std::copy(cursor, cursorEnd, buffer.begin());
+    cursor = buffer.begin();
+    cursorEnd = cursor + unprocessed;
+    char* const data = buffer.data() + unprocessed;
+    const std::size_t space = buffer.size() - sentinelSize - unprocessed;
+    window = buffer.data();
+    isWindowAtStart = decodedBytes == unprocessed;
+    if (raw.size() < buffer.size())
+        raw.resize(buffer.size());
+
+    // decode until there is new UTF-8 or the input ends, since a read
+    // may only be a BOM or a part of a code unit
+    std::size_t produced = 0;
+    while (produced == 0) {
+
+        // first bytes of the input, for the encoding
+        if (!isDetected) {
+            while (rawSize < 4) {
+                const long bytes = readInput(raw.data() + rawSize, 4 - rawSize);
+                if (bytes < 0)
+                    return -1;
+                if (bytes == 0)
+                    break;
+                rawSize += bytes;
+            }
+            detect();
+            if (encoding == UTF8) {
+                std::memcpy(data, raw.data(), rawSize);
+                validate(data, data + rawSize);
+                produced = rawSize;
+                rawSize = 0;
+            }
+        }
+
+        // UTF-8 read in place and validated, after any first bytes
+        if (encoding == UTF8) {
+            const long bytes = readInput(data + produced, space - produced);
+            if (bytes < 0)
+                return -1;
+            if (bytes == 0) {
+                if (needed)
+                    invalid("Incomplete UTF-8 sequence", bytesRead, data + produced, data + produced);
+                break;
+            }
+            validate(data + produced, data + produced + bytes);
+            produced += bytes;
+            continue;
+        }
+
+        // UTF-16 read so that its UTF-8, at most 3 bytes per 2, fits
+        const std::size_t limit = std::min(raw.size(), space / 3 * 2);
+        const long bytes = readInput(raw.data() + rawSize, limit - rawSize);
+        if (bytes < 0)
+            return -1;
+        if (bytes == 0) {
+            if (rawSize)
+                invalid("Incomplete UTF-16 code unit or surrogate pair", bytesRead - rawSize, data + produced, data + produced);
+            break;
+        }
+        rawSize += bytes;
+        produced = transcode(data);
+    }
+
+    cursorEnd += produced;
+    decodedBytes += produced;
+    writeSentinel(cursorEnd, buffer, sentinelSize);
+
+    return static_cast<int>(produced);
+}
+
+// read up to size bytes of input into data, 0 at the end, -1 for a read error
+long InputDecoder::readInput(char* data, std::size_t size)
+{
+    if (fd == -1) {
+        const auto bytes = std::min(size, input.size());
+        std::memcpy(data, input.data(), bytes);
+        input.remove_prefix(bytes);
+        bytesRead += bytes;
+        return static_cast<long>(bytes);
+    }
+    ssize_t bytes;
+    while ((bytes = read(fd, data, size)) == -1 && errno == EINTR)
+        ;
+    if (bytes > 0)
+        bytesRead += bytes;
+    return static_cast<long>(bytes);
+}
+
+// detect the encoding from the first bytes of the input in raw, removing a BOM
+void InputDecoder::detect()
+{
+    const auto* first = reinterpret_cast<const unsigned char*>(raw.data());
+    auto hasPrefix = [&](std::initializer_list<unsigned char> prefix) {
+        return rawSize >= prefix.size() && std::equal(prefix.begin(), prefix.end(), first);
+    };
+    std::size_t bomSize = 0;
+    if (hasPrefix({ 0xEF, 0xBB, 0xBF })) {
+        encoding = UTF8;
+        bomSize = 3;
+    } else if (hasPrefix({ 0xFF, 0xFE })) {
+        encoding = UTF16LE;
+        bomSize = 2;
+    } else if (hasPrefix({ 0xFE, 0xFF })) {
+        encoding = UTF16BE;
+        bomSize = 2;
+    } else if (hasPrefix({ '<', 0, '?', 0 })) {
+        encoding = UTF16LE;
+    } else if (hasPrefix({ 0, '<', 0, '?' })) {
+        encoding = UTF16BE;
+    } else {
+        encoding = UTF8;
+    }
+    std::memmove(raw.data(), raw.data() + bomSize, rawSize - bomSize);
+    rawSize -= bomSize;
+    isDetected = true;
+}
+
+// validate new UTF-8 in [first, last), continuing a sequence of the last
+// block. Runs of ASCII are skipped a block at a time, and other characters
+// are checked byte by byte, rejecting overlong forms, surrogates, and code
+// points past U+10FFFF by the range of the second byte.
+void InputDecoder::validate(const char* first, const char* last)
+{
+    const auto* p = reinterpret_cast<const unsigned char*>(first);
+    const auto* const end = reinterpret_cast<const unsigned char*>(last);
+    while (p != end) {
+        if (needed == 0) {
+            p = skipASCII(p, end);
+            if (p == end)
+                break;
+            const unsigned char c = *p++;
+            if (c < 0x80)
+                continue;
+            lower = 0x80;
+            upper = 0xBF;
+            if (c >= 0xC2 && c <= 0xDF) {
+                needed = 1;
+            } else if (c >= 0xE0 && c <= 0xEF) {
+                needed = 2;
+                if (c == 0xE0)
+                    lower = 0xA0;
+                else if (c == 0xED)
+                    upper = 0x9F;
+            } else if (c >= 0xF0 && c <= 0xF4) {
+                needed = 3;
+                if (c == 0xF0)
+                    lower = 0x90;
+                else if (c == 0xF4)
+                    upper = 0x8F;
+            } else {
+                invalid("Invalid UTF-8 lead byte", bytesRead - (end - p) - 1, reinterpret_cast<const char*>(p - 1), last);
+            }
+        } else {
+            const unsigned char c = *p++;
+            if (c < lower || c > upper)
+                invalid("Invalid UTF-8 continuation byte", bytesRead - (end - p) - 1, reinterpret_cast<const char*>(p - 1), last);
+            --needed;
+            lower = 0x80;
+            upper = 0xBF;
+        }
+    }
+}
+
+// transcode the UTF-16 in raw to UTF-8 at out, keeping a partial code unit
+// or surrogate pair in raw. Blocks of 8 ASCII code units are packed to
+// bytes at once.
+std::size_t InputDecoder::transcode(char* out)
+{
+    const char* const start = out;
+    const auto* p = reinterpret_cast<const unsigned char*>(raw.data());
+    const auto* const end = p + (rawSize & ~std::size_t(1));
+    const bool isLittle = encoding == UTF16LE;
+    auto unit = [isLittle](const unsigned char* q) -> std::uint32_t {
+        return isLittle ? q[0] | (q[1] << 8) : (q[0] << 8) | q[1];
+    };
+#if defined(__SSE2__)
+    // bits of a code unit that are 0 for ASCII, in the byte order of the input
+    const __m128i nonASCII = isLittle ? _mm_set1_epi16(static_cast<short>(0xFF80)) : _mm_set1_epi16(static_cast<short>(0x80FF));
+#endif
+    while (p != end) {
+#if defined(__SSE2__)
+        if (end - p >= 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(block, nonASCII), _mm_setzero_si128())) == 0xFFFF) {
+                if (!isLittle)
+                    block = _mm_or_si128(_mm_slli_epi16(block, 8), _mm_srli_epi16(block, 8));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(block, block));
+                out += 8;
+                p += 16;
+                continue;
+            }
+        }
+#endif
+        const std::uint32_t first = unit(p);
+        if (first < 0xD800 || first > 0xDFFF) {
+            out = appendUTF8(out, first);
+            p += 2;
+            continue;
+        }
+        if (first > 0xDBFF)
+            invalid("Unpaired UTF-16 low surrogate", bytesRead - rawSize + (p - reinterpret_cast<const unsigned char*>(raw.data())), out, out);
+        if (end - p < 4)
+            break;
+        const std::uint32_t second = unit(p + 2);
+        if (second < 0xDC00 || second > 0xDFFF)
+            invalid("Unpaired UTF-16 high surrogate", bytesRead - rawSize + (p - reinterpret_cast<const unsigned char*>(raw.data())), out, out);
+        out = appendUTF8(out, 0x10000 + ((first - 0xD800) << 10) + (second - 0xDC00));
+        p += 4;
+    }
+
+    // keep what is left for the next refill
+    const auto decoded = static_cast<std::size_t>(p - reinterpret_cast<const unsigned char*>(raw.data()));
+    std::memmove(raw.data(), raw.data() + decoded, rawSize - decoded);
+    rawSize -= decoded;
+
+    return out - start;
+}
+
+// Get method for the encoding of the input
+InputDecoder::Encoding InputDecoder::getEncoding() const
+{
+    return encoding;
+}
+
+// Get method for bytes read from the input
+long long InputDecoder::getBytesRead() const
+{
+    return bytesRead;
+}
+
+// offset in the input of the start of decoded, UTF-8 that ends at the
+// end of the decoded input. The end is at the bytes read, less the part
+// of UTF-16 not yet transcoded, and each character of UTF-8 before it is
+// as long in UTF-8 input, and 2 bytes, or 4 for a surrogate pair, in UTF-16.
+long long InputDecoder::inputOffset(std::string_view decoded) const
+{
+    if (encoding == UTF8)
+        return bytesRead - static_cast<long long>(decoded.size());
+    long long inputSize = 0;
+    for (const unsigned char c : decoded) {
+        if ((c & 0xC0) != 0x80)
+            inputSize += c >= 0xF0 ? 4 : 2;
+    }
+    return bytesRead - static_cast<long long>(rawSize) - inputSize;
+}
+
+/*
+    Invalid input at offset in the input, a parser error. As for the errors
+    of the parser, the line and column are found from the decoded input in
+    the buffer when it holds the start of the input, else by rereading a
+    UTF-8 input file, else only the column from a newline in the buffer.
+    Lines of UTF-16 are not found by the bytes of newlines in the file.
+    @param[in] message Message of the error
+    @param[in] offset Offset of the error in the input
+    @param[in] position Position of the error in the decoded input in the buffer
+    @param[in] last End of the decoded input in the buffer after the error
+*/
+void InputDecoder::invalid(const char* message, long long offset, const char* position, const char* last) const
+{
+    ParseDiagnostic diagnostic;
+    diagnostic.message = message;
+    diagnostic.offset = offset;
+    const std::string_view before(window, position - window);
+    if (isWindowAtStart)
+        locate(diagnostic, before, true);
+    else if (encoding != UTF8 || fd == -1 || !locateInFile(diagnostic, fd))
+        locate(diagnostic, before, false);
+    setSnippet(diagnostic, window, position, last);
+    writeDiagnostic(std::cerr, diagnostic);
+    EventTrace::dumpAll();
+    exit(1);
+}
@@ -0,0 +1,110 @@
+/*
+    InputDecoder.hpp
+
+    Include file for the input stage of XMLParser that decodes the input
+    to validated UTF-8 as the buffer is refilled
+
+    The encoding is detected from the first bytes of the input: a BOM of
+    UTF-8, UTF-16LE, or UTF-16BE, which is removed, or the "<?" of the XML
+    declaration in UTF-16 without a BOM. Otherwise the input is UTF-8.
+
+    UTF-8 input is read directly into the parser buffer, and each block of
+    new bytes is validated in the same refill, skipping whole blocks of
+    ASCII with SIMD instructions. UTF-16 input is read into a separate
+    buffer and transcoded to UTF-8 block by block, with SIMD instructions
+    for blocks of ASCII code units. Sequences and surrogate pairs split
+    across refills are carried to the next refill.
+
+    The parser only sees UTF-8, so event offsets and sizes are in bytes
+    of UTF-8, not of the input. Invalid input is a parser error, and the
+    offset of a parser error is mapped back to an offset in the input.
+*/
+
+#ifndef INCLUDED_INPUTDECODER_HPP
+#define INCLUDED_INPUTDECODER_HPP
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+class InputDecoder
+{
+
+public:
+    // encoding of the input
+    enum Encoding { UTF8, UTF16LE, UTF16BE };
+
+private:
+    int fd;
+    std::string_view input;
+    Encoding encoding;
+    bool isDetected;
+
+    // input read but not yet decoded, at the start of raw
+    std::string raw;
+    std::size_t rawSize;
+
+    // state of the UTF-8 validator: continuation bytes still needed, and
+    // the range of the next one, narrower after some lead bytes
+    int needed;
+    unsigned char lower;
+    unsigned char upper;
+
+    long long bytesRead;
+
+    // decoded input before the current refill, and the start of the decoded
+    // input in the buffer, for the line, column, and snippet of an error
+    long long decodedBytes;
+    const char* window;
+    bool isWindowAtStart;
+
+public:
+    // decoder with no input
+    InputDecoder();
+
+    // start decoding the input read from the file descriptor fd, or the input in memory when fd is -1
+    void start(int fd, std::string_view input);
+
+    /*
+        Refill the buffer with decoded input, as refillBuffer()
+        @param[in,out] cursor Iterator to current position in buffer
+        @param[in,out] cursorEnd Iterator to end of the data in the buffer
+        @param[in,out] buffer Container for characters
+        @param[in] sentinelSize Size of the sentinel written after the data
+        @return Number of bytes of UTF-8 added, 0 at the end of the input, -1 for a read error
+    */
+    int refill(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer, std::size_t sentinelSize);
+
+    // Get method for the encoding of the input
+    Encoding getEncoding() const;
+
+    // Get method for bytes read from the input
+    long long getBytesRead() const;
+
+    // offset in the input of the start of decoded, UTF-8 that ends at the end of the decoded input
+    long long inputOffset(std::string_view decoded) const;
+
+private:
+    // read up to size bytes of input into data, 0 at the end, -1 for a read error
+    long readInput(char* data, std::size_t size);
+
+    // detect the encoding from the first bytes of the input in raw, removing a BOM
+    void detect();
+
+    // validate new UTF-8 in [first, last), continuing a sequence of the last block
+    void validate(const char* first, const char* last);
+
+    // transcode the UTF-16 in raw to UTF-8 at out, keeping a partial code unit or surrogate pair in raw
+    std::size_t transcode(char* out);
+
+    /*
+        Invalid input at offset in the input, a parser error
+        @param[in] message Message of the error
+        @param[in] offset Offset of the error in the input
+        @param[in] position Position of the error in the decoded input in the buffer
+        @param[in] last End of the decoded input in the buffer after the error
+    */
+    [[noreturn]] void invalid(const char* message, long long offset, const char* position, const char* last) const;
+};
+
+#endif
@@ -0,0 +1,208 @@
+/*
+    MeasureSet.cpp
+
+    Implementation file for the set of srcFacts measures counted by element name
+*/
+
+#include "MeasureSet.hpp"
+#include <algorithm>
+#include <iterator>
+
+using namespace std::literals::string_view_literals;
+
+namespace {
+
+    // element names of the built-in measures
+    constexpr std::pair<std::string_view, MeasureSet::Builtin> BUILTINS[] = {
+        { "expr"sv, MeasureSet::EXPR }, { "decl"sv, MeasureSet::DECL }, { "comment"sv, MeasureSet::COMMENT },
+        { "function"sv, MeasureSet::FUNCTION }, { "unit"sv, MeasureSet::UNIT }, { "class"sv, MeasureSet::CLASS },
+        { "return"sv, MeasureSet::RETURN }, { "literal"sv, MeasureSet::LITERAL }
+    };
+
+    // seeds tried for each table size before the table is doubled
+    constexpr int SEED_ATTEMPTS = 1024;
+
+    // whitespace around the parts of a spec
+    constexpr std::string_view SPACES = " \t\r\n"sv;
+
+    // next of a sequence of seeds, splitmix64
+    std::uint64_t nextSeed(std::uint64_t& state) {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // predicate for a valid name in a spec
+    bool isName(std::string_view name) {
+        return !name.empty() && name.find_first_of(":@="sv) == std::string_view::npos;
+    }
+}
+
+// set of the built-in measures only
+MeasureSet::MeasureSet()
+    : seed(1), shift(63), isHashed(false)
+{
+    compile();
+}
+
+// set of the built-in measures only, shared by handlers without configured measures
+const MeasureSet& MeasureSet::standard()
+{
+    static const MeasureSet measureSet;
+    return measureSet;
+}
+
+/*
+    Add a measure from its spec, and compile the table again
+    @param[in] spec Spec of the measure, [PREFIX:]NAME[@ATTRIBUTE[=VALUE]] [LABEL]
+    @return false for an invalid spec, or when there are already MAX_MEASURES
+*/
+bool MeasureSet::add(std::string_view spec)
+{
+    if (measures.size() == MAX_MEASURES)
+        return false;
+
+    // element spec, then the label after whitespace
+    const auto first = spec.find_first_not_of(SPACES);
+    if (first == std::string_view::npos)
+        return false;
+    spec.remove_prefix(first);
+    spec.remove_suffix(spec.size() - 1 - spec.find_last_not_of(SPACES));
+    const auto elementEnd = std::min(spec.find_first_of(SPACES), spec.size());
+    Measure measure;
+    measure.spec = spec.substr(0, elementEnd);
+    const auto labelStart = spec.find_first_not_of(SPACES, elementEnd);
+    measure.label = labelStart == std::string_view::npos ? measure.spec : spec.substr(labelStart);
+
+    // [PREFIX:]NAME[@ATTRIBUTE[=VALUE]]
+    std::string_view element(measure.spec);
+    const auto attributeStart = element.find('@');
+    if (attributeStart != std::string_view::npos) {
+        auto attribute = element.substr(attributeStart + 1);
+        element = element.substr(0, attributeStart);
+        const auto valueStart = attribute.find('=');
+        if (valueStart != std::string_view::npos) {
+            measure.value = attribute.substr(valueStart + 1);
+            attribute = attribute.substr(0, valueStart);
+        }
+        if (!isName(attribute))
+            return false;
+        measure.attribute = attribute;
+    }
+    const auto prefixEnd = element.find(':');
+    if (prefixEnd != std::string_view::npos) {
+        const auto prefix = element.substr(0, prefixEnd);
+        if (!prefix.empty() && !isName(prefix))
+            return false;
+        measure.prefix = prefix;
+        element.remove_prefix(prefixEnd + 1);
+    }
+    if (!isName(element))
+        return false;
+    measure.localName = element;
+
+    measures.push_back(std::move(measure));
+    compile();
+    return true;
+}
+
+// configured measures, in the order of the counters
+const std::vector<MeasureSet::Measure>& MeasureSet::getMeasures() const
+{
+    return measures;
+}
+
+/*
+    Filtered measures of an element matched by the prefix of a start tag
+    @param[in] element Element of the start tag
+    @param[in] prefix Prefix of the start tag
+    @param[out] pending Measures that also need a matching attribute
+    @return Measures to count
+*/
+std::uint32_t MeasureSet::matchPrefix(const Element& element, std::string_view prefix, std::uint32_t& pending) const
+{
+    std::uint32_t matched = 0;
+    pending = 0;
+    for (auto mask = element.filtered; mask; mask &= mask - 1) {
+        const int index = __builtin_ctz(mask);
+        const auto& measure = measures[index];
+        if (measure.prefix && *measure.prefix != prefix)
+            continue;
+        (measure.attribute ? pending : matched) |= 1U << index;
+    }
+    return matched;
+}
+
+/*
+    Pending measures matched by an attribute of their start tag
+    @param[in] pending Measures that need a matching attribute
+    @param[in] localName Local name of the attribute
+    @param[in] value Value of the attribute
+    @return Measures to count
+*/
+std::uint32_t MeasureSet::matchAttribute(std::uint32_t pending, std::string_view localName, std::string_view value) const
+{
+    std::uint32_t matched = 0;
+    for (auto mask = pending; mask; mask &= mask - 1) {
+        const int index = __builtin_ctz(mask);
+        const auto& measure = measures[index];
+        if (*measure.attribute == localName && (!measure.value || *measure.value == value))
+            matched |= 1U << index;
+    }
+    return matched;
+}
+
+/*
+    Compile the table of the built-in and configured element names. Each
+    distinct name is an element, and seeds are tried until every element
+    has its own slot, with the table doubled after SEED_ATTEMPTS seeds.
+*/
+void MeasureSet::compile()
+{
+    std::vector<Element> elements;
+    for (const auto& [localName, builtin] : BUILTINS)
+        elements.push_back({ localName, 0, builtin });
+    for (std::size_t i = 0; i < measures.size(); ++i) {
+        const auto& measure = measures[i];
+        auto element = std::find_if(elements.begin(), elements.end(), [&measure](const Element& element) {
+            return element.localName == measure.localName;
+        });
+        if (element == elements.end()) {
+            elements.push_back({ measure.localName });
+            element = std::prev(elements.end());
+        }
+        (measure.prefix || measure.attribute ? element->filtered : element->counted) |= 1U << i;
+    }
+
+    // keys of the bytes of the names, unless two names have the same key
+    isHashed = false;
+    std::vector<std::uint64_t> keys;
+    for (const auto& element : elements)
+        keys.push_back(key(element.localName));
+    std::sort(keys.begin(), keys.end());
+    isHashed = std::adjacent_find(keys.begin(), keys.end()) != keys.end();
+    for (auto& element : elements)
+        element.key = key(element.localName);
+
+    int bits = 1;
+    while ((std::size_t(1) << bits) < elements.size())
+        ++bits;
+    std::uint64_t seedState = 0;
+    for (; ; ++bits) {
+        shift = 64 - bits;
+        for (int attempt = 0; attempt < SEED_ATTEMPTS; ++attempt) {
+            seed = nextSeed(seedState) | 1;
+            table.assign(std::size_t(1) << bits, Element());
+            const bool isPerfect = std::all_of(elements.begin(), elements.end(), [this](const Element& element) {
+                auto& entry = table[slot(element.key)];
+                if (!entry.localName.empty())
+                    return false;
+                entry = element;
+                return true;
+            });
+            if (isPerfect)
+                return;
+        }
+    }
+}
@@ -0,0 +1,155 @@
+/*
+    MeasureSet.hpp
+
+    Include file for the set of srcFacts measures counted by element name
+
+    The built-in measures of the report, and the measures configured at
+    startup, are compiled into a single table of element names with a
+    perfect hash: a seed is searched for so each name has its own slot.
+    The key of a name is its first and last 4 bytes, which are all of the
+    bytes of a name of up to 8 bytes, so a lookup of such a name is a
+    multiply and a compare of the key and size, whatever the number of
+    measures, with the names only compared for longer names. When two
+    names have the same key, the table is compiled with the hash of the
+    whole name instead.
+
+    A configured measure is an element name with optional filters:
+
+        [PREFIX:]NAME[@ATTRIBUTE[=VALUE]] [LABEL]
+
+    Without a prefix, the element is counted in any namespace, with
+    PREFIX: only in the namespace of that prefix, and with an empty
+    prefix, e.g., ":if", only in the default namespace. With @ATTRIBUTE,
+    the element is only counted when it has the attribute, with the value
+    when given. The label of the report row is the rest of the spec,
+    or the element spec itself.
+*/
+
+#ifndef INCLUDED_MEASURESET_HPP
+#define INCLUDED_MEASURESET_HPP
+
+#include "FactCounters.hpp"
+#include "NameTable.hpp"
+#include <string>
+#include <string_view>
+#include <optional>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+class MeasureSet
+{
+
+public:
+    // measure of the built-in report counted for an element name
+    enum Builtin : std::uint8_t { NO_BUILTIN, EXPR, DECL, COMMENT, FUNCTION, UNIT, CLASS, RETURN, LITERAL };
+
+    // configured measure, counted in FactCounters::measures at its index
+    struct Measure {
+        std::string spec;
+        std::string label;
+        std::string localName;
+        std::optional<std::string> prefix;
+        std::optional<std::string> attribute;
+        std::optional<std::string> value;
+    };
+
+    // element name in the table, with its built-in measure and masks of its configured measures
+    struct Element {
+        std::string_view localName;
+        std::uint64_t key = 0;
+        Builtin builtin = NO_BUILTIN;
+
+        // measures counted for every start tag of the name
+        std::uint32_t counted = 0;
+
+        // measures with a prefix or attribute filter
+        std::uint32_t filtered = 0;
+    };
+
+private:
+    std::vector<Measure> measures;
+    std::vector<Element> table;
+    std::uint64_t seed;
+    int shift;
+    bool isHashed;
+
+public:
+    // set of the built-in measures only
+    MeasureSet();
+
+    // the table views the names of the measures
+    MeasureSet(const MeasureSet&) = delete;
+    MeasureSet& operator=(const MeasureSet&) = delete;
+
+    // set of the built-in measures only, shared by handlers without configured measures
+    static const MeasureSet& standard();
+
+    /*
+        Add a measure from its spec, and compile the table again
+        @param[in] spec Spec of the measure, [PREFIX:]NAME[@ATTRIBUTE[=VALUE]] [LABEL]
+        @return false for an invalid spec, or when there are already MAX_MEASURES
+    */
+    bool add(std::string_view spec);
+
+    // configured measures, in the order of the counters
+    const std::vector<Measure>& getMeasures() const;
+
+    // element of the name in the table, or nullptr for a name without measures,
+    // with the names compared only when the keys match and the key is not all of the name
+    const Element* find(std::string_view localName) const {
+        const auto nameKey = key(localName);
+        const Element& element = table[slot(nameKey)];
+        return element.key == nameKey && element.localName.size() == localName.size()
+            && ((!isHashed && localName.size() <= 8) || element.localName == localName) ? &element : nullptr;
+    }
+
+    /*
+        Filtered measures of an element matched by the prefix of a start tag
+        @param[in] element Element of the start tag
+        @param[in] prefix Prefix of the start tag
+        @param[out] pending Measures that also need a matching attribute
+        @return Measures to count
+    */
+    std::uint32_t matchPrefix(const Element& element, std::string_view prefix, std::uint32_t& pending) const;
+
+    /*
+        Pending measures matched by an attribute of their start tag
+        @param[in] pending Measures that need a matching attribute
+        @param[in] localName Local name of the attribute
+        @param[in] value Value of the attribute
+        @return Measures to count
+    */
+    std::uint32_t matchAttribute(std::uint32_t pending, std::string_view localName, std::string_view value) const;
+
+private:
+    // slot of the key of a name in the table
+    std::size_t slot(std::uint64_t nameKey) const {
+        return static_cast<std::size_t>((nameKey * seed) >> shift);
+    }
+
+    // 4 bytes of a name at p, as a single load
+    static std::uint64_t word(const char* p) {
+        std::uint32_t bytes;
+        std::memcpy(&bytes, p, sizeof(bytes));
+        return bytes;
+    }
+
+    // key of a name for the hash, its first and last 4 bytes, or for shorter
+    // names, its size and bytes, or the hash of the whole name
+    std::uint64_t key(std::string_view name) const {
+        if (isHashed)
+            return NameTable::hash(name);
+        if (name.size() >= 4)
+            return word(name.data()) | word(name.data() + name.size() - 4) << 32;
+        if (name.empty())
+            return 0;
+        const auto byte = [name](std::size_t i) { return static_cast<std::uint64_t>(static_cast<unsigned char>(name[i])); };
+        return name.size() | byte(0) << 8 | byte(name.size() / 2) << 16 | byte(name.size() - 1) << 24;
+    }
+
+    // compile the table of the built-in and configured element names
+    void compile();
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+    NameTable.cpp
+
+    Implementation file for counts by name in an open-addressing hash table
+*/
+
+#include "NameTable.hpp"
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+
+// table with room for capacity names before it grows
+NameTable::NameTable(std::size_t capacity)
+    : size(0)
+{
+    // keep at most half of the entries used, with a power of 2 entries
+    std::size_t entryCount = 16;
+    while (entryCount < capacity * 2)
+        entryCount *= 2;
+    entries.resize(entryCount);
+}
+
+// add a new name at the empty entry
+std::int64_t& NameTable::insert(std::size_t i, std::uint64_t nameHash, std::string_view name)
+{
+    if ((size + 1) * 2 > entries.size()) {
+        grow();
+        return (*this)[name];
+    }
+    entries[i] = { nameHash, names.store(name), 0 };
+    ++size;
+    return entries[i].count;
+}
+
+// number of names
+std::size_t NameTable::getSize() const
+{
+    return size;
+}
+
+// entries sorted by count, highest first, then by name
+std::vector<NameTable::Entry> NameTable::sorted() const
+{
+    std::vector<Entry> result;
+    result.reserve(size);
+    std::copy_if(entries.begin(), entries.end(), std::back_inserter(result), [] (const Entry& entry) { return entry.name.data() != nullptr; });
+    std::sort(result.begin(), result.end(), [] (const Entry& a, const Entry& b) {
+        return a.count != b.count ? a.count > b.count : a.name < b.name;
+    });
+    return result;
+}
+
+namespace {
+
+    // unaligned loads of 8 and 4 bytes
+    inline std::uint64_t load64(const char* p) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+    }
+    inline std::uint64_t load32(const char* p) {
+        std::uint32_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+    }
+
+    // mix a word into the hash
+    inline std::uint64_t mix(std::uint64_t hash, std::uint64_t word) {
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+        return hash ^ (hash >> 32);
+    }
+}
+
+// hash of a name, with overlapping loads instead of a loop over the
+// bytes, since most names are short
+std::uint64_t NameTable::hash(std::string_view name)
+{
+    const char* p = name.data();
+    const std::size_t length = name.size();
+    std::uint64_t result = length * 0x9E3779B97F4A7C15ULL;
+    if (length > 16) {
+        std::size_t i = 0;
+        for (; i + 8 < length; i += 8)
+            result = mix(result, load64(p + i));
+        return mix(result, load64(p + length - 8));
+    }
+    if (length >= 8)
+        return mix(mix(result, load64(p)), load64(p + length - 8));
+    if (length >= 4)
+        return mix(result, (load32(p) << 32) | load32(p + length - 4));
+    if (length > 0)
+        return mix(result, (static_cast<std::uint64_t>(static_cast<unsigned char>(p[0])) << 16)
+                         | (static_cast<std::uint64_t>(static_cast<unsigned char>(p[length / 2])) << 8)
+                         | static_cast<unsigned char>(p[length - 1]));
+    return result;
+}
+
+// double the number of entries
+void NameTable::grow()
+{
+    std::vector<Entry> oldEntries(entries.size() * 2);
+    oldEntries.swap(entries);
+    const std::size_t mask = entries.size() - 1;
+    for (const auto& entry : oldEntries) {
+        if (entry.name.data() == nullptr)
+            continue;
+        auto i = static_cast<std::size_t>(entry.hash) & mask;
+        while (entries[i].name.data() != nullptr)
+            i = (i + 1) & mask;
+        entries[i] = entry;
+    }
+}
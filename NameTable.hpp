@@ -0,0 +1,69 @@
+/*
+    NameTable.hpp
+
+    Include file for counts by name in an open-addressing hash table
+
+    Names are interned into an Arena the first time they are seen, and
+    entries keep the hash of their name, so a lookup is a hash, a probe
+    of adjacent entries, and a compare only on a hash match.
+*/
+
+#ifndef INCLUDED_NAMETABLE_HPP
+#define INCLUDED_NAMETABLE_HPP
+
+#include "Arena.hpp"
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+class NameTable
+{
+
+public:
+    // name with its count
+    struct Entry {
+        std::uint64_t hash;
+        std::string_view name;
+        std::int64_t count;
+    };
+
+private:
+    std::vector<Entry> entries;
+    std::size_t size;
+    Arena names;
+
+public:
+    // table with room for capacity names before it grows
+    NameTable(std::size_t capacity = 64);
+
+    // count of the name, added with a count of 0 when new
+    std::int64_t& operator[](std::string_view name) {
+        const auto nameHash = hash(name);
+        const std::size_t mask = entries.size() - 1;
+        for (auto i = static_cast<std::size_t>(nameHash) & mask; ; i = (i + 1) & mask) {
+            auto& entry = entries[i];
+            if (entry.hash == nameHash && entry.name == name)
+                return entry.count;
+            if (entry.name.data() == nullptr)
+                return insert(i, nameHash, name);
+        }
+    }
+
+    // number of names
+    std::size_t getSize() const;
+
+    // entries sorted by count, highest first, then by name
+    std::vector<Entry> sorted() const;
+
+    // hash of a name
+    static std::uint64_t hash(std::string_view name);
+
+private:
+    // add a new name at the empty entry
+    std::int64_t& insert(std::size_t i, std::uint64_t nameHash, std::string_view name);
+
+    // double the number of entries
+    void grow();
+};
+
+#endif
@@ -0,0 +1,198 @@
+/*
+    OutputWriter.cpp
+
+    Implementation file for buffered output with XML escaping
+*/
+
+#include "OutputWriter.hpp"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <errno.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+#if defined(__AVX2__)
+    constexpr std::size_t BLOCK_SIZE = 32;
+
+    // bit mask of the special characters in the block at data
+    inline unsigned int specialMask(const char* data, bool isAttribute) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('<')),
+                                                          _mm256_cmpeq_epi8(block, _mm256_set1_epi8('>'))),
+                                          _mm256_cmpeq_epi8(block, _mm256_set1_epi8('&')));
+        if (isAttribute)
+            special = _mm256_or_si256(special, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"')));
+        return static_cast<unsigned int>(_mm256_movemask_epi8(special));
+    }
+#elif defined(__SSE2__)
+    constexpr std::size_t BLOCK_SIZE = 16;
+
+    // bit mask of the special characters in the block at data
+    inline unsigned int specialMask(const char* data, bool isAttribute) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('<')),
+                                                    _mm_cmpeq_epi8(block, _mm_set1_epi8('>'))),
+                                       _mm_cmpeq_epi8(block, _mm_set1_epi8('&')));
+        if (isAttribute)
+            special = _mm_or_si128(special, _mm_cmpeq_epi8(block, _mm_set1_epi8('"')));
+        return static_cast<unsigned int>(_mm_movemask_epi8(special));
+    }
+#else
+    constexpr std::size_t BLOCK_SIZE = 16;
+
+    // bit mask of the special characters in the block at data
+    inline unsigned int specialMask(const char* data, bool isAttribute) {
+        unsigned int mask = 0;
+        for (std::size_t i = 0; i < BLOCK_SIZE; ++i) {
+            const char c = data[i];
+            if (c == '<' || c == '>' || c == '&' || (isAttribute && c == '"'))
+                mask |= 1U << i;
+        }
+        return mask;
+    }
+#endif
+
+    // longest escape of a single character
+    constexpr std::size_t MAX_ESCAPE_SIZE = 6;
+
+    // escaped form of a special character, or empty for other characters
+    inline std::string_view escapeOf(char c, bool isAttribute) {
+        switch (c) {
+        case '<': return "&lt;";
+        case '>': return "&gt;";
+        case '&': return "&amp;";
+        case '"': return isAttribute ? "&quot;" : "";
+        default:  return "";
+        }
+    }
+}
+
+// writer to the file descriptor fd with a buffer of bufferSize bytes
+OutputWriter::OutputWriter(int fd, std::size_t bufferSize)
+    : fd(fd), used(0), bytesWritten(0)
+{
+    buffer.resize(std::max(bufferSize, BLOCK_SIZE * MAX_ESCAPE_SIZE));
+}
+
+// flush any buffered output
+OutputWriter::~OutputWriter()
+{
+    flush();
+}
+
+// write characters as is
+void OutputWriter::write(std::string_view characters)
+{
+    if (characters.size() > buffer.size() - used) {
+        flush();
+
+        // large writes go directly to the file descriptor
+        if (characters.size() >= buffer.size()) {
+            writeAll(characters.data(), characters.size());
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, characters.data(), characters.size());
+    used += characters.size();
+}
+
+// write a single character as is
+void OutputWriter::write(char c)
+{
+    if (used == buffer.size())
+        flush();
+    buffer[used++] = c;
+}
+
+// write text, escaping '<', '>', and '&'
+void OutputWriter::writeEscaped(std::string_view text)
+{
+    escape(text, false);
+}
+
+// write an attribute value, escaping '<', '>', '&', and '"'
+void OutputWriter::writeEscapedAttribute(std::string_view value)
+{
+    escape(value, true);
+}
+
+// write characters escaping '<', '>', '&', and when isAttribute '"'
+void OutputWriter::escape(std::string_view characters, bool isAttribute)
+{
+    const char* current = characters.data();
+    const char* const last = current + characters.size();
+
+    // whole blocks, copied as is unless they contain a special character
+    for (; static_cast<std::size_t>(last - current) >= BLOCK_SIZE; current += BLOCK_SIZE) {
+        if (buffer.size() - used < BLOCK_SIZE * MAX_ESCAPE_SIZE)
+            flush();
+        unsigned int mask = specialMask(current, isAttribute);
+        if (!mask) {
+            std::memcpy(buffer.data() + used, current, BLOCK_SIZE);
+            used += BLOCK_SIZE;
+            continue;
+        }
+        std::size_t copied = 0;
+        while (mask) {
+            const std::size_t offset = __builtin_ctz(mask);
+            std::memcpy(buffer.data() + used, current + copied, offset - copied);
+            used += offset - copied;
+            const auto escaped = escapeOf(current[offset], isAttribute);
+            std::memcpy(buffer.data() + used, escaped.data(), escaped.size());
+            used += escaped.size();
+            copied = offset + 1;
+            mask &= mask - 1;
+        }
+        std::memcpy(buffer.data() + used, current + copied, BLOCK_SIZE - copied);
+        used += BLOCK_SIZE - copied;
+    }
+
+    // remaining characters
+    if (buffer.size() - used < BLOCK_SIZE * MAX_ESCAPE_SIZE)
+        flush();
+    for (; current != last; ++current) {
+        const auto escaped = escapeOf(*current, isAttribute);
+        if (escaped.empty()) {
+            buffer[used++] = *current;
+        } else {
+            std::memcpy(buffer.data() + used, escaped.data(), escaped.size());
+            used += escaped.size();
+        }
+    }
+}
+
+// write the buffered output
+void OutputWriter::flush()
+{
+    writeAll(buffer.data(), used);
+    used = 0;
+}
+
+// Get method for bytes written, including buffered output
+long long OutputWriter::getBytesWritten() const
+{
+    return bytesWritten + static_cast<long long>(used);
+}
+
+// write [data, data + size) to the file descriptor
+void OutputWriter::writeAll(const char* data, std::size_t size)
+{
+    while (size) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written == -1) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "output error : File output error\n";
+            exit(1);
+        }
+        data += written;
+        size -= written;
+        bytesWritten += written;
+    }
+}
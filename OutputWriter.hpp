@@ -0,0 +1,62 @@
+/*
+    OutputWriter.hpp
+
+    Include file for buffered output with XML escaping
+
+    Output is collected in a large buffer and written with write(2)
+    when the buffer is full. Escaping compares whole 16/32-byte blocks
+    at once, and blocks without special characters are copied as is.
+*/
+
+#ifndef INCLUDED_OUTPUTWRITER_HPP
+#define INCLUDED_OUTPUTWRITER_HPP
+
+#include <string>
+#include <string_view>
+
+class OutputWriter
+{
+
+private:
+    int fd;
+    std::string buffer;
+    std::size_t used;
+    long long bytesWritten;
+
+public:
+    // writer to the file descriptor fd with a buffer of bufferSize bytes
+    OutputWriter(int fd, std::size_t bufferSize = 1024 * 1024);
+
+    // flush any buffered output
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    // write characters as is
+    void write(std::string_view characters);
+
+    // write a single character as is
+    void write(char c);
+
+    // write text, escaping '<', '>', and '&'
+    void writeEscaped(std::string_view text);
+
+    // write an attribute value, escaping '<', '>', '&', and '"'
+    void writeEscapedAttribute(std::string_view value);
+
+    // write the buffered output
+    void flush();
+
+    // Get method for bytes written, including buffered output
+    long long getBytesWritten() const;
+
+private:
+    // write characters escaping '<', '>', '&', and when isAttribute '"'
+    void escape(std::string_view characters, bool isAttribute);
+
+    // write [data, data + size) to the file descriptor
+    void writeAll(const char* data, std::size_t size);
+};
+
+#endif
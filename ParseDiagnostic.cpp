@@ -0,0 +1,110 @@
+/*
+    ParseDiagnostic.cpp
+
+    Implementation file for the diagnostic of a parse error, with its position
+*/
+
+#include "ParseDiagnostic.hpp"
+#include <algorithm>
+#include <vector>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+    // characters of the snippet before and after the error, at most
+    constexpr std::size_t SNIPPET_BEFORE = 60;
+    constexpr std::size_t SNIPPET_AFTER = 20;
+}
+
+/*
+    Line and column of the error from the text before it
+    @param[in,out] diagnostic Diagnostic with the offset of the error
+    @param[in] before Text before the error
+    @param[in] isInputStart Whether the text starts at the start of the input,
+               so the line is known, and not only a column from a newline in it
+*/
+void locate(ParseDiagnostic& diagnostic, std::string_view before, bool isInputStart) {
+
+    const auto lastNewline = before.rfind('\n');
+    if (lastNewline != std::string_view::npos)
+        diagnostic.column = before.size() - lastNewline;
+    else if (isInputStart)
+        diagnostic.column = before.size() + 1;
+    if (isInputStart)
+        diagnostic.line = std::count(before.begin(), before.end(), '\n') + 1;
+}
+
+/*
+    Line and column of the error by rereading the input file up to it
+    @param[in,out] diagnostic Diagnostic with the offset of the error
+    @param[in] fd File descriptor of the input
+    @return false when the input is not a regular file, and is not reread
+*/
+bool locateInFile(ParseDiagnostic& diagnostic, int fd) {
+
+    struct stat status;
+    if (fstat(fd, &status) == -1 || !S_ISREG(status.st_mode))
+        return false;
+
+    // count newlines a block at a time, with the offset of the last one
+    std::vector<char> block(1024 * 1024);
+    long long newlines = 0;
+    long long lineStart = 0;
+    long long offset = 0;
+    while (offset < diagnostic.offset) {
+        const auto size = static_cast<std::size_t>(std::min<long long>(block.size(), diagnostic.offset - offset));
+        ssize_t bytes;
+        while ((bytes = pread(fd, block.data(), size, offset)) == -1 && errno == EINTR)
+            ;
+        if (bytes <= 0)
+            return false;
+        for (auto p = block.data(); (p = std::find(p, block.data() + bytes, '\n')) != block.data() + bytes; ++p) {
+            ++newlines;
+            lineStart = offset + (p - block.data()) + 1;
+        }
+        offset += bytes;
+    }
+    diagnostic.line = newlines + 1;
+    diagnostic.column = diagnostic.offset - lineStart + 1;
+    return true;
+}
+
+/*
+    Snippet of the line of the error, limited to a window around it
+    @param[in,out] diagnostic Diagnostic of the error
+    @param[in] first Start of the text available before the error
+    @param[in] position Position of the error
+    @param[in] last End of the text available after the error
+*/
+void setSnippet(ParseDiagnostic& diagnostic, const char* first, const char* position, const char* last) {
+
+    const char* start = position;
+    while (start != first && start[-1] != '\n' && static_cast<std::size_t>(position - start) < SNIPPET_BEFORE)
+        --start;
+    const char* end = std::find(position, std::min(last, position + SNIPPET_AFTER), '\n');
+
+    // control characters, e.g., tabs, are shown as spaces to keep the caret under the error
+    diagnostic.snippet.assign(start, end);
+    std::replace_if(diagnostic.snippet.begin(), diagnostic.snippet.end(), [](char c) {
+        return static_cast<unsigned char>(c) < ' ';
+    }, ' ');
+    diagnostic.snippetPosition = position - start;
+}
+
+// write the diagnostic, the message, its position, and the snippet with a caret under the error
+void writeDiagnostic(std::ostream& out, const ParseDiagnostic& diagnostic) {
+
+    out << "parser error : " << diagnostic.message << '\n';
+    out << "    at byte offset " << diagnostic.offset;
+    if (diagnostic.line)
+        out << ", line " << diagnostic.line;
+    if (diagnostic.column)
+        out << ", column " << diagnostic.column;
+    out << '\n';
+    if (!diagnostic.snippet.empty() || diagnostic.snippetPosition) {
+        out << "    | " << diagnostic.snippet << '\n';
+        out << "    | " << std::string(diagnostic.snippetPosition, ' ') << "^\n";
+    }
+}
@@ -0,0 +1,66 @@
+/*
+    ParseDiagnostic.hpp
+
+    Include file for the diagnostic of a parse error, with its position
+
+    The parser only tracks the byte offset of the input, from the bytes
+    read and the position in the buffer, so there is no cost to parsing.
+    The line and column of an error are found only when it happens, by
+    counting the newlines before it in the input in memory, or in the
+    buffer when it still holds the start of the input, or by rereading
+    the file when it is seekable. For a pipe, only the column is known,
+    and only when the start of the line is still in the buffer.
+*/
+
+#ifndef INCLUDED_PARSEDIAGNOSTIC_HPP
+#define INCLUDED_PARSEDIAGNOSTIC_HPP
+
+#include <string>
+#include <string_view>
+#include <ostream>
+
+struct ParseDiagnostic {
+    std::string message;
+
+    // byte offset in the input of the error
+    long long offset = 0;
+
+    // line and column of the error, from 1, or 0 when not known
+    long long line = 0;
+    long long column = 0;
+
+    // text of the line around the error, and the position of the error in it
+    std::string snippet;
+    std::size_t snippetPosition = 0;
+};
+
+/*
+    Line and column of the error from the text before it
+    @param[in,out] diagnostic Diagnostic with the offset of the error
+    @param[in] before Text before the error
+    @param[in] isInputStart Whether the text starts at the start of the input,
+               so the line is known, and not only a column from a newline in it
+*/
+void locate(ParseDiagnostic& diagnostic, std::string_view before, bool isInputStart);
+
+/*
+    Line and column of the error by rereading the input file up to it
+    @param[in,out] diagnostic Diagnostic with the offset of the error
+    @param[in] fd File descriptor of the input
+    @return false when the input is not a regular file, and is not reread
+*/
+bool locateInFile(ParseDiagnostic& diagnostic, int fd);
+
+/*
+    Snippet of the line of the error, limited to a window around it
+    @param[in,out] diagnostic Diagnostic of the error
+    @param[in] first Start of the text available before the error
+    @param[in] position Position of the error
+    @param[in] last End of the text available after the error
+*/
+void setSnippet(ParseDiagnostic& diagnostic, const char* first, const char* position, const char* last);
+
+// write the diagnostic, the message, its position, and the snippet with a caret under the error
+void writeDiagnostic(std::ostream& out, const ParseDiagnostic& diagnostic);
+
+#endif
@@ -0,0 +1,49 @@
+/*
+    PassthroughWriter.cpp
+
+    Implementation file for a writer that copies parsed input to the output
+    directly from the parser buffer
+*/
+
+#include "PassthroughWriter.hpp"
+#include <iostream>
+#include <errno.h>
+#include <unistd.h>
+
+// writer to the file descriptor fd
+PassthroughWriter::PassthroughWriter(int fd)
+    : fd(fd), pendingBegin(nullptr), bytesWritten(0)
+{
+}
+
+// write the parsed part of the buffer, up to the end of parsed,
+// before the parser refills the buffer
+void PassthroughWriter::release(std::string_view parsed)
+{
+    // the first release is for the empty buffer
+    if (pendingBegin == nullptr)
+        pendingBegin = parsed.data();
+
+    // write from the end of the last release, continuing after partial writes
+    const char* const parsedEnd = parsed.data() + parsed.size();
+    while (pendingBegin != parsedEnd) {
+        const ssize_t written = write(fd, pendingBegin, parsedEnd - pendingBegin);
+        if (written == -1) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "passthrough error : File output error\n";
+            exit(1);
+        }
+        bytesWritten += written;
+        pendingBegin += written;
+    }
+
+    // unparsed characters are moved to the start of the buffer
+    pendingBegin = parsed.data();
+}
+
+// Get method for bytes written
+long long PassthroughWriter::getBytesWritten() const
+{
+    return bytesWritten;
+}
@@ -0,0 +1,38 @@
+/*
+    PassthroughWriter.hpp
+
+    Include file for a writer that copies parsed input to the output
+    directly from the parser buffer
+
+    Input is never copied into the writer. Passthrough is copy-only:
+    the parsed part of the parser buffer is written as is when the parser
+    releases the buffer before a refill, and output that differs from
+    the input is rebuilt from the events with OutputWriter instead.
+*/
+
+#ifndef INCLUDED_PASSTHROUGHWRITER_HPP
+#define INCLUDED_PASSTHROUGHWRITER_HPP
+
+#include <string_view>
+
+class PassthroughWriter
+{
+
+private:
+    int fd;
+    const char* pendingBegin;
+    long long bytesWritten;
+
+public:
+    // writer to the file descriptor fd
+    PassthroughWriter(int fd);
+
+    // write the parsed part of the buffer, up to the end of parsed,
+    // before the parser refills the buffer
+    void release(std::string_view parsed);
+
+    // Get method for bytes written
+    long long getBytesWritten() const;
+};
+
+#endif
@@ -0,0 +1,446 @@
+/*
+    PipelineHandler.hpp
+
+    Include file for a handler that runs other handlers on consumer threads
+
+    The PipelineHandler is the only handler of the parser. It writes a
+    compact EventRecord of each event into an EventRing for each of its
+    handlers, and a consumer thread for each handler replays the records
+    to it, so the parse and the handlers run concurrently. A record is
+    only written for the events a handler defines a member function for.
+
+    Records view the parser buffer, so at each buffer release the parser
+    thread waits until every consumer has replayed the release, i.e.,
+    the buffer stays pinned until the consumers are done with it. A name
+    that is not in the buffer, e.g., the end tag name of an empty element,
+    which is a member of the parser, is copied into an arena of the stage,
+    which is reset at the same point.
+
+    A handler on a consumer thread is attached to the PipelineStage that
+    replays to it, which has the source and offset of the current event.
+*/
+
+#ifndef INCLUDED_PIPELINEHANDLER_HPP
+#define INCLUDED_PIPELINEHANDLER_HPP
+
+#include "CompositeHandler.hpp"
+#include "EventContext.hpp"
+#include "EventRing.hpp"
+#include "Arena.hpp"
+#include <ostream>
+#include <iomanip>
+#include <thread>
+#include <tuple>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+// consumer thread that replays the records of its ring to a single handler
+template <typename Handler>
+class PipelineStage : public EventContext
+{
+
+private:
+    Handler& handler;
+    EventRing ring;
+    std::thread thread;
+
+    // context of the event being replayed
+    std::string_view source;
+    long long offset;
+    long long totalBytes;
+
+    // values retained by the handler, on the consumer thread
+    mutable Arena unitArena;
+    mutable Arena documentArena;
+
+    // copies of names of records not in the parser buffer, on the parser thread
+    Arena copies;
+
+public:
+    // stage with a ring of ringSize records, attached to the handler
+    PipelineStage(Handler& handler, std::size_t ringSize)
+        : handler(handler), ring(ringSize), offset(0), totalBytes(0)
+    {
+        HandlerCall::dispatchTo(HandlerCall::ATTACH, handler, static_cast<const EventContext&>(*this));
+    }
+
+    // predicate for a handler member function for the call
+    template <typename Call, typename... Args>
+    static constexpr bool isHandled() {
+        return HandlerCall::isHandledBy<Call, Handler, Args...>();
+    }
+
+    // predicate for a handler that uses the context of events
+    static constexpr bool isContextUsed() {
+        return isHandled<decltype(HandlerCall::ATTACH), const EventContext&>();
+    }
+
+    // ring written by the parser thread
+    EventRing& getRing() {
+        return ring;
+    }
+
+    const EventRing& getRing() const {
+        return ring;
+    }
+
+    // copies of the names of records, reset by the parser thread once the ring is empty
+    Arena& getCopies() {
+        return copies;
+    }
+
+    // start the consumer thread
+    void start() {
+        thread = std::thread([this]() { run(); });
+    }
+
+    // wait for the consumer thread to replay the end of the document
+    void join() {
+        thread.join();
+    }
+
+    // raw source of the current event, valid only during its handler
+    std::string_view getEventSource() const override {
+        return source;
+    }
+
+    // offset in the input of the start of the current event
+    long long getEventOffset() const override {
+        return offset;
+    }
+
+    // Get method for total bytes, as of the last buffer release
+    long long getTotalBytes() const override {
+        return totalBytes;
+    }
+
+    // copy of a value of an event that stays valid for the lifetime, since
+    // the record views the parser buffer only until the buffer release
+    std::string_view retain(std::string_view value, Lifetime lifetime) const override {
+        return (lifetime == UNIT ? unitArena : documentArena).store(value);
+    }
+
+private:
+    // replay records until the end of the document
+    void run() {
+        while (true) {
+            const auto count = ring.waitRecords();
+            for (std::uint64_t i = 0; i < count; ++i) {
+                if (!replay(ring.record(i))) {
+                    ring.release(i + 1);
+                    return;
+                }
+            }
+            ring.release(count);
+        }
+    }
+
+    /*
+        Call the handler member function of a record
+        @param[in] record Record of the event
+        @return false for the end of the document
+    */
+    bool replay(const EventRecord& record) {
+        using namespace HandlerCall;
+        const std::string_view name(record.name, record.nameSize);
+        const std::string_view value(record.value, record.valueSize);
+        source = std::string_view(record.source, record.sourceSize);
+        offset = record.offset;
+        switch (record.kind) {
+        case EventRecord::START_DOCUMENT:
+            unitArena.reset();
+            documentArena.reset();
+            dispatchTo(START_DOCUMENT, handler, record.depth);
+            break;
+        case EventRecord::START_TAG:
+            if (record.depth == 1)
+                unitArena.reset();
+            dispatchTo(START_TAG, handler, record.depth, name, prefix(record, name), localName(record, name));
+            break;
+        case EventRecord::ATTRIBUTE:
+            dispatchTo(ATTRIBUTE, handler, record.depth, name, prefix(record, name), localName(record, name), value);
+            break;
+        case EventRecord::CHARACTERS:
+            dispatchTo(CHARACTERS, handler, record.depth, value, record.newlines);
+            break;
+        case EventRecord::CDATA:
+            dispatchTo(CDATA, handler, record.depth, value, record.newlines);
+            break;
+        case EventRecord::CHAR_ENTITY_REF:
+            dispatchTo(CHAR_ENTITY_REF, handler, record.depth, value);
+            break;
+        case EventRecord::NAMESPACE:
+            dispatchTo(NAMESPACE, handler, record.depth, name, value);
+            break;
+        case EventRecord::COMMENT:
+            dispatchTo(COMMENT, handler, record.depth, value);
+            break;
+        case EventRecord::DECLARATION: {
+            const auto encoding = record.flags & EventRecord::HAS_ENCODING ? std::optional<std::string_view>(name) : std::nullopt;
+            const auto standalone = record.flags & EventRecord::HAS_STANDALONE ? std::optional<std::string_view>(source) : std::nullopt;
+            dispatchTo(DECLARATION, handler, record.depth, value, encoding, standalone);
+            break;
+        }
+        case EventRecord::PI:
+            dispatchTo(PI, handler, record.depth, name, value);
+            break;
+        case EventRecord::END_TAG:
+            dispatchTo(END_TAG, handler, record.depth, prefix(record, name), name, localName(record, name));
+            break;
+        case EventRecord::BUFFER_RELEASE:
+            totalBytes = record.offset;
+            dispatchTo(BUFFER_RELEASE, handler, value);
+            break;
+        case EventRecord::END_DOCUMENT:
+            totalBytes = record.offset;
+            dispatchTo(END_DOCUMENT, handler, record.depth);
+            return false;
+        }
+        return true;
+    }
+
+    // prefix of a qName
+    static std::string_view prefix(const EventRecord& record, std::string_view qName) {
+        return qName.substr(0, record.prefixSize);
+    }
+
+    // local name of a qName, after the prefix and its ':'
+    static std::string_view localName(const EventRecord& record, std::string_view qName) {
+        return record.prefixSize ? qName.substr(record.prefixSize + 1) : qName;
+    }
+};
+
+template <typename... Handlers>
+class PipelineHandler
+{
+
+private:
+    std::tuple<std::unique_ptr<PipelineStage<Handlers>>...> stages;
+    const EventContext* context;
+    long long bufferReleases;
+    long long pinnedWaits;
+
+    // predicate for a handler that uses the context of events
+    static constexpr bool isContextUsed() {
+        return (PipelineStage<Handlers>::isContextUsed() || ...);
+    }
+
+    /*
+        Write a record to the ring of each handler with the member function for the call
+        @param[in] call Call of the handler member function
+        @param[in] kind Kind of the event
+        @param[in] depth Depth of the event
+        @param[in] fill Sets the parameters of the event in a record, with the copies of the stage when it takes them
+        @param[in] args Parameters of the handler member function
+    */
+    template <typename Call, typename Fill, typename... Args>
+    void push(const Call&, EventRecord::Kind kind, int depth, Fill fill, const Args&... args) {
+        std::string_view source;
+        long long offset = 0;
+        if constexpr (isContextUsed()) {
+            source = context->getEventSource();
+            offset = context->getEventOffset();
+        }
+        std::apply([&](auto&... stage) {
+            ([&](auto& stage) {
+                using Stage = std::remove_reference_t<decltype(*stage)>;
+                if constexpr (Stage::template isHandled<Call, const Args&...>()) {
+                    auto& record = stage->getRing().claim();
+                    record.kind = kind;
+                    record.depth = depth;
+                    record.source = source.data();
+                    record.sourceSize = static_cast<std::uint32_t>(source.size());
+                    record.offset = offset;
+                    if constexpr (std::is_invocable_v<Fill, EventRecord&, Arena&>)
+                        fill(record, stage->getCopies());
+                    else
+                        fill(record);
+                    stage->getRing().publish();
+                }
+            }(stage), ...);
+        }, stages);
+    }
+
+    /*
+        Write a record of the start or end of the document, or of a buffer
+        release, to the ring of every handler
+        @param[in] kind Kind of the event
+        @param[in] depth Depth of the event
+        @param[in] parsed Parsed part of the buffer of a buffer release
+    */
+    void pushControl(EventRecord::Kind kind, int depth, std::string_view parsed = std::string_view()) {
+        const long long totalBytes = kind == EventRecord::START_DOCUMENT ? 0 : context->getTotalBytes();
+        std::apply([&](auto&... stage) {
+            ([&](auto& stage) {
+                auto& record = stage->getRing().claim();
+                record.kind = kind;
+                record.depth = depth;
+                record.source = nullptr;
+                record.sourceSize = 0;
+                record.offset = totalBytes;
+                setView(record.value, record.valueSize, parsed);
+                stage->getRing().publish();
+            }(stage), ...);
+        }, stages);
+    }
+
+    // set a view of a record
+    static void setView(const char*& data, std::uint32_t& size, std::string_view view) {
+        data = view.data();
+        size = static_cast<std::uint32_t>(view.size());
+    }
+
+public:
+    // pipeline with a consumer thread and a ring of ringSize records for each handler
+    PipelineHandler(std::size_t ringSize, Handlers&... handlers)
+        : stages(std::make_unique<PipelineStage<Handlers>>(handlers, ringSize)...), context(nullptr), bufferReleases(0), pinnedWaits(0)
+    {}
+
+    PipelineHandler(const PipelineHandler&) = delete;
+    PipelineHandler& operator=(const PipelineHandler&) = delete;
+
+    // context of the parser, for the source and offset of events
+    void attach(const EventContext& context) {
+        this->context = &context;
+    }
+
+    // start the consumer threads and the document
+    void startDocument(int depth) {
+        std::apply([](auto&... stage) { (stage->start(), ...); }, stages);
+        pushControl(EventRecord::START_DOCUMENT, depth);
+    }
+
+    // write a start tag record
+    void startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName) {
+        push(HandlerCall::START_TAG, EventRecord::START_TAG, depth, [&](EventRecord& record) {
+            setView(record.name, record.nameSize, qName);
+            record.prefixSize = static_cast<std::uint32_t>(prefix.size());
+        }, depth, qName, prefix, localName);
+    }
+
+    // write an attribute record
+    void attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value) {
+        push(HandlerCall::ATTRIBUTE, EventRecord::ATTRIBUTE, depth, [&](EventRecord& record) {
+            setView(record.name, record.nameSize, qName);
+            record.prefixSize = static_cast<std::uint32_t>(prefix.size());
+            setView(record.value, record.valueSize, value);
+        }, depth, qName, prefix, localName, value);
+    }
+
+    // write a text record
+    void characters(int depth, std::string_view characters, int newlines) {
+        push(HandlerCall::CHARACTERS, EventRecord::CHARACTERS, depth, [&](EventRecord& record) {
+            setView(record.value, record.valueSize, characters);
+            record.newlines = newlines;
+        }, depth, characters, newlines);
+    }
+
+    // write a CDATA record
+    void cdata(int depth, std::string_view characters, int newlines) {
+        push(HandlerCall::CDATA, EventRecord::CDATA, depth, [&](EventRecord& record) {
+            setView(record.value, record.valueSize, characters);
+            record.newlines = newlines;
+        }, depth, characters, newlines);
+    }
+
+    // write a character entity reference record
+    void charEntityRef(int depth, std::string_view characters) {
+        push(HandlerCall::CHAR_ENTITY_REF, EventRecord::CHAR_ENTITY_REF, depth, [&](EventRecord& record) {
+            setView(record.value, record.valueSize, characters);
+        }, depth, characters);
+    }
+
+    // write a namespace declaration record
+    void namespaceDeclaration(int depth, std::string_view prefix, std::string_view uri) {
+        push(HandlerCall::NAMESPACE, EventRecord::NAMESPACE, depth, [&](EventRecord& record) {
+            setView(record.name, record.nameSize, prefix);
+            setView(record.value, record.valueSize, uri);
+        }, depth, prefix, uri);
+    }
+
+    // write an XML comment record
+    void comment(int depth, std::string_view comment) {
+        push(HandlerCall::COMMENT, EventRecord::COMMENT, depth, [&](EventRecord& record) {
+            setView(record.value, record.valueSize, comment);
+        }, depth, comment);
+    }
+
+    // write an XML declaration record, with the standalone in place of the source
+    void declaration(int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone) {
+        push(HandlerCall::DECLARATION, EventRecord::DECLARATION, depth, [&](EventRecord& record) {
+            setView(record.value, record.valueSize, version);
+            record.flags = 0;
+            if (encoding) {
+                setView(record.name, record.nameSize, *encoding);
+                record.flags |= EventRecord::HAS_ENCODING;
+            }
+            if (standalone) {
+                setView(record.source, record.sourceSize, *standalone);
+                record.flags |= EventRecord::HAS_STANDALONE;
+            }
+        }, depth, version, encoding, standalone);
+    }
+
+    // write a processing instruction record
+    void processingInstruction(int depth, std::string_view target, std::string_view data) {
+        push(HandlerCall::PI, EventRecord::PI, depth, [&](EventRecord& record) {
+            setView(record.name, record.nameSize, target);
+            setView(record.value, record.valueSize, data);
+        }, depth, target, data);
+    }
+
+    // write an end tag record, with a copy of the name of an empty element,
+    // since the parser may change it before the record is replayed
+    void endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName) {
+        const auto source = context->getEventSource();
+        const bool isInSource = qName.data() >= source.data() && qName.data() + qName.size() <= source.data() + source.size();
+        push(HandlerCall::END_TAG, EventRecord::END_TAG, depth, [&](EventRecord& record, Arena& copies) {
+            setView(record.name, record.nameSize, isInSource ? qName : copies.store(qName));
+            record.prefixSize = static_cast<std::uint32_t>(prefix.size());
+        }, depth, prefix, qName, localName);
+    }
+
+    // write a buffer release record, and keep the buffer pinned until every consumer replays it,
+    // after which the copies of names are no longer viewed
+    void bufferRelease(std::string_view parsed) {
+        pushControl(EventRecord::BUFFER_RELEASE, 0, parsed);
+        ++bufferReleases;
+        bool isWaiting = false;
+        std::apply([&isWaiting](auto&... stage) { ((isWaiting |= stage->getRing().waitEmpty()), ...); }, stages);
+        std::apply([](auto&... stage) { (stage->getCopies().reset(), ...); }, stages);
+        if (isWaiting)
+            ++pinnedWaits;
+    }
+
+    // write the end of the document, and wait for the consumer threads to replay it
+    void endDocument(int depth) {
+        pushControl(EventRecord::END_DOCUMENT, depth);
+        std::apply([](auto&... stage) { (stage->join(), ...); }, stages);
+    }
+
+    // output the ring statistics of each handler as a markdown table, to size the rings
+    void writeStatistics(std::ostream& out) const {
+
+        out << "| Stage | Records | Ring size | Mean occupancy | Max occupancy | Full waits | Empty waits | Occupancy by eighths |\n";
+        out << "|--:|--:|--:|--:|--:|--:|--:|:--|\n";
+        int number = 0;
+        std::apply([&](const auto&... stage) {
+            ([&](const auto& stage) {
+                const auto statistics = stage->getRing().getStatistics();
+                const auto capacity = stage->getRing().getCapacity();
+                const double mean = statistics.occupancySamples ? static_cast<double>(statistics.occupancyTotal) / statistics.occupancySamples : 0;
+                out << "| " << ++number << " | " << statistics.records << " | " << capacity << " | " << std::fixed << std::setprecision(1)
+                    << 100 * mean / capacity << "% | " << 100.0 * statistics.maxOccupancy / capacity << "% | "
+                    << statistics.fullWaits << " | " << statistics.emptyWaits << " |";
+                for (const auto count : statistics.occupancyCounts)
+                    out << ' ' << (statistics.occupancySamples ? 100 * count / statistics.occupancySamples : 0) << '%';
+                out << " |\n";
+            }(stage), ...);
+        }, stages);
+        out << bufferReleases << " buffer releases, " << pinnedWaits << " waited for the consumers\n";
+    }
+};
+
+#endif
@@ -0,0 +1,107 @@
+/*
+    ProgressReporter.cpp
+
+    Implementation file for the progress of a pass over the input,
+    reported on stderr and in a metrics file
+*/
+
+#include "ProgressReporter.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+
+/*
+    Report the progress at each interval until stopped
+    @param[in] inputSize Size of the input, 0 when unknown
+    @param[in] intervalSeconds Seconds between reports
+    @param[in] isProgress Report a line of the progress on stderr
+    @param[in] metricsPath Path of the metrics file, none when empty
+    @param[in] metricsPrefix Prefix of the names of the metrics
+*/
+ProgressReporter::ProgressReporter(long long inputSize, double intervalSeconds, bool isProgress,
+                                   const std::string& metricsPath, const std::string& metricsPrefix)
+    : bytesRead(0), refills(0), inputSize(inputSize), interval(intervalSeconds), isProgress(isProgress),
+      metricsPath(metricsPath), metricsPrefix(metricsPrefix), start(std::chrono::steady_clock::now()),
+      isStopping(false)
+{
+    reporter = std::thread(&ProgressReporter::report, this);
+}
+
+// stop the reports
+ProgressReporter::~ProgressReporter()
+{
+    stop();
+}
+
+// stop the reports, with a final metrics file of the finished pass
+void ProgressReporter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (isStopping)
+            return;
+        isStopping = true;
+    }
+    stopped.notify_all();
+    reporter.join();
+    if (!metricsPath.empty()) {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        writeMetrics(bytesRead.load(), elapsed.count(), true);
+    }
+}
+
+// reporter loop
+void ProgressReporter::report()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    while (!stopped.wait_for(lock, interval, [this]() { return isStopping; })) {
+        const long long bytes = bytesRead.load(std::memory_order_relaxed);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const double seconds = elapsed.count();
+        const double bytesPerSecond = seconds > 0 ? bytes / seconds : 0;
+
+        // a whole line at once, so it is not interleaved with other output
+        if (isProgress) {
+            std::ostringstream line;
+            line << std::fixed << std::setprecision(1) << "Progress: " << bytes / 1000000.0 << " MB";
+            if (inputSize)
+                line << " of " << inputSize / 1000000.0 << " MB";
+            line << ", " << bytesPerSecond / 1000000 << " MB/sec";
+            if (inputSize && bytesPerSecond > 0) {
+                const long long left = static_cast<long long>(std::max(0LL, inputSize - bytes) / bytesPerSecond);
+                line << ", " << 100.0 * bytes / inputSize << "%, "
+                     << left / 3600 << ':' << std::setfill('0') << std::setw(2) << left / 60 % 60
+                     << ':' << std::setw(2) << left % 60 << " left";
+            }
+            line << '\n';
+            std::clog << line.str() << std::flush;
+        }
+        if (!metricsPath.empty())
+            writeMetrics(bytes, seconds, false);
+    }
+}
+
+// write the metrics file, replacing it all at once so it is never read partly written
+void ProgressReporter::writeMetrics(long long bytes, double seconds, bool isDone) const
+{
+    const std::string temporaryPath = metricsPath + ".tmp";
+    std::ofstream metrics(temporaryPath);
+    const auto metric = [&](const char* name, const char* type, const char* help, auto value) {
+        metrics << "# HELP " << metricsPrefix << '_' << name << ' ' << help << '\n'
+                << "# TYPE " << metricsPrefix << '_' << name << ' ' << type << '\n'
+                << metricsPrefix << '_' << name << ' ' << value << '\n';
+    };
+    metric("input_bytes_read_total", "counter", "Bytes of the input read.", bytes);
+    metric("input_bytes", "gauge", "Size of the input in bytes, 0 when unknown.", inputSize);
+    metric("buffer_refills_total", "counter", "Refills of the buffers of the parsers.", refills.load(std::memory_order_relaxed));
+    metric("elapsed_seconds", "gauge", "Seconds since the pass started.", seconds);
+    metric("throughput_bytes_per_second", "gauge", "Bytes of the input read per second since the pass started.",
+           seconds > 0 ? bytes / seconds : 0.0);
+    metric("done", "gauge", "1 when the pass has finished, else 0.", isDone ? 1 : 0);
+    metrics.close();
+    if (!metrics || std::rename(temporaryPath.c_str(), metricsPath.c_str()) != 0)
+        std::cerr << "metrics error : Unable to write metrics file " << metricsPath << '\n';
+}
@@ -0,0 +1,83 @@
+/*
+    ProgressReporter.hpp
+
+    Include file for the progress of a pass over the input, reported on
+    stderr and in a metrics file
+
+    Parsers add the bytes of the input read by each refill of their
+    buffer from the bytes read handler, so the cost is per refill, not
+    per event, and parsers on several threads add to the same progress.
+    At each interval, a thread of the reporter writes a line of the
+    bytes read, the throughput, and when the size of the input is known,
+    the percent done and the estimated time left, and rewrites the
+    metrics file in the Prometheus text format, e.g., for the textfile
+    collector of the node exporter.
+*/
+
+#ifndef INCLUDED_PROGRESSREPORTER_HPP
+#define INCLUDED_PROGRESSREPORTER_HPP
+
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+class ProgressReporter
+{
+
+private:
+    std::atomic<long long> bytesRead;
+    std::atomic<long long> refills;
+
+    // size of the input, 0 when unknown
+    long long inputSize;
+
+    std::chrono::duration<double> interval;
+    bool isProgress;
+    std::string metricsPath;
+    std::string metricsPrefix;
+    std::chrono::steady_clock::time_point start;
+
+    std::mutex stateMutex;
+    std::condition_variable stopped;
+    bool isStopping;
+    std::thread reporter;
+
+public:
+    /*
+        Report the progress at each interval until stopped
+        @param[in] inputSize Size of the input, 0 when unknown
+        @param[in] intervalSeconds Seconds between reports
+        @param[in] isProgress Report a line of the progress on stderr
+        @param[in] metricsPath Path of the metrics file, none when empty
+        @param[in] metricsPrefix Prefix of the names of the metrics
+    */
+    ProgressReporter(long long inputSize, double intervalSeconds, bool isProgress,
+                     const std::string& metricsPath, const std::string& metricsPrefix);
+
+    // stop the reports
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    // add the bytes read by a refill, from any thread
+    void add(long long bytes) {
+        bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+        refills.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // stop the reports, with a final metrics file of the finished pass
+    void stop();
+
+private:
+    // reporter loop
+    void report();
+
+    // write the metrics file, replacing it all at once so it is never read partly written
+    void writeMetrics(long long bytes, double seconds, bool isDone) const;
+};
+
+#endif
@@ -0,0 +1,404 @@
+/*
+    SpeculativeParser.cpp
+
+    Implementation file for the speculative parallel parse of a document
+    in memory, with its events delivered to handlers in document order
+*/
+
+#include "SpeculativeParser.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+using namespace std::literals::string_view_literals;
+
+namespace {
+
+    // depth a chunk is parsed from, so its depth relative to the start of the chunk never reaches 0
+    constexpr int CHUNK_DEPTH = 1 << 24;
+
+    // thrown by the error handler of a parse, to abandon it
+    struct ParseAbandoned {
+        long long offset;
+    };
+
+    // predicate for a character after a '<' that starts markup, i.e., a name,
+    // an end tag, a comment, CDATA, or a processing instruction
+    bool isMarkupStart(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':'
+            || c == '/' || c == '!' || c == '?' || (c & 0x80);
+    }
+
+    /*
+        Guess the lexical state at the start of the bytes before the first '<' that starts markup,
+        from the first end of markup in them
+        @param[in] skipped Bytes from the nominal cut to the '<'
+        @return Guessed state
+    */
+    SpeculativeParser::State guessState(std::string_view skipped) {
+
+        const auto endComment = skipped.find("-->"sv);
+        const auto endCDATA = skipped.find("]]>"sv);
+        const auto endPI = skipped.find("?>"sv);
+        const auto first = std::min({ endComment, endCDATA, endPI });
+        if (first != std::string_view::npos)
+            return first == endComment ? SpeculativeParser::IN_COMMENT : first == endCDATA ? SpeculativeParser::IN_CDATA : SpeculativeParser::IN_PI;
+        return skipped.find('>') != std::string_view::npos ? SpeculativeParser::IN_TAG : SpeculativeParser::IN_TEXT;
+    }
+
+    // handler of XMLParser events that records them into a result, with views of the document
+    class ChunkRecorder
+    {
+
+    private:
+        const EventContext* context = nullptr;
+        SpeculativeParser::Result* result = nullptr;
+
+        // document, and the start of the part being parsed in it
+        const char* document = nullptr;
+        const char* partStart = nullptr;
+
+    public:
+        // context of the events, for their offset and source
+        void attach(const EventContext& context) {
+            this->context = &context;
+        }
+
+        // record the parse of the part at partStart in the document into the result
+        void start(SpeculativeParser::Result& result, const char* document, const char* partStart) {
+            this->result = &result;
+            this->document = document;
+            this->partStart = partStart;
+        }
+
+        // record a start tag
+        void startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName) {
+            auto& record = add(EventRecord::START_TAG, depth);
+            setName(record, qName, prefix);
+        }
+
+        // record an attribute
+        void attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value) {
+            auto& record = add(EventRecord::ATTRIBUTE, depth);
+            setName(record, qName, prefix);
+            setView(record.value, record.valueSize, value);
+        }
+
+        // record text
+        void characters(int depth, std::string_view characters, int newlines) {
+            auto& record = add(EventRecord::CHARACTERS, depth);
+            setView(record.value, record.valueSize, characters);
+            record.newlines = newlines;
+        }
+
+        // record CDATA
+        void cdata(int depth, std::string_view characters, int newlines) {
+            auto& record = add(EventRecord::CDATA, depth);
+            setView(record.value, record.valueSize, characters);
+            record.newlines = newlines;
+        }
+
+        // record a character entity reference
+        void charEntityRef(int depth, std::string_view characters) {
+            auto& record = add(EventRecord::CHAR_ENTITY_REF, depth);
+            setView(record.value, record.valueSize, characters);
+        }
+
+        // record a namespace declaration
+        void namespaceDeclaration(int depth, std::string_view prefix, std::string_view uri) {
+            auto& record = add(EventRecord::NAMESPACE, depth);
+            setView(record.name, record.nameSize, prefix);
+            setView(record.value, record.valueSize, uri);
+        }
+
+        // record an XML comment
+        void comment(int depth, std::string_view comment) {
+            auto& record = add(EventRecord::COMMENT, depth);
+            setView(record.value, record.valueSize, comment);
+        }
+
+        // record the XML declaration, with the standalone in place of the source
+        void declaration(int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone) {
+            auto& record = add(EventRecord::DECLARATION, depth);
+            setView(record.value, record.valueSize, version);
+            record.flags = 0;
+            if (encoding) {
+                setView(record.name, record.nameSize, *encoding);
+                record.flags |= EventRecord::HAS_ENCODING;
+            }
+            if (standalone) {
+                setView(record.source, record.sourceSize, *standalone);
+                record.flags |= EventRecord::HAS_STANDALONE;
+            }
+        }
+
+        // record a processing instruction
+        void processingInstruction(int depth, std::string_view target, std::string_view data) {
+            auto& record = add(EventRecord::PI, depth);
+            setView(record.name, record.nameSize, target);
+            setView(record.value, record.valueSize, data);
+        }
+
+        // record an end tag
+        void endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName) {
+            auto& record = add(EventRecord::END_TAG, depth);
+            setName(record, qName, prefix);
+        }
+
+        // depth at the end of the part
+        void endDocument(int depth) {
+            result->endDepth = depth;
+        }
+
+    private:
+        // add a record of the current event, with its source in the document
+        EventRecord& add(EventRecord::Kind kind, int depth) {
+            auto& record = result->records.emplace_back();
+            const auto eventSource = context->getEventSource();
+            const char* const sourceStart = partStart + context->getEventOffset();
+            record.kind = kind;
+            record.depth = depth;
+            record.offset = sourceStart - document;
+            record.source = sourceStart;
+            record.sourceSize = static_cast<std::uint32_t>(eventSource.size());
+            return record;
+        }
+
+        // set a view of a record to the view in the document of a view of the parser
+        // buffer, or to a copy when it is not in the source of the event
+        void setView(const char*& data, std::uint32_t& size, std::string_view view) {
+            const auto eventSource = context->getEventSource();
+            if (view.data() >= eventSource.data() && view.data() + view.size() <= eventSource.data() + eventSource.size())
+                data = partStart + context->getEventOffset() + (view.data() - eventSource.data());
+            else
+                data = result->values.store(view).data();
+            size = static_cast<std::uint32_t>(view.size());
+        }
+
+        // set the qName of a record, with the size of its prefix
+        void setName(EventRecord& record, std::string_view qName, std::string_view prefix) {
+            setView(record.name, record.nameSize, qName);
+            record.prefixSize = static_cast<std::uint32_t>(prefix.size());
+        }
+    };
+}
+
+// parser and recorder of a worker thread
+struct SpeculativeParser::Worker {
+    ChunkRecorder recorder;
+    CompositeHandler<ChunkRecorder> parser;
+
+    // parser that abandons the parse on an error
+    Worker() : parser(recorder) {
+        parser.getParser().setErrorHandler([](std::string_view message, long long offset) {
+            throw ParseAbandoned{ offset };
+        });
+    }
+
+    /*
+        Parse a part of the document into the result
+        @param[in] document Whole document
+        @param[in] begin Start of the part
+        @param[in] end End of the part
+        @param[in] depth Depth the part is parsed from
+        @param[out] result Result of the part
+    */
+    void parse(std::string_view document, std::size_t begin, std::size_t end, int depth, Result& result) {
+        result.records.clear();
+        result.values.reset();
+        result.parseDepth = result.endDepth = depth;
+        recorder.start(result, document.data(), document.data() + begin);
+        try {
+            parser.parse(document.substr(begin, end - begin), depth, document);
+            result.isValid = true;
+        } catch (const ParseAbandoned& error) {
+            result.isValid = false;
+            result.errorOffset = static_cast<long long>(begin) + error.offset;
+        }
+    }
+};
+
+/*
+    Parser with threadCount worker threads parsing chunks of about chunkSize bytes
+    @param[in] threadCount Number of worker threads
+    @param[in] chunkSize Size of the chunks, before the cuts are moved to markup
+*/
+SpeculativeParser::SpeculativeParser(int threadCount, std::size_t chunkSize)
+    : threadCount(std::max(1, threadCount)), chunkSize(std::max<std::size_t>(1, chunkSize)),
+      pool(std::make_unique<ThreadPool>(this->threadCount)), fixup(std::make_unique<Worker>()),
+      nextSubmit(0), offset(0), totalBytes(0)
+{
+    for (int i = 0; i < this->threadCount; ++i)
+        workers.push_back(std::make_unique<Worker>());
+
+    // two chunks in flight for each worker, so a worker is not idle while a chunk is delivered
+    for (int i = 0; i < 2 * this->threadCount; ++i)
+        results.push_back(std::make_unique<Result>());
+}
+
+// stop the worker threads
+SpeculativeParser::~SpeculativeParser()
+{
+    pool.reset();
+}
+
+// set the handler for the bytes of the document read by each refill of
+// the buffers of the workers, e.g., for progress, from the worker threads
+void SpeculativeParser::setBytesReadHandler(std::function<void(long long bytesRead)> bytesReadHandler)
+{
+    for (auto& worker : workers)
+        worker->parser.getParser().setBytesReadHandler(bytesReadHandler);
+}
+
+// chunks of about chunkSize bytes of the document, with cuts moved to a '<' that is guessed to start markup
+std::vector<SpeculativeParser::Chunk> SpeculativeParser::guessChunks(std::string_view document, std::size_t chunkSize)
+{
+    std::vector<Chunk> chunks;
+    chunks.push_back({ 0, document.size(), IN_TEXT });
+    std::size_t cut = chunkSize;
+    while (cut < document.size()) {
+
+        // a '<' that is not followed by the start of markup is in a comment, CDATA, or processing instruction
+        auto markup = document.find('<', cut);
+        while (markup != std::string_view::npos && markup + 1 < document.size() && !isMarkupStart(document[markup + 1]))
+            markup = document.find('<', markup + 1);
+        if (markup == std::string_view::npos || markup + 1 >= document.size())
+            break;
+        chunks.back().end = markup;
+        chunks.push_back({ markup, document.size(), guessState(document.substr(cut, markup - cut)) });
+        cut = markup + chunkSize;
+    }
+    return chunks;
+}
+
+// cut the document into chunks, and submit the first window of chunks
+void SpeculativeParser::startChunks(std::string_view document)
+{
+    this->document = document;
+    chunks = guessChunks(document, chunkSize);
+    statistics.chunks += chunks.size();
+    for (const auto& chunk : chunks)
+        ++statistics.guesses[chunk.guess];
+    nextSubmit = 0;
+    while (nextSubmit < chunks.size() && nextSubmit < results.size())
+        submit(nextSubmit++);
+}
+
+// parse the chunk at index on a worker thread
+void SpeculativeParser::submit(std::size_t index)
+{
+    Result& result = *results[index % results.size()];
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        result.isDone = false;
+    }
+    const Chunk chunk = chunks[index];
+
+    // only the first chunk starts at the known depth, outside of the root element
+    const int depth = index == 0 ? 0 : CHUNK_DEPTH;
+    pool->submit([this, &result, chunk, depth](int worker) {
+        workers[worker]->parse(document, chunk.begin, chunk.end, depth, result);
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            result.isDone = true;
+        }
+        resultDone.notify_all();
+    });
+}
+
+/*
+    Wait for the result of the chunk at index, parsing it again with the following
+    chunks when it ended with an error, and advance index past the chunks of the result
+    @param[in,out] index Index of the next chunk, then of the chunk after the result
+    @param[in] depth Depth at the start of the chunk
+    @return Result of the chunks
+*/
+const SpeculativeParser::Result& SpeculativeParser::nextResult(std::size_t& index, int depth)
+{
+    // a chunk submitted before is done before its result or its slot is used
+    const auto wait = [this](std::size_t chunk) {
+        if (chunk >= nextSubmit)
+            return;
+        Result& result = *results[chunk % results.size()];
+        std::unique_lock<std::mutex> lock(resultMutex);
+        resultDone.wait(lock, [&result]() { return result.isDone; });
+    };
+
+    // the previous chunk ended without an error at the start of this one, so
+    // this one started at text, and is right unless it ends with an error
+    wait(index);
+    const Result& result = *results[index % results.size()];
+    if (result.isValid) {
+        ++index;
+        return result;
+    }
+
+    // the chunk ended in markup cut at the end of the chunk, so it is parsed again
+    // with the following chunks, until the markup ends in the parse. An error
+    // that stays at the same offset is an error of the document, and is
+    // reported by a parse of the rest of the document.
+    long long errorOffset = result.errorOffset;
+    for (std::size_t last = std::min(index + 2, chunks.size()); ; ++last) {
+        wait(last - 1);
+        fixup->parse(document, chunks[index].begin, chunks[last - 1].end, depth, fixupResult);
+        if (fixupResult.isValid) {
+            statistics.reparsedChunks += last - index;
+            statistics.reparsedBytes += chunks[last - 1].end - chunks[index].begin;
+            index = last;
+            return fixupResult;
+        }
+        if (last == chunks.size()) {
+            fixup->parser.getParser().setErrorHandler(nullptr);
+            fixup->parse(document, chunks[index].begin, document.size(), depth, fixupResult);
+        }
+        if (fixupResult.errorOffset == errorOffset) {
+            for (std::size_t chunk = last; chunk < chunks.size(); ++chunk)
+                wait(chunk);
+            last = chunks.size() - 1;
+        }
+        errorOffset = fixupResult.errorOffset;
+    }
+}
+
+// submit the chunks that fit in the window after the results of the chunks before next are released
+void SpeculativeParser::submitWindow(std::size_t next)
+{
+    nextSubmit = std::max(nextSubmit, next);
+    while (nextSubmit < chunks.size() && nextSubmit < next + results.size())
+        submit(nextSubmit++);
+}
+
+// Get method for the counts of the parses
+const SpeculativeParser::Statistics& SpeculativeParser::getStatistics() const
+{
+    return statistics;
+}
+
+// raw source of the current event, valid only during its handler
+std::string_view SpeculativeParser::getEventSource() const
+{
+    return source;
+}
+
+// offset in the document of the start of the current event
+long long SpeculativeParser::getEventOffset() const
+{
+    return offset;
+}
+
+// Get method for total bytes, to the end of the chunk of the current event
+long long SpeculativeParser::getTotalBytes() const
+{
+    return totalBytes;
+}
+
+// copy of a value of an event that stays valid for the lifetime
+std::string_view SpeculativeParser::retain(std::string_view value, Lifetime lifetime) const
+{
+    return (lifetime == UNIT ? unitArena : documentArena).store(value);
+}
+
+// arena of the values retained for the lifetime, for its statistics
+const Arena& SpeculativeParser::getRetainArena(Lifetime lifetime) const
+{
+    return lifetime == UNIT ? unitArena : documentArena;
+}
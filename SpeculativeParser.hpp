@@ -0,0 +1,276 @@
+/*
+    SpeculativeParser.hpp
+
+    Include file for the speculative parallel parse of a document in
+    memory, with its events delivered to handlers in document order
+
+    Unlike splitRanges(), which scans the whole document for the start
+    tags where it can split, the document is cut into chunks of a fixed
+    size, and a quick pre-scan of the bytes at each cut guesses the
+    lexical state there, i.e., text, or in a tag, comment, CDATA, or
+    processing instruction, and moves the cut to the first '<' it guesses
+    starts markup. Worker threads parse the chunks in parallel, each from
+    a large depth so the depth relative to the start of the chunk never
+    reaches 0, and record the events of each chunk as EventRecords that
+    view the document.
+
+    The thread that calls parse() then takes the chunks in order. A chunk
+    after a chunk that ended without an error starts at text, so its guess
+    was right, and its events are delivered with their depths rebased on
+    the depth at its start. A chunk that ends with an error was cut in the
+    middle of markup, so it is parsed again together with the following
+    chunks until the parse ends without an error, and only those chunks
+    are parsed again. An error that remains at the end of the document is
+    a parse error of the document, reported as by a sequential parse.
+
+    Events are delivered with the same handler interface as the
+    CompositeHandler, with the SpeculativeParser as the EventContext, and
+    with text split at the chunks and the buffers of the workers instead
+    of at the buffer of a sequential parse. Only a window of chunks is in
+    flight, so memory is bounded by the window and not by the document.
+*/
+
+#ifndef INCLUDED_SPECULATIVEPARSER_HPP
+#define INCLUDED_SPECULATIVEPARSER_HPP
+
+#include "CompositeHandler.hpp"
+#include "EventContext.hpp"
+#include "EventRing.hpp"
+#include "Arena.hpp"
+#include <string_view>
+#include <optional>
+#include <functional>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+class ThreadPool;
+
+class SpeculativeParser : public EventContext
+{
+
+public:
+    // lexical state at the nominal start of a chunk, as guessed by the pre-scan
+    enum State : std::uint8_t { IN_TEXT, IN_TAG, IN_COMMENT, IN_CDATA, IN_PI, STATE_COUNT };
+
+    // part of the document parsed on its own, from its guessed cut
+    struct Chunk {
+        std::size_t begin;
+        std::size_t end;
+        State guess;
+    };
+
+    // counts of a parse
+    struct Statistics {
+        long long chunks = 0;
+        long long reparsedChunks = 0;
+        long long reparsedBytes = 0;
+        std::array<long long, STATE_COUNT> guesses{};
+    };
+
+    // events of the parse of a part of the document
+    struct Result {
+        std::vector<EventRecord> records;
+
+        // copies of the values that are not in the document, e.g., the
+        // qName of an empty element, seen only in the parser buffer
+        Arena values;
+
+        // depth the part was parsed from, and the depth at its end
+        int parseDepth = 0;
+        int endDepth = 0;
+
+        // whether the parse ended without an error, else the offset of the error in the document
+        bool isValid = false;
+        long long errorOffset = 0;
+        bool isDone = false;
+    };
+
+private:
+    // parser and recorder of a worker thread
+    struct Worker;
+
+    int threadCount;
+    std::size_t chunkSize;
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // parser of the calling thread, for the parts parsed again
+    std::unique_ptr<Worker> fixup;
+    Result fixupResult;
+
+    // chunks of the document, with a ring of results for the window of chunks in flight
+    std::string_view document;
+    std::vector<Chunk> chunks;
+    std::vector<std::unique_ptr<Result>> results;
+    std::size_t nextSubmit;
+    std::mutex resultMutex;
+    std::condition_variable resultDone;
+    Statistics statistics;
+
+    // context of the event being delivered
+    std::string_view source;
+    long long offset;
+    long long totalBytes;
+    mutable Arena unitArena;
+    mutable Arena documentArena;
+
+public:
+    /*
+        Parser with threadCount worker threads parsing chunks of about chunkSize bytes
+        @param[in] threadCount Number of worker threads
+        @param[in] chunkSize Size of the chunks, before the cuts are moved to markup
+    */
+    SpeculativeParser(int threadCount, std::size_t chunkSize);
+
+    // stop the worker threads
+    ~SpeculativeParser();
+
+    SpeculativeParser(const SpeculativeParser&) = delete;
+    SpeculativeParser& operator=(const SpeculativeParser&) = delete;
+
+    // parse a whole document, delivering its events to each handler that has
+    // the member function, in document order
+    template <typename... Handlers>
+    void parse(std::string_view document, Handlers&... handlers) {
+        using namespace HandlerCall;
+        auto dispatch = [&](const auto& call, const auto&... args) {
+            (dispatchTo(call, handlers, args...), ...);
+        };
+        dispatch(ATTACH, static_cast<const EventContext&>(*this));
+        source = std::string_view();
+        offset = 0;
+        totalBytes = 0;
+        unitArena.reset();
+        documentArena.reset();
+        dispatch(START_DOCUMENT, 0);
+
+        startChunks(document);
+        int depth = 0;
+        for (std::size_t index = 0; index < chunks.size(); ) {
+            const Result& result = nextResult(index, depth);
+            totalBytes = chunks[index - 1].end;
+            const int rebase = depth - result.parseDepth;
+            for (const auto& record : result.records)
+                deliver(record, rebase, dispatch);
+            depth = result.endDepth + rebase;
+            submitWindow(index);
+        }
+        source = std::string_view();
+        offset = totalBytes = document.size();
+        dispatch(BUFFER_RELEASE, document);
+        dispatch(END_DOCUMENT, depth);
+    }
+
+    // set the handler for the bytes of the document read by each refill of
+    // the buffers of the workers, e.g., for progress, from the worker threads
+    void setBytesReadHandler(std::function<void(long long bytesRead)> bytesReadHandler);
+
+    // chunks of about chunkSize bytes of the document, with cuts moved to a '<' that is guessed to start markup
+    static std::vector<Chunk> guessChunks(std::string_view document, std::size_t chunkSize);
+
+    // Get method for the counts of the parses
+    const Statistics& getStatistics() const;
+
+    // raw source of the current event, valid only during its handler
+    std::string_view getEventSource() const override;
+
+    // offset in the document of the start of the current event
+    long long getEventOffset() const override;
+
+    // Get method for total bytes, to the end of the chunk of the current event
+    long long getTotalBytes() const override;
+
+    // copy of a value of an event that stays valid for the lifetime
+    std::string_view retain(std::string_view value, Lifetime lifetime) const override;
+
+    // arena of the values retained for the lifetime, for its statistics
+    const Arena& getRetainArena(Lifetime lifetime) const;
+
+private:
+    // cut the document into chunks, and submit the first window of chunks
+    void startChunks(std::string_view document);
+
+    /*
+        Wait for the result of the chunk at index, parsing it again with the following
+        chunks when it ended with an error, and advance index past the chunks of the result
+        @param[in,out] index Index of the next chunk, then of the chunk after the result
+        @param[in] depth Depth at the start of the chunk
+        @return Result of the chunks
+    */
+    const Result& nextResult(std::size_t& index, int depth);
+
+    // submit the chunks that fit in the window after the results of the chunks before next are released
+    void submitWindow(std::size_t next);
+
+    // parse the chunk at index on a worker thread
+    void submit(std::size_t index);
+
+    // call the handler member function of a record, with its depth rebased
+    template <typename Dispatch>
+    void deliver(const EventRecord& record, int rebase, const Dispatch& dispatch) {
+        using namespace HandlerCall;
+        const int depth = record.depth + rebase;
+        const std::string_view name(record.name, record.nameSize);
+        const std::string_view value(record.value, record.valueSize);
+        source = std::string_view(record.source, record.sourceSize);
+        offset = record.offset;
+        switch (record.kind) {
+        case EventRecord::START_TAG:
+            if (depth == 1)
+                unitArena.reset();
+            dispatch(START_TAG, depth, name, prefix(record, name), localName(record, name));
+            break;
+        case EventRecord::ATTRIBUTE:
+            dispatch(ATTRIBUTE, depth, name, prefix(record, name), localName(record, name), value);
+            break;
+        case EventRecord::CHARACTERS:
+            // a sequential parse skips the whitespace outside of the root element
+            if (depth != 0)
+                dispatch(CHARACTERS, depth, value, record.newlines);
+            break;
+        case EventRecord::CDATA:
+            dispatch(CDATA, depth, value, record.newlines);
+            break;
+        case EventRecord::CHAR_ENTITY_REF:
+            dispatch(CHAR_ENTITY_REF, depth, value);
+            break;
+        case EventRecord::NAMESPACE:
+            dispatch(NAMESPACE, depth, name, value);
+            break;
+        case EventRecord::COMMENT:
+            dispatch(COMMENT, depth, value);
+            break;
+        case EventRecord::DECLARATION: {
+            const auto encoding = record.flags & EventRecord::HAS_ENCODING ? std::optional<std::string_view>(name) : std::nullopt;
+            const auto standalone = record.flags & EventRecord::HAS_STANDALONE ? std::optional<std::string_view>(source) : std::nullopt;
+            source = std::string_view();
+            dispatch(DECLARATION, depth, value, encoding, standalone);
+            break;
+        }
+        case EventRecord::PI:
+            dispatch(PI, depth, name, value);
+            break;
+        case EventRecord::END_TAG:
+            dispatch(END_TAG, depth, prefix(record, name), name, localName(record, name));
+            break;
+        default:
+            break;
+        }
+    }
+
+    // prefix of a qName
+    static std::string_view prefix(const EventRecord& record, std::string_view qName) {
+        return qName.substr(0, record.prefixSize);
+    }
+
+    // local name of a qName, after the prefix and its ':'
+    static std::string_view localName(const EventRecord& record, std::string_view qName) {
+        return record.prefixSize ? qName.substr(record.prefixSize + 1) : qName;
+    }
+};
+
+#endif
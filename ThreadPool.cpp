@@ -0,0 +1,127 @@
+/*
+    ThreadPool.cpp
+
+    Implementation file for a fixed-size, work-stealing pool of worker threads
+*/
+
+#include "ThreadPool.hpp"
+
+namespace {
+
+    // pool and worker index of the current thread, when it is a worker
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+// start threadCount worker threads
+ThreadPool::ThreadPool(int threadCount)
+    : queuedTasks(0), pendingTasks(0), stolenTasks(0), nextQueue(0), isStopping(false)
+{
+    if (threadCount < 1)
+        threadCount = 1;
+    for (int i = 0; i < threadCount; ++i)
+        queues.push_back(std::make_unique<TaskQueue>());
+    workers.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i)
+        workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+// stop and join the worker threads
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        isStopping = true;
+    }
+    taskAdded.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// add a task, to the queue of the current worker when called from a task
+void ThreadPool::submit(Task task)
+{
+    const int queue = currentPool == this ? currentWorker : static_cast<int>(nextQueue++ % queues.size());
+    ++pendingTasks;
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->tasks.push_back(std::move(task));
+    }
+    ++queuedTasks;
+
+    // synchronize with a worker checking for tasks before it waits
+    { std::lock_guard<std::mutex> lock(stateMutex); }
+    taskAdded.notify_one();
+}
+
+// wait until all submitted tasks have finished
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    tasksDone.wait(lock, [this] { return pendingTasks == 0; });
+}
+
+// number of worker threads
+int ThreadPool::size() const
+{
+    return static_cast<int>(workers.size());
+}
+
+// number of tasks run by a worker other than the one they were queued on
+long ThreadPool::getStolenTasks() const
+{
+    return stolenTasks;
+}
+
+// take the newest task from the worker's own queue
+bool ThreadPool::popTask(int worker, Task& task)
+{
+    auto& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    --queuedTasks;
+    return true;
+}
+
+// take the oldest task from the queue of another worker
+bool ThreadPool::stealTask(int worker, Task& task)
+{
+    const int queueCount = static_cast<int>(queues.size());
+    for (int i = 1; i < queueCount; ++i) {
+        auto& queue = *queues[(worker + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        --queuedTasks;
+        ++stolenTasks;
+        return true;
+    }
+    return false;
+}
+
+// worker loop
+void ThreadPool::work(int worker)
+{
+    currentPool = this;
+    currentWorker = worker;
+    while (true) {
+        Task task;
+        if (popTask(worker, task) || stealTask(worker, task)) {
+            task(worker);
+            if (--pendingTasks == 0) {
+                { std::lock_guard<std::mutex> lock(stateMutex); }
+                tasksDone.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(stateMutex);
+        taskAdded.wait(lock, [this] { return isStopping || queuedTasks > 0; });
+        if (isStopping && queuedTasks == 0)
+            return;
+    }
+}
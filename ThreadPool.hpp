@@ -0,0 +1,81 @@
+/*
+    ThreadPool.hpp
+
+    Include file for a fixed-size, work-stealing pool of worker threads
+
+    Each worker has its own task queue. Tasks submitted by a worker,
+    e.g., the parts of a split job, go on that worker's queue, and it
+    takes them newest first. An idle worker steals the oldest task from
+    the queue of another worker.
+*/
+
+#ifndef INCLUDED_THREADPOOL_HPP
+#define INCLUDED_THREADPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+class ThreadPool
+{
+
+public:
+    // task run by a worker, given the index of the worker running it
+    using Task = std::function<void(int worker)>;
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex stateMutex;
+    std::condition_variable taskAdded;
+    std::condition_variable tasksDone;
+    std::atomic<int> queuedTasks;
+    std::atomic<int> pendingTasks;
+    std::atomic<long> stolenTasks;
+    std::atomic<unsigned int> nextQueue;
+    bool isStopping;
+
+public:
+    // start threadCount worker threads
+    ThreadPool(int threadCount);
+
+    // stop and join the worker threads
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // add a task, to the queue of the current worker when called from a task
+    void submit(Task task);
+
+    // wait until all submitted tasks have finished
+    void wait();
+
+    // number of worker threads
+    int size() const;
+
+    // number of tasks run by a worker other than the one they were queued on
+    long getStolenTasks() const;
+
+private:
+    // worker loop
+    void work(int worker);
+
+    // take the newest task from the worker's own queue
+    bool popTask(int worker, Task& task);
+
+    // take the oldest task from the queue of another worker
+    bool stealTask(int worker, Task& task);
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*
+    UnitTree.cpp
+
+    Implementation file for the tree of a single unit as flat arrays of nodes
+*/
+
+#include "UnitTree.hpp"
+
+// text of all text nodes of the subtree of the node, in document order
+std::string UnitTree::textOf(NodeID node) const
+{
+    // nodes of a subtree are the nodes after it up to the first node
+    // that is not a descendant, so no traversal of links is needed
+    std::string result;
+    for (NodeID descendant = node; descendant < size(); ++descendant) {
+        if (descendant != node) {
+            NodeID ancestor = parents[descendant];
+            while (ancestor != NONE && ancestor > node)
+                ancestor = parents[ancestor];
+            if (ancestor != node)
+                break;
+        }
+        if (kinds[descendant] == TEXT)
+            result += value(descendant);
+    }
+    return result;
+}
+
+// name ID of a name, added when new, so IDs can be found before a parse
+std::uint32_t UnitTree::intern(std::string_view name)
+{
+    auto& id = nameTable[name];
+    if (id == 0) {
+        names.push_back(name);
+        id = names.size();
+    }
+    return static_cast<std::uint32_t>(id - 1);
+}
+
+// bytes reserved by the columns and text buffer
+std::size_t UnitTree::getBytesReserved() const
+{
+    return kinds.capacity() * sizeof(Kind)
+         + (nameIDs.capacity() + textOffsets.capacity() + textSizes.capacity()) * sizeof(std::uint32_t)
+         + (parents.capacity() + firstChildren.capacity() + nextSiblings.capacity()) * sizeof(NodeID)
+         + text.capacity();
+}
+
+// remove all nodes, keeping the capacity of the columns
+void UnitTree::clear()
+{
+    kinds.clear();
+    nameIDs.clear();
+    parents.clear();
+    firstChildren.clear();
+    nextSiblings.clear();
+    textOffsets.clear();
+    textSizes.clear();
+    text.clear();
+    openElements.clear();
+    lastChildren.clear();
+}
+
+// add an element as the last child of the current element, and make it the current element
+void UnitTree::startElement(std::string_view qName)
+{
+    const auto node = addNode(ELEMENT, intern(qName), text.size(), 0);
+    openElements.push_back(node);
+    lastChildren.push_back(NONE);
+}
+
+// add an attribute of the current element
+void UnitTree::addAttribute(std::string_view qName, std::string_view value)
+{
+    addNode(ATTRIBUTE, intern(qName), text.size(), value.size());
+    text += value;
+}
+
+// add text as the last child of the current element, appended to a text node before it
+void UnitTree::addText(std::string_view characters)
+{
+    const NodeID last = lastChildren.back();
+    if (last != NONE && kinds[last] == TEXT && textOffsets[last] + textSizes[last] == text.size())
+        textSizes[last] += characters.size();
+    else
+        addNode(TEXT, NO_NAME, text.size(), characters.size());
+    text += characters;
+}
+
+// end the current element
+void UnitTree::endElement()
+{
+    openElements.pop_back();
+    lastChildren.pop_back();
+}
+
+// add a node as the last child of the current element
+UnitTree::NodeID UnitTree::addNode(Kind kind, std::uint32_t nameID, std::size_t textOffset, std::size_t textSize)
+{
+    const auto node = static_cast<NodeID>(kinds.size());
+    const NodeID parent = openElements.empty() ? NONE : openElements.back();
+    kinds.push_back(kind);
+    nameIDs.push_back(nameID);
+    parents.push_back(parent);
+    firstChildren.push_back(NONE);
+    nextSiblings.push_back(NONE);
+    textOffsets.push_back(static_cast<std::uint32_t>(textOffset));
+    textSizes.push_back(static_cast<std::uint32_t>(textSize));
+    if (parent != NONE) {
+        NodeID& last = lastChildren.back();
+        if (last == NONE)
+            firstChildren[parent] = node;
+        else
+            nextSiblings[last] = node;
+        last = node;
+    }
+    return node;
+}
@@ -0,0 +1,135 @@
+/*
+    UnitTree.hpp
+
+    Include file for the tree of a single unit as flat arrays of nodes
+
+    Nodes are in document order, with the root element of the unit as
+    node 0, and each node is an index into a column for each of its
+    fields (struct of arrays): kind, name ID, parent, first child, next
+    sibling, and the span of its text. Attributes are the first children
+    of their element, and adjacent text is a single text node, with
+    character entity references and CDATA as text.
+
+    Names are interned once for all units, so a name ID can be found
+    before a parse and compared as an integer. Text is in a single
+    buffer with spans of offsets. The columns and the text buffer are
+    cleared for each unit, keeping their capacity, so after the largest
+    unit there is no allocation.
+*/
+
+#ifndef INCLUDED_UNITTREE_HPP
+#define INCLUDED_UNITTREE_HPP
+
+#include "NameTable.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+class UnitTree
+{
+
+public:
+    // kind of node
+    enum Kind : std::uint8_t { ELEMENT, ATTRIBUTE, TEXT };
+
+    // index of a node in the columns
+    using NodeID = std::uint32_t;
+
+    // no node, e.g., the parent of the root
+    static constexpr NodeID NONE = UINT32_MAX;
+
+    // no name, the name ID of text
+    static constexpr std::uint32_t NO_NAME = UINT32_MAX;
+
+private:
+    // columns of the nodes
+    std::vector<Kind> kinds;
+    std::vector<std::uint32_t> nameIDs;
+    std::vector<NodeID> parents;
+    std::vector<NodeID> firstChildren;
+    std::vector<NodeID> nextSiblings;
+    std::vector<std::uint32_t> textOffsets;
+    std::vector<std::uint32_t> textSizes;
+
+    std::string text;
+
+    // names of the name IDs, with each ID + 1 in the table
+    NameTable nameTable;
+    std::vector<std::string_view> names;
+
+    // open elements, with their last child, while the tree is built
+    std::vector<NodeID> openElements;
+    std::vector<NodeID> lastChildren;
+
+public:
+    // number of nodes
+    std::size_t size() const {
+        return kinds.size();
+    }
+
+    // kind of the node
+    Kind kind(NodeID node) const {
+        return kinds[node];
+    }
+
+    // name ID of an element or attribute, NO_NAME for text
+    std::uint32_t nameID(NodeID node) const {
+        return nameIDs[node];
+    }
+
+    // qualified name of an element or attribute, empty for text
+    std::string_view name(NodeID node) const {
+        return nameIDs[node] == NO_NAME ? std::string_view() : names[nameIDs[node]];
+    }
+
+    // parent of the node, NONE for the root
+    NodeID parent(NodeID node) const {
+        return parents[node];
+    }
+
+    // first child of the node, NONE for none
+    NodeID firstChild(NodeID node) const {
+        return firstChildren[node];
+    }
+
+    // next sibling of the node, NONE for none
+    NodeID nextSibling(NodeID node) const {
+        return nextSiblings[node];
+    }
+
+    // text of a text node, or the value of an attribute
+    std::string_view value(NodeID node) const {
+        return std::string_view(text.data() + textOffsets[node], textSizes[node]);
+    }
+
+    // text of all text nodes of the subtree of the node, in document order
+    std::string textOf(NodeID node) const;
+
+    // name ID of a name, added when new, so IDs can be found before a parse
+    std::uint32_t intern(std::string_view name);
+
+    // bytes reserved by the columns and text buffer
+    std::size_t getBytesReserved() const;
+
+    // remove all nodes, keeping the capacity of the columns
+    void clear();
+
+    // add an element as the last child of the current element, and make it the current element
+    void startElement(std::string_view qName);
+
+    // add an attribute of the current element
+    void addAttribute(std::string_view qName, std::string_view value);
+
+    // add text as the last child of the current element, appended to a text node before it
+    void addText(std::string_view characters);
+
+    // end the current element
+    void endElement();
+
+private:
+    // add a node as the last child of the current element
+    NodeID addNode(Kind kind, std::uint32_t nameID, std::size_t textOffset, std::size_t textSize);
+};
+
+#endif
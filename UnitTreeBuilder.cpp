@@ -0,0 +1,89 @@
+/*
+    UnitTreeBuilder.cpp
+
+    Implementation file for the handler of XMLParser events that builds
+    the UnitTree of each unit
+*/
+
+#include "UnitTreeBuilder.hpp"
+#include <algorithm>
+
+using namespace std::literals::string_view_literals;
+
+// builder calling unitHandler with the tree of each unit when it ends
+UnitTreeBuilder::UnitTreeBuilder(std::function<void(const UnitTree& tree)> unitHandler)
+    : handleUnit(unitHandler), treeDepth(-1), units(0), largestUnit(0)
+{}
+
+// tree the units are built in, e.g., to intern names before a parse
+UnitTree& UnitTreeBuilder::getTree()
+{
+    return tree;
+}
+
+// start a tree at a unit, restarting at the first unit of an archive
+void UnitTreeBuilder::startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName)
+{
+    // the root unit is built until a unit in it shows it is an archive
+    if (depth <= 1 && localName == "unit"sv) {
+        tree.clear();
+        treeDepth = depth;
+    }
+    if (treeDepth != -1)
+        tree.startElement(qName);
+}
+
+// add an attribute of the current element
+void UnitTreeBuilder::attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value)
+{
+    if (treeDepth != -1)
+        tree.addAttribute(qName, value);
+}
+
+// add text
+void UnitTreeBuilder::characters(int depth, std::string_view characters, int newlines)
+{
+    if (treeDepth != -1)
+        tree.addText(characters);
+}
+
+// add CDATA as text
+void UnitTreeBuilder::cdata(int depth, std::string_view characters, int newlines)
+{
+    if (treeDepth != -1)
+        tree.addText(characters);
+}
+
+// add a character entity reference as text
+void UnitTreeBuilder::charEntityRef(int depth, std::string_view characters)
+{
+    if (treeDepth != -1)
+        tree.addText(characters);
+}
+
+// end an element, and the tree at the end of its unit
+void UnitTreeBuilder::endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName)
+{
+    if (treeDepth == -1)
+        return;
+    tree.endElement();
+    if (depth != treeDepth)
+        return;
+    ++units;
+    largestUnit = std::max(largestUnit, tree.size());
+    handleUnit(tree);
+    tree.clear();
+    treeDepth = -1;
+}
+
+// Get method for the number of units built
+long long UnitTreeBuilder::getUnits() const
+{
+    return units;
+}
+
+// Get method for the most nodes of a unit
+std::size_t UnitTreeBuilder::getLargestUnit() const
+{
+    return largestUnit;
+}
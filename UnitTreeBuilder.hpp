@@ -0,0 +1,65 @@
+/*
+    UnitTreeBuilder.hpp
+
+    Include file for the handler of XMLParser events that builds the
+    UnitTree of each unit, one unit at a time
+
+    In an archive, each unit at depth 1 is built and given to the unit
+    handler when it ends, and otherwise the root unit is. Nothing outside
+    of the units is kept, and the tree is reused for each unit, so memory
+    is bounded by the largest unit and not by the archive.
+*/
+
+#ifndef INCLUDED_UNITTREEBUILDER_HPP
+#define INCLUDED_UNITTREEBUILDER_HPP
+
+#include "UnitTree.hpp"
+#include <functional>
+#include <string_view>
+
+class UnitTreeBuilder
+{
+
+private:
+    UnitTree tree;
+    std::function<void(const UnitTree& tree)> handleUnit;
+
+    // depth of the root of the tree being built, -1 when there is none
+    int treeDepth;
+
+    long long units;
+    std::size_t largestUnit;
+
+public:
+    // builder calling unitHandler with the tree of each unit when it ends
+    UnitTreeBuilder(std::function<void(const UnitTree& tree)> unitHandler);
+
+    // tree the units are built in, e.g., to intern names before a parse
+    UnitTree& getTree();
+
+    // start a tree at a unit, restarting at the first unit of an archive
+    void startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName);
+
+    // add an attribute of the current element
+    void attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value);
+
+    // add text
+    void characters(int depth, std::string_view characters, int newlines);
+
+    // add CDATA as text
+    void cdata(int depth, std::string_view characters, int newlines);
+
+    // add a character entity reference as text
+    void charEntityRef(int depth, std::string_view characters);
+
+    // end an element, and the tree at the end of its unit
+    void endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName);
+
+    // Get method for the number of units built
+    long long getUnits() const;
+
+    // Get method for the most nodes of a unit
+    std::size_t getLargestUnit() const;
+};
+
+#endif
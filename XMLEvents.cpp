@@ -0,0 +1,133 @@
+/*
+    XMLEvents.cpp
+
+    Implementation file for the XMLParser events as a C++20 coroutine generator
+*/
+
+#include "XMLEvents.hpp"
+
+// events from a parser with its own buffer
+XMLEvents::XMLEvents()
+    : queueSize(0),
+      parser(
+        // start tag handler
+        [this](int depth, std::string_view qName, std::string_view prefix, std::string_view localName) {
+            auto& event = push(XMLEvent::START_TAG, depth);
+            event.qName = qName;
+            event.prefix = prefix;
+            event.localName = localName;
+        },
+        // attribute handler
+        [this](int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value) {
+            auto& event = push(XMLEvent::ATTRIBUTE, depth);
+            event.qName = qName;
+            event.prefix = prefix;
+            event.localName = localName;
+            event.value = value;
+        },
+        // non-CER character handler
+        [this](int depth, std::string_view characters, int newlines) {
+            auto& event = push(XMLEvent::CHARACTERS, depth);
+            event.value = characters;
+            event.newlines = newlines;
+        },
+        // CDATA handler
+        [this](int depth, std::string_view characters, int newlines) {
+            auto& event = push(XMLEvent::CDATA, depth);
+            event.value = characters;
+            event.newlines = newlines;
+        },
+        // CER handler
+        [this](int depth, std::string_view characters) {
+            push(XMLEvent::CER, depth).value = characters;
+        },
+        // namespace handler
+        [this](int depth, std::string_view prefix, std::string_view uri) {
+            auto& event = push(XMLEvent::NAMESPACE, depth);
+            event.prefix = prefix;
+            event.value = uri;
+        },
+        // XML comment handler
+        [this](int depth, std::string_view comment) {
+            push(XMLEvent::COMMENT, depth).value = comment;
+        },
+        // XML declaration handler
+        [this](int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone) {
+            auto& event = push(XMLEvent::DECLARATION, depth);
+            event.value = version;
+            event.encoding = encoding;
+            event.standalone = standalone;
+        },
+        // processing instruction handler
+        [this](int depth, std::string_view target, std::string_view data) {
+            auto& event = push(XMLEvent::PI, depth);
+            event.qName = target;
+            event.value = data;
+        },
+        // end tag handler
+        [this](int depth, std::string_view prefix, std::string_view qName, std::string_view localName) {
+            auto& event = push(XMLEvent::END_TAG, depth);
+            event.qName = qName;
+            event.prefix = prefix;
+            event.localName = localName;
+        },
+        // start document handler
+        [this](int depth) {
+            push(XMLEvent::START_DOCUMENT, depth);
+        },
+        // end document handler
+        [this](int depth) {
+            push(XMLEvent::END_DOCUMENT, depth);
+        }
+    )
+{}
+
+// events of the XML read from file descriptor fd
+Generator<XMLEvent> XMLEvents::parse(int fd)
+{
+    queueSize = 0;
+    parser.startParse(fd);
+    return events();
+}
+
+// events of a range of XML in memory that starts outside of any markup
+// at element depth startDepth
+Generator<XMLEvent> XMLEvents::parse(std::string_view range, int startDepth)
+{
+    queueSize = 0;
+    parser.startParse(range, startDepth);
+    return events();
+}
+
+// Get method for total bytes
+long long XMLEvents::getTotalBytes()
+{
+    return parser.getTotalBytes();
+}
+
+// add an event to the queue of the current parse step
+XMLEvent& XMLEvents::push(XMLEvent::Kind kind, int depth)
+{
+    auto& event = queue[queueSize++];
+    event.kind = kind;
+    event.depth = depth;
+    return event;
+}
+
+/*
+    Events of the started parse. Each parse step queues the events of its
+    handlers, which are yielded before the next step, so the views of an
+    event stay valid until the buffer is refilled in the next step.
+*/
+Generator<XMLEvent> XMLEvents::events()
+{
+    bool isMore = true;
+    while (true) {
+        for (int i = 0; i < queueSize; ++i)
+            co_yield queue[i];
+        queueSize = 0;
+        if (!isMore)
+            break;
+        isMore = parser.parseNext();
+    }
+}
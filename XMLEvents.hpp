@@ -0,0 +1,96 @@
+/*
+    XMLEvents.hpp
+
+    Include file for the XMLParser events as a C++20 coroutine generator
+
+    Instead of registering handlers, a consumer iterates the events of a
+    parse in straight-line code, with its state in local variables:
+
+        XMLEvents events;
+        for (const auto& event : events.parse(0)) {
+            if (event.kind == XMLEvent::START_TAG)
+                ...
+        }
+
+    The string views of an event point into the parser buffer and are
+    valid until the next event is requested. The parser and its buffer
+    belong to the XMLEvents, and the coroutine frame comes from the
+    FramePool, so reusing an XMLEvents for a parse does not allocate.
+*/
+
+#ifndef INCLUDED_XMLEVENTS_HPP
+#define INCLUDED_XMLEVENTS_HPP
+
+#include "XMLParser.hpp"
+#include "Generator.hpp"
+#include <string_view>
+#include <optional>
+#include <array>
+#include <cstdint>
+
+// a single XMLParser event, with the parameters of its handler
+struct XMLEvent {
+    enum Kind : std::uint8_t {
+        START_DOCUMENT, END_DOCUMENT, START_TAG, END_TAG, ATTRIBUTE, NAMESPACE,
+        CHARACTERS, CDATA, CER, COMMENT, DECLARATION, PI
+    };
+
+    Kind kind;
+
+    // element depth, as passed to the handler
+    int depth;
+
+    // newlines in CHARACTERS and CDATA
+    int newlines;
+
+    // names of START_TAG, END_TAG, and ATTRIBUTE, the prefix of NAMESPACE,
+    // and the target of PI in qName
+    std::string_view qName;
+    std::string_view prefix;
+    std::string_view localName;
+
+    // value of ATTRIBUTE, text of CHARACTERS, CDATA, CER, and COMMENT,
+    // uri of NAMESPACE, data of PI, and version of DECLARATION
+    std::string_view value;
+
+    // encoding and standalone of DECLARATION
+    std::optional<std::string_view> encoding;
+    std::optional<std::string_view> standalone;
+};
+
+class XMLEvents
+{
+
+private:
+    // events of a single parse step, at most a start or end tag with its
+    // attribute or namespace, or the end of the document
+    std::array<XMLEvent, 4> queue;
+    int queueSize;
+    XMLParser parser;
+
+public:
+    // events from a parser with its own buffer
+    XMLEvents();
+
+    XMLEvents(const XMLEvents&) = delete;
+    XMLEvents& operator=(const XMLEvents&) = delete;
+
+    // events of the XML read from file descriptor fd
+    Generator<XMLEvent> parse(int fd);
+
+    // events of a range of XML in memory that starts outside of any markup
+    // at element depth startDepth
+    Generator<XMLEvent> parse(std::string_view range, int startDepth);
+
+    // Get method for total bytes
+    long long getTotalBytes();
+
+private:
+    // add an event to the queue of the current parse step
+    XMLEvent& push(XMLEvent::Kind kind, int depth);
+
+    // events of the started parse, one parse step at a time
+    Generator<XMLEvent> events();
+};
+
+#endif
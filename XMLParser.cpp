@@ -6,10 +6,14 @@
 
 #include "XMLParser.hpp"
 #include "refillBuffer.hpp"
+#include "scanText.hpp"
+#include "ParseDiagnostic.hpp"
 #include <string.h>
 #include <iostream>
+#include <sstream>
 #include <algorithm>
 #include <bitset>
+#include <array>
 #include <string_view>
 
 using namespace std::literals::string_view_literals;
@@ -34,12 +38,56 @@ std::bitset<128> tagNameMaskTemp("0000011111111111111111111111111010000111111111
 
 const int BUFFER_SIZE = 16 * 16 * 4096;
 
+namespace {
+
+    // size of the sentinel after the data in the buffer, a '<' followed by
+    // zeros, longer than the longest lookahead, "<![CDATA[", and a SIMD block
+    constexpr std::size_t SENTINEL_SIZE = 64;
+
+    // characters of names, indexed by unsigned char, with the bytes of UTF-8.
+    // Neither '<' nor '\0' are, so a scan of a name stops at the sentinel.
+    const auto NAME_CHARACTERS = []() {
+        std::array<bool, 256> table{};
+        for (std::size_t c = 0; c < table.size(); ++c)
+            table[c] = c >= 128 || tagNameMaskTemp[c];
+        return table;
+    }();
+
+    // end of the name at p, with no check for the end of the data
+    inline std::string::const_iterator skipName(std::string::const_iterator p) {
+        while (NAME_CHARACTERS[static_cast<unsigned char>(*p)])
+            ++p;
+        return p;
+    }
+
+    // predicate for whitespace, as isspace() in the C locale
+    inline bool isSpace(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    // end of the whitespace at p, with no check for the end of the data
+    inline std::string::const_iterator skipSpace(std::string::const_iterator p) {
+        while (isSpace(*p))
+            ++p;
+        return p;
+    }
+}
+
+// parse error at position in the buffer, with a message of the parts
+template <typename... Parts>
+void XMLParser::error(std::string::const_iterator position, const Parts&... parts) const
+{
+    std::ostringstream message;
+    (message << ... << parts);
+    reportError(message.str(), position);
+}
+
 // parameterized XMLParser constructor
 XMLParser::XMLParser(
     std::function<void(int depth, std::string_view qName, std::string_view prefix, std::string_view localName)> startTagHandler, 
     std::function<void(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value)> attributeHandler,
-    std::function<void(int depth, std::string_view characters)> nonCERHandler,
-    std::function<void(int depth, std::string_view characters)> CDATAHandler,
+    std::function<void(int depth, std::string_view characters, int newlines)> nonCERHandler,
+    std::function<void(int depth, std::string_view characters, int newlines)> CDATAHandler,
     std::function<void(int depth, std::string_view characters)> CERHandler,
     std::function<void(int depth, std::string_view prefix, std::string_view uri)> namespaceHandler,
     std::function<void(int depth, std::string_view comment)> commentHandler,
@@ -50,7 +98,7 @@ XMLParser::XMLParser(
     std::function<void(int depth)> endHandler
     )
 {
-    buffer.assign(BUFFER_SIZE, ' ');
+    buffer.assign(BUFFER_SIZE + SENTINEL_SIZE, ' ');
     cursor = buffer.cbegin();
     cursorEnd = buffer.cend();
     depth = 0;
@@ -58,6 +106,11 @@ XMLParser::XMLParser(
     isInCDATA = false;
     isInXMLComment = false;
     totalBytes = 0;
+    inputBytes = 0;
+    inputFD = 0;
+    isDecoding = false;
+    trace = nullptr;
+    traceBase = 0;
 
     handleStartTag = startTagHandler;
     handleAttribute = attributeHandler;
@@ -82,12 +135,11 @@ bool XMLParser::inXMLNS()
 // parse XML namespace
 void XMLParser::parseXMLNS()
 {
-std::advance(cursor, 5);
+    const auto eventStart = cursor;
+    std::advance(cursor, 5);
     const auto nameEnd = std::find(cursor, cursorEnd, '=');
-    if (nameEnd == cursorEnd) {
-        std::cerr << "parser error : incomplete namespace\n";
-        exit(1);
-    }
+    if (nameEnd == cursorEnd)
+        error(eventStart, "incomplete namespace");
     int prefixSize = 0;
     if (*cursor == ':') {
         std::advance(cursor, 1);
@@ -95,27 +147,22 @@ std::advance(cursor, 5);
     }
     const std::string_view prefix(std::addressof(*cursor), prefixSize);
     cursor = std::next(nameEnd);
-    cursor = std::find_if_not(cursor, cursorEnd, isspace);
-    if (cursor == cursorEnd) {
-        std::cerr << "parser error : incomplete namespace\n";
-        exit(1);
-    }
+    cursor = skipSpace(cursor);
+    if (cursor == cursorEnd)
+        error(eventStart, "incomplete namespace");
     const auto delimiter = *cursor;
-    if (delimiter != '"' && delimiter != '\'') {
-        std::cerr << "parser error : incomplete namespace\n";
-        exit(1);
-    }
+    if (delimiter != '"' && delimiter != '\'')
+        error(eventStart, "incomplete namespace");
     std::advance(cursor, 1);
     const auto valueEnd = std::find(cursor, cursorEnd, delimiter);
-    if (valueEnd == cursorEnd) {
-        std::cerr << "parser error : incomplete namespace\n";
-        exit(1);
-    }
+    if (valueEnd == cursorEnd)
+        error(eventStart, "incomplete namespace");
     const std::string_view uri(std::addressof(*cursor), std::distance(cursor, valueEnd));
     TRACE("NAMESPACE", "prefix", prefix, "uri", uri);
+    setSource(EventLog::NAMESPACE, eventStart, std::next(valueEnd));
     handleNamespace(depth, prefix, uri);
     cursor = std::next(valueEnd);
-    cursor = std::find_if_not(cursor, cursorEnd, isspace);
+    cursor = skipSpace(cursor);
     if (*cursor == '>') {
         std::advance(cursor, 1);
         inTag = false;
@@ -124,6 +171,8 @@ std::advance(cursor, 5);
         std::advance(cursor, 2);
         TRACE("END TAG", "prefix", inTagPrefix, "qName", inTagQName, "localName", inTagLocalName);
         inTag = false;
+        setSource(EventLog::END_TAG, std::prev(cursor, 2), cursor);
+        handleEndTag(depth, inTagPrefix, inTagQName, inTagLocalName);
     }
 }
 
@@ -136,17 +185,14 @@ bool XMLParser::inAttribute()
 // parse attribute
 void XMLParser::parseAttribute()
 {
-    const auto nameEnd = std::find_if_not(cursor, cursorEnd, [] (char c) { return tagNameMaskTemp[c]; });
-    if (nameEnd == cursorEnd) {
-        std::cerr << "parser error : Empty attribute name" << '\n';
-        exit(1);
-    }
+    const auto eventStart = cursor;
+    const auto nameEnd = skipName(cursor);
+    if (nameEnd == cursorEnd)
+        error(cursor, "Empty attribute name");
     const std::string_view qName(std::addressof(*cursor), std::distance(cursor, nameEnd));
     auto colonPosition = qName.find(':');
-    if (colonPosition == 0) {
-        std::cerr << "parser error : Invalid attribute name " << qName << '\n';
-        exit(1);
-    }
+    if (colonPosition == 0)
+        error(cursor, "Invalid attribute name ", qName);
     if (colonPosition == std::string::npos)
         colonPosition = 0;
     const std::string_view prefix(std::addressof(*qName.cbegin()), colonPosition);
@@ -154,36 +200,29 @@ void XMLParser::parseAttribute()
         colonPosition += 1;
     const std::string_view localName(std::addressof(*qName.cbegin()) + colonPosition, qName.size() - colonPosition);
     cursor = nameEnd;
-    if (isspace(*cursor))
-        cursor = std::find_if_not(cursor, cursorEnd, isspace);
-    if (cursor == cursorEnd) {
-        std::cerr << "parser error : attribute " << qName << " incomplete attribute\n";
-        exit(1);
-    }
-    if (*cursor != '=') {
-        std::cerr << "parser error : attribute " << qName << " missing =\n";
-        exit(1);
-    }
+    if (isSpace(*cursor))
+        cursor = skipSpace(cursor);
+    if (cursor == cursorEnd)
+        error(eventStart, "attribute ", qName, " incomplete attribute");
+    if (*cursor != '=')
+        error(cursor, "attribute ", qName, " missing =");
     std::advance(cursor, 1);
-    if (isspace(*cursor))
-        cursor = std::find_if_not(cursor, cursorEnd, isspace);
+    if (isSpace(*cursor))
+        cursor = skipSpace(cursor);
     const auto delimiter = *cursor;
-    if (delimiter != '"' && delimiter != '\'') {
-        std::cerr << "parser error : attribute " << qName << " missing delimiter\n";
-        exit(1);
-    }
+    if (delimiter != '"' && delimiter != '\'')
+        error(cursor, "attribute ", qName, " missing delimiter");
     std::advance(cursor, 1);
     auto valueEnd = std::find(cursor, cursorEnd, delimiter);
-    if (valueEnd == cursorEnd) {
-        std::cerr << "parser error : attribute " << qName << " missing delimiter\n";
-        exit(1);
-    }
+    if (valueEnd == cursorEnd)
+        error(cursor, "attribute ", qName, " missing delimiter");
     const std::string_view value(std::addressof(*cursor), std::distance(cursor, valueEnd));
     TRACE("ATTRIBUTE", "prefix", prefix, "qname", qName, "localName", localName, "value", value);
+    setSource(EventLog::ATTRIBUTE, eventStart, std::next(valueEnd));
     handleAttribute(depth, qName, prefix, localName, value);
     cursor = std::next(valueEnd);
-    if (isspace(*cursor))
-        cursor = std::find_if_not(std::next(cursor), cursorEnd, isspace);
+    if (isSpace(*cursor))
+        cursor = skipSpace(std::next(cursor));
     if (*cursor == '>') {
         std::advance(cursor, 1);
         inTag = false;
@@ -192,6 +231,8 @@ void XMLParser::parseAttribute()
         std::advance(cursor, 2);
         TRACE("END TAG", "prefix", inTagPrefix, "qName", inTagQName, "localName", inTagLocalName);
         inTag = false;
+        setSource(EventLog::END_TAG, std::prev(cursor, 2), cursor);
+        handleEndTag(depth, inTagPrefix, inTagQName, inTagLocalName);
     }
 }
 
@@ -204,10 +245,9 @@ bool XMLParser::inXMLComment()
 // parse XML comment
 void XMLParser::parseXMLComment()
 {
-    if (cursor == cursorEnd) {
-        std::cerr << "parser error : Unterminated XML comment\n";
-        exit(1);
-    }
+    if (cursor == cursorEnd)
+        error(cursor, "Unterminated XML comment");
+    const auto eventStart = cursor;
     if (!isInXMLComment)
         std::advance(cursor, 4);
     constexpr std::string_view endComment = "-->"sv;
@@ -215,6 +255,7 @@ void XMLParser::parseXMLComment()
     isInXMLComment = tagEnd == cursorEnd;
     const std::string_view comment(std::addressof(*cursor), std::distance(cursor, tagEnd));
     TRACE("COMMENT", "comment", comment);
+    setSource(EventLog::COMMENT, eventStart, isInXMLComment ? tagEnd : std::next(tagEnd, endComment.size()));
     handleComment(depth, comment);
     if (!isInXMLComment)
         cursor = std::next(tagEnd, endComment.size());
@@ -231,19 +272,30 @@ bool XMLParser::inCDATA()
 // parse CDATA 
 void XMLParser::parseCDATA()
 {
-    if (cursor == cursorEnd) {
-        std::cerr << "parser error : Unterminated CDATA\n";
-        exit(1);
-    }
+    if (cursor == cursorEnd)
+        error(cursor, "Unterminated CDATA");
     constexpr std::string_view endCDATA = "]]>"sv;
+    const auto eventStart = cursor;
     if (!isInCDATA)
         std::advance(cursor, 9);
-    auto tagEnd = std::search(cursor, cursorEnd, endCDATA.begin(), endCDATA.end());
+    const char* const first = std::addressof(*cursor);
+    const char* const last = first + std::distance(cursor, cursorEnd);
+    const char* end = first;
+    int newlines = 0;
+    while (true) {
+        int spanNewlines = 0;
+        end = scanText(end, last, ']', ']', spanNewlines);
+        newlines += spanNewlines;
+        if (end == last || (end[1] == ']' && end[2] == '>'))
+            break;
+        ++end;
+    }
+    const auto tagEnd = std::next(cursor, end - first);
     isInCDATA = tagEnd == cursorEnd;
-    const std::string_view characters(std::addressof(*cursor), std::distance(cursor, tagEnd));
+    const std::string_view characters(first, end - first);
     TRACE("CDATA", "characters", characters);
-    handleCDATA(depth, characters);
-    cursor = std::next(tagEnd, endCDATA.size());
+    setSource(EventLog::CDATA, eventStart, isInCDATA ? tagEnd : std::next(tagEnd, endCDATA.size()));
+    handleCDATA(depth, characters, newlines);
     if (!isInCDATA)
         cursor = std::next(tagEnd, endCDATA.size());
     else
@@ -263,43 +315,29 @@ void XMLParser::parseXMLDeclaration()
     constexpr std::string_view endXMLDecl = "?>";
     auto tagEnd = std::find(cursor, cursorEnd, '>');
     if (tagEnd == cursorEnd) {
-        auto bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-        if (bytesRead < 0) {
-            std::cerr << "parser error : File input error\n";
-            exit(1);
-        }
-        totalBytes += bytesRead;
-        if ((tagEnd = std::find(cursor, cursorEnd, '>')) == cursorEnd) {
-            std::cerr << "parser error: Incomplete XML declaration\n";
-            exit(1);
-        }
+        refillAndAdjust();
+        if ((tagEnd = std::find(cursor, cursorEnd, '>')) == cursorEnd)
+            error(cursor, "Incomplete XML declaration");
     }
+    const auto eventStart = cursor;
     std::advance(cursor, startXMLDecl.size());
     cursor = std::find_if_not(cursor, tagEnd, isspace);
 
     // parse required version
-    if (cursor == tagEnd) {
-        std::cerr << "parser error: Missing space after before version in XML declaration\n";
-        exit(1);
-    }
+    if (cursor == tagEnd)
+        error(cursor, "Missing space after before version in XML declaration");
     auto nameEnd = std::find(cursor, tagEnd, '=');
     const std::string_view attr(std::addressof(*cursor), std::distance(cursor, nameEnd));
     cursor = std::next(nameEnd);
     const auto delimiter = *cursor;
-    if (delimiter != '"' && delimiter != '\'') {
-        std::cerr << "parser error: Invalid start delimiter for version in XML declaration\n";
-        exit(1);
-    }
+    if (delimiter != '"' && delimiter != '\'')
+        error(cursor, "Invalid start delimiter for version in XML declaration");
     std::advance(cursor, 1);
     auto valueEnd = std::find(cursor, tagEnd, delimiter);
-    if (valueEnd == tagEnd) {
-        std::cerr << "parser error: Invalid end delimiter for version in XML declaration\n";
-        exit(1);
-    }
-    if (attr != "version"sv) {
-        std::cerr << "parser error: Missing required first attribute version in XML declaration\n";
-        exit(1);
-    }
+    if (valueEnd == tagEnd)
+        error(cursor, "Invalid end delimiter for version in XML declaration");
+    if (attr != "version"sv)
+        error(cursor, "Missing required first attribute version in XML declaration");
     const std::string_view version(std::addressof(*cursor), std::distance(cursor, valueEnd));
     cursor = std::next(valueEnd);
     cursor = std::find_if_not(cursor, tagEnd, isspace);
@@ -309,66 +347,53 @@ void XMLParser::parseXMLDeclaration()
     std::optional<std::string_view> standalone;
     if (cursor != (tagEnd - 1)) {
         nameEnd = std::find(cursor, tagEnd, '=');
-        if (nameEnd == tagEnd) {
-            std::cerr << "parser error: Incomplete attribute in XML declaration\n";
-            exit(1);
-        }
+        if (nameEnd == tagEnd)
+            error(cursor, "Incomplete attribute in XML declaration");
         const std::string_view attr2(std::addressof(*cursor), std::distance(cursor, nameEnd));
         cursor = std::next(nameEnd);
         auto delimiter2 = *cursor;
-        if (delimiter2 != '"' && delimiter2 != '\'') {
-            std::cerr << "parser error: Invalid end delimiter for attribute " << attr2 << " in XML declaration\n";
-            exit(1);
-        }
+        if (delimiter2 != '"' && delimiter2 != '\'')
+            error(cursor, "Invalid end delimiter for attribute ", attr2, " in XML declaration");
         std::advance(cursor, 1);
         valueEnd = std::find(cursor, tagEnd, delimiter2);
-        if (valueEnd == tagEnd) {
-            std::cerr << "parser error: Incomplete attribute " << attr2 << " in XML declaration\n";
-            exit(1);
-        }
+        if (valueEnd == tagEnd)
+            error(cursor, "Incomplete attribute ", attr2, " in XML declaration");
         if (attr2 == "encoding"sv) {
             encoding = std::string_view(std::addressof(*cursor), std::distance(cursor, valueEnd));
         } else if (attr2 == "standalone"sv) {
             standalone = std::string_view(std::addressof(*cursor), std::distance(cursor, valueEnd));
         } else {
-            std::cerr << "parser error: Invalid attribute " << attr2 << " in XML declaration\n";
-            exit(1);
+            error(cursor, "Invalid attribute ", attr2, " in XML declaration");
         }
         cursor = std::next(valueEnd);
         cursor = std::find_if_not(cursor, tagEnd, isspace);
     }
     if (cursor != (tagEnd - endXMLDecl.size() + 1)) {
         nameEnd = std::find(cursor, tagEnd, '=');
-        if (nameEnd == tagEnd) {
-            std::cerr << "parser error: Incomplete attribute in XML declaration\n";
-            exit(1);
-        }
+        if (nameEnd == tagEnd)
+            error(cursor, "Incomplete attribute in XML declaration");
         const std::string_view attr2(std::addressof(*cursor), std::distance(cursor, nameEnd));
         cursor = std::next(nameEnd);
         const auto delimiter2 = *cursor;
-        if (delimiter2 != '"' && delimiter2 != '\'') {
-            std::cerr << "parser error: Invalid end delimiter for attribute " << attr2 << " in XML declaration\n";
-            exit(1);
-        }
+        if (delimiter2 != '"' && delimiter2 != '\'')
+            error(cursor, "Invalid end delimiter for attribute ", attr2, " in XML declaration");
         std::advance(cursor, 1);
         valueEnd = std::find(cursor, tagEnd, delimiter2);
-        if (valueEnd == tagEnd) {
-            std::cerr << "parser error: Incomplete attribute " << attr2 << " in XML declaration\n";
-            exit(1);
-        }
+        if (valueEnd == tagEnd)
+            error(cursor, "Incomplete attribute ", attr2, " in XML declaration");
         if (!standalone && attr2 == "standalone"sv) {
             standalone = std::string_view(std::addressof(*cursor), std::distance(cursor, valueEnd));
         } else {
-            std::cerr << "parser error: Invalid attribute " << attr2 << " in XML declaration\n";
-            exit(1);
+            error(cursor, "Invalid attribute ", attr2, " in XML declaration");
         }
         cursor = std::next(valueEnd);
         cursor = std::find_if_not(cursor, tagEnd, isspace);
     }
     TRACE("XML DECLARATION", "version", version, "encoding", (encoding ? *encoding : ""), "standalone", (standalone ? *standalone : ""));
+    setSource(EventLog::DECLARATION, eventStart, std::next(tagEnd));
     handleDeclaration(depth, version, encoding, standalone);
     std::advance(cursor, endXMLDecl.size());
-    cursor = std::find_if_not(cursor, cursorEnd, isspace);
+    cursor = skipSpace(cursor);
 }
 
 // predicate function determines if inside processing instruction
@@ -383,27 +408,20 @@ void XMLParser::parseProcessingInstruction()
     constexpr std::string_view endPI = "?>";
     auto tagEnd = std::search(cursor, cursorEnd, endPI.begin(), endPI.end());
     if (tagEnd == cursorEnd) {
-        auto bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-        if (bytesRead < 0) {
-            std::cerr << "parser error : File input error\n";
-            exit(1);
-        }
-        totalBytes += bytesRead;
-        if ((tagEnd = std::search(cursor, cursorEnd, endPI.begin(), endPI.end())) == cursorEnd) {
-            std::cerr << "parser error: Incomplete XML declaration\n";
-            exit(1);
-        }
+        refillAndAdjust();
+        if ((tagEnd = std::search(cursor, cursorEnd, endPI.begin(), endPI.end())) == cursorEnd)
+            error(cursor, "Incomplete XML declaration");
     }
+    const auto eventStart = cursor;
     std::advance(cursor, 2);
-    auto nameEnd = std::find_if_not(cursor, tagEnd, [] (char c) { return tagNameMaskTemp[c]; });
-    if (nameEnd == tagEnd) {
-        std::cerr << "parser error : Unterminated processing instruction '" << std::string_view(std::addressof(*cursor), std::distance(cursor, nameEnd)) << "'\n";
-        exit(1);
-    }
+    auto nameEnd = std::find_if_not(cursor, tagEnd, [] (char c) { return NAME_CHARACTERS[static_cast<unsigned char>(c)]; });
+    if (nameEnd == tagEnd)
+        error(eventStart, "Unterminated processing instruction '", std::string_view(std::addressof(*cursor), std::distance(cursor, nameEnd)), "'");
     const std::string_view target(std::addressof(*cursor), std::distance(cursor, nameEnd));
     cursor = std::find_if_not(nameEnd, tagEnd, isspace);
     const std::string_view data(std::addressof(*cursor), std::distance(cursor, tagEnd));
     TRACE("PI", "target", target, "data", data);
+    setSource(EventLog::PI, eventStart, std::next(tagEnd, endPI.size()));
     handlePI(depth, target, data);
     cursor = tagEnd;
     std::advance(cursor, 2);
@@ -421,45 +439,34 @@ void XMLParser::parseEndTag()
     if (std::distance(cursor, cursorEnd) < 100) {
         auto tagEnd = std::find(cursor, cursorEnd, '>');
         if (tagEnd == cursorEnd) {
-            auto bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-            if (bytesRead < 0) {
-                std::cerr << "parser error : File input error\n";
-                exit(1);
-            }
-            totalBytes += bytesRead;
-            if ((tagEnd = std::find(cursor, cursorEnd, '>')) == cursorEnd) {
-                std::cerr << "parser error: Incomplete element end tag\n";
-                exit(1);
-            }
+            refillAndAdjust();
+            if ((tagEnd = std::find(cursor, cursorEnd, '>')) == cursorEnd)
+                error(cursor, "Incomplete element end tag");
         }
     }
+    const auto eventStart = cursor;
     std::advance(cursor, 2);
-    if (*cursor == ':') {
-        std::cerr << "parser error : Invalid end tag name\n";
-        exit(1);
-    }
-    auto nameEnd = std::find_if_not(cursor, cursorEnd, [] (char c) { return tagNameMaskTemp[c]; });
-    if (nameEnd == cursorEnd) {
-        std::cerr << "parser error : Unterminated end tag '" << std::string_view(std::addressof(*cursor), std::distance(cursor, nameEnd)) << "'\n";
-        exit(1);
-    }
+    if (*cursor == ':')
+        error(cursor, "Invalid end tag name");
+    auto nameEnd = skipName(cursor);
+    if (nameEnd == cursorEnd)
+        error(eventStart, "Unterminated end tag '", std::string_view(std::addressof(*cursor), std::distance(cursor, nameEnd)), "'");
     size_t colonPosition = 0;
     if (*nameEnd == ':') {
         colonPosition = std::distance(cursor, nameEnd);
-        nameEnd = std::find_if_not(std::next(nameEnd), cursorEnd, [] (char c) { return tagNameMaskTemp[c]; });
+        nameEnd = skipName(std::next(nameEnd));
     }
     const std::string_view prefix(std::addressof(*cursor), colonPosition);
     const std::string_view qName(std::addressof(*cursor), std::distance(cursor, nameEnd));
-    if (qName.empty()) {
-        std::cerr << "parser error: EndTag: invalid element name\n";
-        exit(1);
-    }
+    if (qName.empty())
+        error(cursor, "EndTag: invalid element name");
     if (colonPosition)
         ++colonPosition;
     const std::string_view localName(std::addressof(*cursor) + colonPosition, std::distance(cursor, nameEnd) - colonPosition);
     cursor = std::next(nameEnd);
     --depth;
     TRACE("END TAG", "prefix", prefix, "qName", qName, "localName", localName);
+    setSource(EventLog::END_TAG, eventStart, cursor);
     handleEndTag(depth, prefix, qName, localName);
 }
 
@@ -475,57 +482,50 @@ void XMLParser::parseStartTag()
     if (std::distance(cursor, cursorEnd) < 200) {
         auto tagEnd = std::find(cursor, cursorEnd, '>');
         if (tagEnd == cursorEnd) {
-            auto bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-            if (bytesRead < 0) {
-                std::cerr << "parser error : File input error\n";
-                exit(1);
-            }
-            totalBytes += bytesRead;
-            if ((tagEnd = std::find(cursor, cursorEnd, '>')) == cursorEnd) {
-                std::cerr << "parser error: Incomplete element start tag\n";
-                exit(1);
-            }
+            refillAndAdjust();
+            if ((tagEnd = std::find(cursor, cursorEnd, '>')) == cursorEnd)
+                error(cursor, "Incomplete element start tag");
         }
     }
+    const auto eventStart = cursor;
     std::advance(cursor, 1);
-    if (*cursor == ':') {
-        std::cerr << "parser error : Invalid start tag name\n";
-        exit(1);
-    }
-    auto nameEnd = std::find_if_not(cursor, cursorEnd, [] (char c) { return tagNameMaskTemp[c]; });
-    if (nameEnd == cursorEnd) {
-        std::cerr << "parser error : Unterminated start tag '" << std::string_view(std::addressof(*cursor), std::distance(cursor, nameEnd)) << "'\n";
-        exit(1);
-    }
+    if (*cursor == ':')
+        error(cursor, "Invalid start tag name");
+    auto nameEnd = skipName(cursor);
+    if (nameEnd == cursorEnd)
+        error(eventStart, "Unterminated start tag '", std::string_view(std::addressof(*cursor), std::distance(cursor, nameEnd)), "'");
     size_t colonPosition = 0;
     if (*nameEnd == ':') {
         colonPosition = std::distance(cursor, nameEnd);
-        nameEnd = std::find_if_not(std::next(nameEnd), cursorEnd, [] (char c) { return tagNameMaskTemp[c]; });
+        nameEnd = skipName(std::next(nameEnd));
     }
     const std::string_view prefix(std::addressof(*cursor), colonPosition);
     const std::string_view qName(std::addressof(*cursor), std::distance(cursor, nameEnd));
-    if (qName.empty()) {
-        std::cerr << "parser error: StartTag: invalid element name\n";
-        exit(1);
-    }
+    if (qName.empty())
+        error(cursor, "StartTag: invalid element name");
     if (colonPosition)
         ++colonPosition;
     const std::string_view localName(std::addressof(*cursor) + colonPosition, std::distance(cursor, nameEnd) - colonPosition);
     TRACE("START TAG", "prefix", prefix, "qName", qName, "localName", localName);
+    setSource(EventLog::START_TAG, eventStart, nameEnd);
+    if (depth == 1)
+        unitArena.reset();
     handleStartTag(depth, qName, prefix, localName);
     cursor = nameEnd;
     if (*cursor != '>')
-        cursor = std::find_if_not(cursor, cursorEnd, isspace);
+        cursor = skipSpace(cursor);
     if (*cursor == '>') {
         std::advance(cursor, 1);
         ++depth;
     } else if (*cursor == '/' && cursor[1] == '>') {
         std::advance(cursor, 2);
         TRACE("END TAG", "prefix", prefix, "qName", qName, "localName", localName);
+        setSource(EventLog::END_TAG, std::prev(cursor, 2), cursor);
+        handleEndTag(depth, prefix, qName, localName);
     } else {
         inTagQName = qName;
         inTagPrefix = std::string_view(inTagQName.data(), prefix.size());
-        inTagLocalName = std::string_view(inTagQName.data() + prefix.size());
+        inTagLocalName = std::string_view(inTagQName.data() + (prefix.empty() ? 0 : prefix.size() + 1));
         inTag = true;
     }
 }
@@ -533,6 +533,7 @@ void XMLParser::parseStartTag()
 // parse character entity references
 void XMLParser::parseCharEntityRefs()
 {
+    const auto eventStart = cursor;
     std::string_view characters;
     if (cursor[1] == 'l' && cursor[2] == 't' && cursor[3] == ';') {
         characters = "<";
@@ -548,34 +549,47 @@ void XMLParser::parseCharEntityRefs()
         std::advance(cursor, 1);
     }
     TRACE("ENTITYREF", "characters", characters);
+    setSource(EventLog::CHAR_ENTITY_REF, eventStart, cursor);
     handleCER(depth, characters);
 }
 
 // parse non-character entity references
 void XMLParser::parseNonCER()
 {
-    const auto tagEnd = std::find_if(cursor, cursorEnd, [] (char c) { return c == '<' || c == '&'; });
-    const std::string_view characters(std::addressof(*cursor), std::distance(cursor, tagEnd));
+    const char* const first = std::addressof(*cursor);
+    int newlines = 0;
+    const char* const tagEnd = scanText(first, '<', '&', newlines);
+    const std::string_view characters(first, tagEnd - first);
     TRACE("CHARACTERS", "characters", characters);
-    handleNonCER(depth, characters);
+    setSource(EventLog::CHARACTERS, cursor, std::next(cursor, characters.size()));
+    handleNonCER(depth, characters, newlines);
     std::advance(cursor, characters.size());
 }
 
-// predicate function checks the length of our buffer for refill
+// predicate function checks the length of our buffer for refill,
+// long enough for the longest lookahead, "<![CDATA[". At the end of the
+// input, lookahead past the data reads the sentinel.
 bool XMLParser::isShort()
 {
-    return (std::distance(cursor, cursorEnd) < 5);
+    return (std::distance(cursor, cursorEnd) < 9);
 }
 
 // refill buffer and adjust iterator
 void XMLParser::refillAndAdjust()
 {
-    auto bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-    if (bytesRead < 0) {
-        std::cerr << "parser error : File input error\n";
-        exit(1);
-    }
+    if (handleBufferRelease)
+        handleBufferRelease(std::string_view(buffer.data(), std::distance(buffer.cbegin(), cursor)));
+    auto bytesRead = isDecoding ? decoder.refill(cursor, cursorEnd, buffer, SENTINEL_SIZE)
+                   : inputFD != -1 ? refillBuffer(cursor, cursorEnd, buffer, inputFD, SENTINEL_SIZE)
+                                   : refillBuffer(cursor, cursorEnd, buffer, input, SENTINEL_SIZE);
+    if (bytesRead < 0)
+        error(cursor, "File input error");
     totalBytes += bytesRead;
+    if (handleBytesRead) {
+        const long long read = isDecoding ? decoder.getBytesRead() - inputBytes : bytesRead;
+        inputBytes += read;
+        handleBytesRead(read);
+    }
 }
 
 // test for end of code
@@ -587,7 +601,7 @@ bool XMLParser::isEndOfCode()
 // parse characters before or after XML
 void XMLParser::parseBeforeOrAfter()
 {
-    cursor = std::find_if_not(cursor, cursorEnd, isspace);
+    cursor = skipSpace(cursor);
 }
 
 // check for Char Entity Refs
@@ -605,6 +619,8 @@ bool XMLParser::isBeforeOrAfter()
 void XMLParser::startTracing()
 {
     TRACE("START DOCUMENT");
+    if (trace)
+        trace->record(EventLog::START_DOCUMENT, depth, traceBase, 0);
     handleStart(depth);
 }
 
@@ -612,82 +628,276 @@ void XMLParser::startTracing()
 void XMLParser::stopTracing()
 {
     TRACE("END DOCUMENT");
+    if (trace)
+        trace->record(EventLog::END_DOCUMENT, depth, traceBase + totalBytes, 0);
     handleEnd(depth);
 }
 
 // Parsing loop with nested if's
 void XMLParser::parse()
 {
+    parse(0);
+}
+
+// Parse the XML read from file descriptor fd, reusing the existing buffer
+void XMLParser::parse(int fd)
+{
+    startParse(fd);
+    while (parseNext())
+        ;
+}
+
+// Parse a range of XML in memory that starts outside of any markup at
+// element depth startDepth, e.g., a part of a document split at a start tag.
+// Errors are located in the document of the range, when given.
+void XMLParser::parse(std::string_view range, int startDepth, std::string_view document)
+{
+    startParse(range, startDepth, document);
+    while (parseNext())
+        ;
+}
+
+// Start parsing the XML read from file descriptor fd, one parseNext() at a time
+void XMLParser::startParse(int fd)
+{
+    inputFD = fd;
+    input = std::string_view();
+    document = std::string_view();
+    traceBase = 0;
+    startInput(0);
+}
+
+// Start parsing a range of XML in memory at element depth startDepth,
+// one parseNext() at a time. Errors are located in the document of the
+// range, when given.
+void XMLParser::startParse(std::string_view range, int startDepth, std::string_view document)
+{
+    inputFD = -1;
+    input = range;
+    this->document = document;
+    traceBase = document.empty() ? 0 : range.data() - document.data();
+    startInput(startDepth);
+}
+
+// Start parsing the current input, starting at element depth startDepth
+void XMLParser::startInput(int startDepth)
+{
+    cursor = buffer.cbegin();
+    cursorEnd = buffer.cbegin();
+    writeSentinel(cursorEnd, buffer, SENTINEL_SIZE);
+    depth = startDepth;
+    inTag = false;
+    isInCDATA = false;
+    isInXMLComment = false;
+    totalBytes = 0;
+    inputBytes = 0;
+    unitArena.reset();
+    documentArena.reset();
+    if (isDecoding)
+        decoder.start(inputFD, input);
+
     startTracing();
-    while (true) {
-        if (isShort()) {
+}
 
-            // refill buffer and adjust iterator
-            refillAndAdjust();
+/*
+    Parse the next markup or text of the input, calling its handlers.
+    At the end of the input, releases the buffer and calls the end
+    document handler.
+    @return false at the end of the input, after which it is not called
+            again until the next startParse()
+*/
+bool XMLParser::parseNext()
+{
+    if (isShort()) {
 
-        } if (isEndOfCode()) {
-                break;
-        } else if (inXMLNS()) {
+        // refill buffer and adjust iterator
+        refillAndAdjust();
 
-            // parse XML namespace
-            parseXMLNS();
+    } if (isEndOfCode()) {
+        if (handleBufferRelease)
+            handleBufferRelease(std::string_view(buffer.data(), std::distance(buffer.cbegin(), cursor)));
+        stopTracing();
+        return false;
+    } else if (inXMLNS()) {
 
-        } else if (inAttribute()) {
+        // parse XML namespace
+        parseXMLNS();
 
-            // parse attribute
-            parseAttribute();
+    } else if (inAttribute()) {
 
-        } else if (inXMLComment()) {
+        // parse attribute
+        parseAttribute();
 
-            // parse XML comment
-            parseXMLComment();
+    } else if (inXMLComment()) {
 
-        } else if (inCDATA()) {
+        // parse XML comment
+        parseXMLComment();
 
-            // parse CDATA
-            parseCDATA();
+    } else if (inCDATA()) {
 
-        } else if (inXMLDeclaration()) {
+        // parse CDATA
+        parseCDATA();
 
-            // parse XML declaration
-            parseXMLDeclaration();
+    } else if (inXMLDeclaration()) {
 
-        } else if (inProcessingInstruction()) {
+        // parse XML declaration
+        parseXMLDeclaration();
 
-            // parse processing instruction
-            parseProcessingInstruction();
+    } else if (inProcessingInstruction()) {
 
-        } else if (inEndTag()) {
+        // parse processing instruction
+        parseProcessingInstruction();
 
-            // parse end tag
-            parseEndTag();
+    } else if (inEndTag()) {
 
-        } else if (inStartTag()) {
+        // parse end tag
+        parseEndTag();
 
-            // parse start tag
-            parseStartTag();
+    } else if (inStartTag()) {
 
-        } else if (isBeforeOrAfter()) {
+        // parse start tag
+        parseStartTag();
 
-            // parse characters before or after XML
-            parseBeforeOrAfter();
+    } else if (isBeforeOrAfter()) {
 
-        } else if (isCharEntityRef()) {
+        // parse characters before or after XML
+        parseBeforeOrAfter();
 
-            // parse character entity references
-            parseCharEntityRefs();
+    } else if (isCharEntityRef()) {
 
-        } else {
+        // parse character entity references
+        parseCharEntityRefs();
 
-            // parse character non-entity references (NonCER)
-            parseNonCER();
+    } else {
+
+        // parse character non-entity references (NonCER)
+        parseNonCER();
 
-        }
     }
-    stopTracing();
+    return true;
+}
+
+// decode the input of the following parses to validated UTF-8,
+// detecting UTF-16 from a BOM or the XML declaration
+void XMLParser::setDecoding(bool isDecoding)
+{
+    this->isDecoding = isDecoding;
+}
+
+// attach a trace of the events of the following parses, or detach it with nullptr
+void XMLParser::setTrace(EventTrace* trace)
+{
+    this->trace = trace;
+}
+
+// set the handler for the parsed part of the buffer, called before the
+// buffer is refilled and at the end of the input
+void XMLParser::setBufferReleaseHandler(std::function<void(std::string_view parsed)> bufferReleaseHandler)
+{
+    handleBufferRelease = bufferReleaseHandler;
+}
+
+// set the handler for the bytes of the input read by each refill of
+// the buffer, before decoding, e.g., for progress
+void XMLParser::setBytesReadHandler(std::function<void(long long bytesRead)> bytesReadHandler)
+{
+    handleBytesRead = bytesReadHandler;
+}
+
+// set the handler for parse errors, called with the message and the offset in
+// the input instead of reporting the error and exiting. The handler does not
+// return, e.g., it throws, and the parse is abandoned until the next startParse().
+void XMLParser::setErrorHandler(std::function<void(std::string_view message, long long offset)> errorHandler)
+{
+    handleError = errorHandler;
+}
+
+// raw source of the current event, valid only during its handler
+std::string_view XMLParser::getEventSource() const
+{
+    return source;
+}
+
+// offset in the input of the start of the current event, from the
+// total bytes read, which ends at cursorEnd
+long long XMLParser::getEventOffset() const
+{
+    const char* const bufferEnd = buffer.data() + std::distance(buffer.cbegin(), cursorEnd);
+    return totalBytes - (bufferEnd - source.data());
+}
+
+/*
+    Write the diagnostic of a parse error at position in the buffer, and exit.
+    Only the offset is tracked while parsing, so the line and column are
+    found now, from the input in memory, or the start of the input when
+    the buffer still holds it, else by rereading the input file, else only
+    the column from a newline in the buffer. With decoding, the offset is
+    mapped back through the decoder to an offset in the input, as the
+    offsets of the errors of the decoder.
+    @param[in] message Message of the error
+    @param[in] position Position of the error in the buffer
+*/
+void XMLParser::reportError(std::string_view message, std::string::const_iterator position) const
+{
+    const char* const first = buffer.data();
+    const char* const errorPosition = first + std::distance(buffer.cbegin(), position);
+    const char* const last = first + std::distance(buffer.cbegin(), cursorEnd);
+    const long long inputOffset = isDecoding ? decoder.inputOffset(std::string_view(errorPosition, last - errorPosition))
+                                             : totalBytes - std::distance(position, cursorEnd);
+    if (handleError)
+        handleError(message, inputOffset);
+    ParseDiagnostic diagnostic;
+    diagnostic.message = message;
+    diagnostic.offset = totalBytes - std::distance(position, cursorEnd);
+    const std::string_view window(first, errorPosition - first);
+    if (inputFD == -1 && !isDecoding) {
+        // input in memory is advanced past the bytes read
+        const char* const rangeStart = input.data() - totalBytes;
+        if (!document.empty())
+            diagnostic.offset += rangeStart - document.data();
+        locate(diagnostic, std::string_view(document.empty() ? rangeStart : document.data(), diagnostic.offset), true);
+    } else if (diagnostic.offset == static_cast<long long>(window.size())) {
+        locate(diagnostic, window, true);
+    } else if (isDecoding || !locateInFile(diagnostic, inputFD)) {
+        locate(diagnostic, window, false);
+    }
+    if (isDecoding)
+        diagnostic.offset = inputOffset;
+    setSnippet(diagnostic, first, errorPosition, last);
+    writeDiagnostic(std::cerr, diagnostic);
+    EventTrace::dumpAll();
+    exit(1);
+}
+
+// set the raw source of the current event of the kind to [first, last), and trace it
+void XMLParser::setSource(EventLog::Kind kind, std::string::const_iterator first, std::string::const_iterator last)
+{
+    source = std::string_view(std::addressof(*first), std::distance(first, last));
+    if (trace)
+        traceEvent(kind);
+}
+
+// record the current event of the kind in the trace, apart from setSource() so
+// it stays small enough to inline into the parse of each event
+void XMLParser::traceEvent(EventLog::Kind kind)
+{
+    trace->record(kind, depth, traceBase + XMLParser::getEventOffset(), source.size());
 }
 
 // get method for total bytes
-long XMLParser::getTotalBytes() {
+long long XMLParser::getTotalBytes() const {
     return totalBytes;
 }
+
+// copy of a value of an event that stays valid for the lifetime, until the
+// next start tag at depth 1, or the start of the next document
+std::string_view XMLParser::retain(std::string_view value, Lifetime lifetime) const
+{
+    return (lifetime == UNIT ? unitArena : documentArena).store(value);
+}
+
+// arena of the values retained for the lifetime, for its statistics
+const Arena& XMLParser::getRetainArena(Lifetime lifetime) const
+{
+    return lifetime == UNIT ? unitArena : documentArena;
+}
@@ -12,8 +12,12 @@
 #include <functional>
 #include <string_view>
 #include <optional>
+#include "EventContext.hpp"
+#include "Arena.hpp"
+#include "InputDecoder.hpp"
+#include "EventTrace.hpp"
 
-class XMLParser
+class XMLParser : public EventContext
 {
 
 private:
@@ -27,12 +31,31 @@ private:
     std::string_view inTagLocalName;
     bool isInCDATA;
     bool isInXMLComment;
-    long totalBytes;
+    long long totalBytes;
+    int inputFD;
+    std::string_view input;
+    std::string_view source;
+
+    // whole document of an input range in memory, for the position of errors
+    std::string_view document;
+
+    // input decoded to validated UTF-8 by the decoder, instead of read as is
+    bool isDecoding;
+    InputDecoder decoder;
+
+    // trace of the events, when one is attached, and the offset of the
+    // input in its document, so traced offsets are of the document
+    EventTrace* trace;
+    long long traceBase;
+
+    // values retained by handlers, changed by the const retain() of the context
+    mutable Arena unitArena;
+    mutable Arena documentArena;
 
     std::function<void(int depth, std::string_view qName, std::string_view prefix, std::string_view localName)> handleStartTag;
     std::function<void(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value)> handleAttribute;
-    std::function<void(int depth, std::string_view characters)> handleNonCER;
-    std::function<void(int depth, std::string_view characters)> handleCDATA;
+    std::function<void(int depth, std::string_view characters, int newlines)> handleNonCER;
+    std::function<void(int depth, std::string_view characters, int newlines)> handleCDATA;
     std::function<void(int depth, std::string_view characters)> handleCER;
     std::function<void(int depth, std::string_view prefix, std::string_view uri)> handleNamespace;
     std::function<void(int depth, std::string_view comment)> handleComment;
@@ -41,14 +64,20 @@ private:
     std::function<void(int depth, std::string_view prefix, std::string_view qName, std::string_view localName)> handleEndTag;
     std::function<void(int depth)> handleStart;
     std::function<void(int depth)> handleEnd;
+    std::function<void(std::string_view parsed)> handleBufferRelease;
+    std::function<void(long long bytesRead)> handleBytesRead;
+    std::function<void(std::string_view message, long long offset)> handleError;
+
+    // bytes of the input read, before decoding
+    long long inputBytes;
 
 public:
     // parameterized XMLParser constructor
     XMLParser(
         std::function<void(int depth, std::string_view qName, std::string_view prefix, std::string_view localName)> handleStartTag, 
         std::function<void(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value)> handleAttribute,
-        std::function<void(int depth, std::string_view characters)> handleNonCER,
-        std::function<void(int depth, std::string_view characters)> handleCDATA,
+        std::function<void(int depth, std::string_view characters, int newlines)> handleNonCER,
+        std::function<void(int depth, std::string_view characters, int newlines)> handleCDATA,
         std::function<void(int depth, std::string_view characters)> handleCER,
         std::function<void(int depth, std::string_view prefix, std::string_view uri)> handleNamespace,
         std::function<void(int depth, std::string_view comment)> handleComment,
@@ -138,12 +167,81 @@ private:
     // end trace macro on document
     void stopTracing();
 
+    // Start parsing the current input, starting at element depth startDepth
+    void startInput(int startDepth);
+
+    // set the raw source of the current event of the kind to [first, last), and trace it
+    void setSource(EventLog::Kind kind, std::string::const_iterator first, std::string::const_iterator last);
+
+    // record the current event of the kind in the trace
+    void traceEvent(EventLog::Kind kind);
+
+    // parse error at position in the buffer, with a message of the parts
+    template <typename... Parts>
+    [[noreturn]] void error(std::string::const_iterator position, const Parts&... parts) const;
+
+    // write the diagnostic of a parse error at position in the buffer, with
+    // its line and column found now, and exit
+    [[noreturn]] void reportError(std::string_view message, std::string::const_iterator position) const;
+
 public:
     // Parsing loop with nested if's
     void parse();
 
+    // Parse the XML read from file descriptor fd, reusing the existing buffer
+    void parse(int fd);
+
+    // Parse a range of XML in memory that starts outside of any markup at
+    // element depth startDepth, e.g., a part of a document split at a start tag.
+    // Errors are located in the document of the range, when given.
+    void parse(std::string_view range, int startDepth, std::string_view document = std::string_view());
+
+    // Start parsing the XML read from file descriptor fd, one parseNext() at a time
+    void startParse(int fd);
+
+    // Start parsing a range of XML in memory at element depth startDepth,
+    // one parseNext() at a time. Errors are located in the document of the
+    // range, when given.
+    void startParse(std::string_view range, int startDepth, std::string_view document = std::string_view());
+
+    // Parse the next markup or text, calling its handlers, with false at
+    // the end of the input. The handlers of a single call see the same buffer.
+    bool parseNext();
+
+    // decode the input of the following parses to validated UTF-8,
+    // detecting UTF-16 from a BOM or the XML declaration
+    void setDecoding(bool isDecoding);
+
+    // attach a trace of the events of the following parses, or detach it with nullptr
+    void setTrace(EventTrace* trace);
+
+    // set the handler for the parsed part of the buffer, called before the
+    // buffer is refilled and at the end of the input
+    void setBufferReleaseHandler(std::function<void(std::string_view parsed)> bufferReleaseHandler);
+
+    // set the handler for the bytes of the input read by each refill of
+    // the buffer, before decoding, e.g., for progress
+    void setBytesReadHandler(std::function<void(long long bytesRead)> bytesReadHandler);
+
+    // set the handler for parse errors, called with the message and the offset in
+    // the input instead of reporting the error and exiting. The handler does not
+    // return, e.g., it throws, and the parse is abandoned until the next startParse().
+    void setErrorHandler(std::function<void(std::string_view message, long long offset)> errorHandler);
+
+    // raw source of the current event, valid only during its handler
+    std::string_view getEventSource() const override;
+
+    // offset in the input of the start of the current event
+    long long getEventOffset() const override;
+
     // Get method for total bytes
-    long getTotalBytes();
+    long long getTotalBytes() const override;
+
+    // copy of a value of an event that stays valid for the lifetime
+    std::string_view retain(std::string_view value, Lifetime lifetime) const override;
+
+    // arena of the values retained for the lifetime, for its statistics
+    const Arena& getRetainArena(Lifetime lifetime) const;
 };
 
 #endif
@@ -0,0 +1,83 @@
+/*
+    XMLStatsHandler.cpp
+
+    Implementation file for the xmlstats handler of XMLParser events
+*/
+
+#include "XMLStatsHandler.hpp"
+#include "FactCounters.hpp"
+#include <iomanip>
+#include <algorithm>
+
+namespace {
+
+    // output a markdown table of the counts of each name
+    void outputNames(std::ostream& out, const char* title, const char* column, const NameTable& names) {
+
+        out << "## " << title << "\n";
+        out << "| " << column << " | Count |\n";
+        out << "|:--|--:|\n";
+        for (const auto& entry : names.sorted())
+            out << "| " << entry.name << " | " << entry.count << " |\n";
+        out << "\n";
+    }
+
+    // output a markdown table of a size histogram
+    void outputHistogram(std::ostream& out, const char* title, const XMLStatsHandler::SizeHistogram& histogram) {
+
+        out << "## " << title << "\n";
+        out << "| Bytes | Count |\n";
+        out << "|--:|--:|\n";
+        for (std::size_t i = 0; i < histogram.counts.size(); ++i) {
+            if (!histogram.counts[i])
+                continue;
+            const std::uint64_t low = i ? 1ULL << (i - 1) : 0;
+            const std::uint64_t high = i ? (low << 1) - 1 : 0;
+            out << "| " << low;
+            if (high != low)
+                out << "-" << high;
+            out << " | " << histogram.counts[i] << " |\n";
+        }
+        out << "\n";
+    }
+}
+
+// output the markdown report of the counts and the structure
+void XMLStatsHandler::report(std::ostream& out) const
+{
+    // output xml stats
+    out << "\n\n";
+    const int valueWidth = std::max(6, reportWidth(std::max({ XMLNSCount, attributeCount, XMLCommentCount, CDATACount,
+        XMLDeclarationCount, PICount, endTagCount, startTagCount, beforeOrAfterCount, CERCount, nonCERCount })));
+    out << "# XMLStats:\n";
+    out << "| Measure        | " << std::setw(valueWidth + 3) << "Value |\n";
+    out << "|:---------------|-" << std::setw(valueWidth + 3) << std::setfill('-') << ":|\n" << std::setfill(' ');
+    out << "| XML Namespaces | " << std::setw(valueWidth) << XMLNSCount          << " |\n";
+    out << "| attributes     | " << std::setw(valueWidth) << attributeCount      << " |\n";
+    out << "| Comments       | " << std::setw(valueWidth) << XMLCommentCount     << " |\n";
+    out << "| CDATA          | " << std::setw(valueWidth) << CDATACount          << " |\n";
+    out << "| Declarations   | " << std::setw(valueWidth) << XMLDeclarationCount << " |\n";
+    out << "| PI's           | " << std::setw(valueWidth) << PICount             << " |\n";
+    out << "| End Tags       | " << std::setw(valueWidth) << endTagCount         << " |\n";
+    out << "| Start Tags     | " << std::setw(valueWidth) << startTagCount       << " |\n";
+    out << "| Before or After| " << std::setw(valueWidth) << beforeOrAfterCount  << " |\n";
+    out << "| CER's          | " << std::setw(valueWidth) << CERCount            << " |\n";
+    out << "| Non CER's      | " << std::setw(valueWidth) << nonCERCount         << " |\n";
+    out << "\n";
+
+    // output xml structure
+    outputNames(out, "Elements", "Element", elementNames);
+    outputNames(out, "Attributes", "Attribute", attributeNames);
+
+    out << "## Depth\n";
+    out << "Max depth: " << (depthCounts.empty() ? 0 : depthCounts.size() - 1) << "\n\n";
+    out << "| Depth | Start Tags |\n";
+    out << "|--:|--:|\n";
+    for (std::size_t depth = 0; depth < depthCounts.size(); ++depth)
+        out << "| " << depth << " | " << depthCounts[depth] << " |\n";
+    out << "\n";
+
+    outputHistogram(out, "Attribute Value Sizes", attributeValueSizes);
+    outputHistogram(out, "Text Sizes", textSizes);
+    out << "\n";
+}
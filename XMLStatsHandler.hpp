@@ -0,0 +1,117 @@
+/*
+    XMLStatsHandler.hpp
+
+    Include file for the xmlstats handler of XMLParser events
+
+    Counts each part of XML, each element and attribute name, the start
+    tags at each depth, and the sizes of attribute values and text, and
+    outputs them as a markdown report.
+*/
+
+#ifndef INCLUDED_XMLSTATSHANDLER_HPP
+#define INCLUDED_XMLSTATSHANDLER_HPP
+
+#include "NameTable.hpp"
+#include <ostream>
+#include <string_view>
+#include <optional>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+class XMLStatsHandler
+{
+
+public:
+    // histogram of sizes in power of 2 buckets: 0, 1, 2-3, 4-7, ...
+    struct SizeHistogram {
+        std::array<std::int64_t, 65> counts{};
+
+        // count a size
+        void add(std::size_t size) {
+            ++counts[size ? 64 - __builtin_clzll(size) : 0];
+        }
+    };
+
+private:
+    std::int64_t XMLNSCount = 0;
+    std::int64_t attributeCount = 0;
+    std::int64_t XMLCommentCount = 0;
+    std::int64_t CDATACount = 0;
+    std::int64_t XMLDeclarationCount = 0;
+    std::int64_t PICount = 0;
+    std::int64_t endTagCount = 0;
+    std::int64_t startTagCount = 0;
+    std::int64_t beforeOrAfterCount = 0;
+    std::int64_t CERCount = 0;
+    std::int64_t nonCERCount = 0;
+
+    NameTable elementNames;
+    NameTable attributeNames;
+    std::vector<std::int64_t> depthCounts;
+    SizeHistogram attributeValueSizes;
+    SizeHistogram textSizes;
+
+public:
+    // count a start tag, its name, and its depth
+    void startTag(int depth, std::string_view qName, std::string_view prefix, std::string_view localName) {
+        ++startTagCount;
+        ++elementNames[qName];
+        if (depth >= static_cast<int>(depthCounts.size()))
+            depthCounts.resize(depth + 1);
+        ++depthCounts[depth];
+    }
+
+    // count an attribute, its name, and the size of its value
+    void attribute(int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value) {
+        ++attributeCount;
+        ++attributeNames[qName];
+        attributeValueSizes.add(value.size());
+    }
+
+    // count text and its size
+    void characters(int depth, std::string_view characters, int newlines) {
+        ++nonCERCount;
+        textSizes.add(characters.size());
+    }
+
+    // count CDATA
+    void cdata(int depth, std::string_view characters, int newlines) {
+        ++CDATACount;
+    }
+
+    // count a character entity reference
+    void charEntityRef(int depth, std::string_view characters) {
+        ++CERCount;
+    }
+
+    // count a namespace declaration
+    void namespaceDeclaration(int depth, std::string_view prefix, std::string_view uri) {
+        ++XMLNSCount;
+    }
+
+    // count an XML comment
+    void comment(int depth, std::string_view comment) {
+        ++XMLCommentCount;
+    }
+
+    // count an XML declaration
+    void declaration(int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone) {
+        ++XMLDeclarationCount;
+    }
+
+    // count a processing instruction
+    void processingInstruction(int depth, std::string_view target, std::string_view data) {
+        ++PICount;
+    }
+
+    // count an end tag
+    void endTag(int depth, std::string_view prefix, std::string_view qName, std::string_view localName) {
+        ++endTagCount;
+    }
+
+    // output the markdown report of the counts and the structure
+    void report(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,271 @@
+/*
+    eventbench.cpp
+
+    Benchmark of the per-event overhead of the interfaces to XMLParser
+    events: the std::function handlers of XMLParser, the XMLEvents
+    coroutine generator, and a templated direct call.
+
+    Input is an XML file on stdin, parsed from memory. The parse table
+    compares a full parse with handlers and with the generator. The
+    dispatch table replays the recorded events of the parse through a
+    std::function, a template parameter called directly, and a
+    generator, to separate the cost of the interface from the parse.
+
+    Each consumer counts the events of each kind, and the characters
+    and newlines of text. All consumers must agree.
+
+    Usage: eventbench [--runs N] < file.xml
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <functional>
+#include <cstdint>
+#include <cstdlib>
+#include <unistd.h>
+#include "XMLParser.hpp"
+#include "XMLEvents.hpp"
+#include "Generator.hpp"
+#include "FramePool.hpp"
+
+using namespace std::literals::string_view_literals;
+
+// counts of events of each kind, and of the characters and newlines in text
+struct EventCounts {
+    std::array<std::int64_t, XMLEvent::PI + 1> counts{};
+    std::int64_t characters = 0;
+    std::int64_t newlines = 0;
+    std::int64_t depths = 0;
+
+    // count a single event
+    void add(XMLEvent::Kind kind, int depth, std::size_t size, int newlineCount) {
+        ++counts[kind];
+        characters += size;
+        newlines += newlineCount;
+        depths += depth;
+    }
+
+    bool operator==(const EventCounts& other) const {
+        return counts == other.counts && characters == other.characters && newlines == other.newlines && depths == other.depths;
+    }
+
+    // total number of events
+    std::int64_t total() const {
+        std::int64_t sum = 0;
+        for (const auto count : counts)
+            sum += count;
+        return sum;
+    }
+};
+
+// an event of the parse without its text, for replay
+struct RecordedEvent {
+    XMLEvent::Kind kind;
+    int depth;
+    std::uint32_t size;
+    int newlines;
+};
+
+// best time in seconds of the runs of a function
+template <typename Function>
+double bestTime(int runs, Function function) {
+
+    double best = 0;
+    for (int run = 0; run < runs; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = run ? std::min(best, seconds) : seconds;
+    }
+    return best;
+}
+
+// parse with the std::function handlers of XMLParser
+EventCounts parseHandlers(XMLParser& parser, std::string_view document, EventCounts& counts) {
+
+    counts = EventCounts();
+    parser.parse(document, 0);
+    return counts;
+}
+
+// parse with the XMLEvents generator
+EventCounts parseGenerator(XMLEvents& events, std::string_view document) {
+
+    EventCounts counts;
+    for (const auto& event : events.parse(document, 0)) {
+        switch (event.kind) {
+        case XMLEvent::CHARACTERS:
+        case XMLEvent::CDATA:
+            counts.add(event.kind, event.depth, event.value.size(), event.newlines);
+            break;
+        case XMLEvent::CER:
+            counts.add(event.kind, event.depth, event.value.size(), 0);
+            break;
+        default:
+            counts.add(event.kind, event.depth, 0, 0);
+        }
+    }
+    return counts;
+}
+
+// replay through a std::function
+__attribute__((noinline)) void replayFunction(const std::vector<RecordedEvent>& events, const std::function<void(const RecordedEvent&)>& handler) {
+
+    for (const auto& event : events)
+        handler(event);
+}
+
+// replay through a handler called directly, inlined at compile time
+template <typename Handler>
+__attribute__((noinline)) void replayDirect(const std::vector<RecordedEvent>& events, Handler&& handler) {
+
+    for (const auto& event : events)
+        handler(event);
+}
+
+// replay through a generator
+Generator<RecordedEvent> replayGenerator(const std::vector<RecordedEvent>& events) {
+
+    for (const auto& event : events)
+        co_yield event;
+}
+
+// output a row of a markdown table
+void outputRow(std::string_view name, double seconds, std::int64_t events, double megabytes) {
+
+    std::cout << "| " << std::setw(10) << std::left << name << " | " << std::right << std::fixed
+              << std::setw(8) << std::setprecision(2) << seconds * 1e9 / events << " |";
+    if (megabytes > 0)
+        std::cout << " " << std::setw(8) << std::setprecision(1) << megabytes / seconds << " |";
+    std::cout << '\n';
+}
+
+int main(int argc, char* argv[]) {
+
+    int runs = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i] == "--runs"sv && i + 1 < argc) {
+            runs = std::max(1, atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: eventbench [--runs N] < file.xml\n";
+            return 1;
+        }
+    }
+
+    // whole input in memory, so reading does not count
+    std::string document;
+    char block[64 * 1024];
+    ssize_t size;
+    while ((size = read(0, block, sizeof(block))) > 0)
+        document.append(block, size);
+    if (size < 0) {
+        std::cerr << "eventbench: Unable to read input\n";
+        return 1;
+    }
+    const double megabytes = document.size() / 1000000.0;
+
+    // handlers recording the events and counting them
+    EventCounts handlerCounts;
+    std::vector<RecordedEvent> recorded;
+    bool isRecording = true;
+    auto handle = [&](XMLEvent::Kind kind, int depth, std::size_t size, int newlines) {
+        handlerCounts.add(kind, depth, size, newlines);
+        if (isRecording)
+            recorded.push_back({ kind, depth, static_cast<std::uint32_t>(size), newlines });
+    };
+    XMLParser parser(
+        [&](int depth, std::string_view, std::string_view, std::string_view) {
+            handle(XMLEvent::START_TAG, depth, 0, 0);
+        },
+        [&](int depth, std::string_view, std::string_view, std::string_view, std::string_view) {
+            handle(XMLEvent::ATTRIBUTE, depth, 0, 0);
+        },
+        [&](int depth, std::string_view characters, int newlines) {
+            handle(XMLEvent::CHARACTERS, depth, characters.size(), newlines);
+        },
+        [&](int depth, std::string_view characters, int newlines) {
+            handle(XMLEvent::CDATA, depth, characters.size(), newlines);
+        },
+        [&](int depth, std::string_view characters) {
+            handle(XMLEvent::CER, depth, characters.size(), 0);
+        },
+        [&](int depth, std::string_view, std::string_view) {
+            handle(XMLEvent::NAMESPACE, depth, 0, 0);
+        },
+        [&](int depth, std::string_view) {
+            handle(XMLEvent::COMMENT, depth, 0, 0);
+        },
+        [&](int depth, std::string_view, std::optional<std::string_view>, std::optional<std::string_view>) {
+            handle(XMLEvent::DECLARATION, depth, 0, 0);
+        },
+        [&](int depth, std::string_view, std::string_view) {
+            handle(XMLEvent::PI, depth, 0, 0);
+        },
+        [&](int depth, std::string_view, std::string_view, std::string_view) {
+            handle(XMLEvent::END_TAG, depth, 0, 0);
+        },
+        [&](int depth) {
+            handle(XMLEvent::START_DOCUMENT, depth, 0, 0);
+        },
+        [&](int depth) {
+            handle(XMLEvent::END_DOCUMENT, depth, 0, 0);
+        }
+    );
+    const EventCounts expected = parseHandlers(parser, document, handlerCounts);
+    isRecording = false;
+    const std::int64_t eventCount = expected.total();
+
+    // full parse with each interface
+    XMLEvents events;
+    const long long startAllocations = FramePool::getAllocations();
+    EventCounts counts;
+    const double handlerSeconds = bestTime(runs, [&]() { counts = parseHandlers(parser, document, handlerCounts); });
+    bool isSame = counts == expected;
+    const double generatorSeconds = bestTime(runs, [&]() { counts = parseGenerator(events, document); });
+    isSame = isSame && counts == expected;
+
+    // replay of the recorded events with each interface
+    auto count = [&counts](const RecordedEvent& event) {
+        counts.add(event.kind, event.depth, event.size, event.newlines);
+    };
+    const std::function<void(const RecordedEvent&)> function = count;
+    const double functionSeconds = bestTime(runs, [&]() { counts = EventCounts(); replayFunction(recorded, function); });
+    isSame = isSame && counts == expected;
+    const double directSeconds = bestTime(runs, [&]() { counts = EventCounts(); replayDirect(recorded, count); });
+    isSame = isSame && counts == expected;
+    const double replaySeconds = bestTime(runs, [&]() {
+        counts = EventCounts();
+        for (const auto& event : replayGenerator(recorded))
+            count(event);
+    });
+    isSame = isSame && counts == expected;
+    const long long frameAllocations = FramePool::getAllocations() - startAllocations;
+
+    if (!isSame) {
+        std::cerr << "eventbench: Event counts differ between interfaces\n";
+        return 1;
+    }
+
+    std::cout << "# eventbench: " << eventCount << " events, " << std::fixed << std::setprecision(1) << megabytes << " MB\n\n";
+    std::cout << "## Parse\n";
+    std::cout << "| Interface  | ns/event |     MB/s |\n";
+    std::cout << "|:-----------|---------:|---------:|\n";
+    outputRow("Handlers", handlerSeconds, eventCount, megabytes);
+    outputRow("Generator", generatorSeconds, eventCount, megabytes);
+    std::cout << '\n';
+    std::cout << "## Dispatch\n";
+    std::cout << "| Interface  | ns/event |\n";
+    std::cout << "|:-----------|---------:|\n";
+    outputRow("Function", functionSeconds, eventCount, 0);
+    outputRow("Direct", directSeconds, eventCount, 0);
+    outputRow("Generator", replaySeconds, eventCount, 0);
+    std::cout << '\n';
+    std::cout << "Coroutine frames allocated: " << frameAllocations << " for " << 2 * runs << " generators\n";
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+    eventlog.cpp
+
+    Parse once, replay many: records the events of a parse of XML to a
+    binary event log, and replays the log to the srcFacts and xmlstats
+    handlers without parsing.
+
+    Input is an XML file in the srcML format on stdin. For replay, it is
+    the file the log was recorded from, and must be a regular file.
+
+    record writes the log of the input to LOG. replay outputs the srcFacts
+    report followed by the xmlstats report on stdout, as fanout does, and
+    with --identity the identity copy of the input to a file.
+
+    Output performance statistics to stderr.
+
+    Usage: eventlog record LOG < file.xml
+           eventlog replay [--identity IDENTITY_OUTPUT] LOG < file.xml
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string_view>
+#include <optional>
+#include <fcntl.h>
+#include <unistd.h>
+#include "CompositeHandler.hpp"
+#include "EventLogWriter.hpp"
+#include "EventLogReader.hpp"
+#include "FactsHandler.hpp"
+#include "XMLStatsHandler.hpp"
+#include "IdentityHandler.hpp"
+
+using namespace std::literals::string_view_literals;
+
+int main(int argc, char* argv[]) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // command line: record LOG, or replay [--identity IDENTITY_OUTPUT] LOG
+    const bool isRecord = argc > 1 && argv[1] == "record"sv;
+    const bool isReplay = argc > 1 && argv[1] == "replay"sv;
+    const char* logPath = nullptr;
+    int identityFD = -1;
+    for (int i = 2; i < argc; ++i) {
+        if (isReplay && argv[i] == "--identity"sv && i + 1 < argc) {
+            identityFD = open(argv[++i], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (identityFD == -1) {
+                std::cerr << "eventlog: Unable to open " << argv[i] << '\n';
+                return 1;
+            }
+        } else if (!logPath) {
+            logPath = argv[i];
+        } else {
+            logPath = nullptr;
+            break;
+        }
+    }
+    if ((!isRecord && !isReplay) || !logPath) {
+        std::cerr << "Usage: eventlog record LOG < file.xml\n";
+        std::cerr << "       eventlog replay [--identity IDENTITY_OUTPUT] LOG < file.xml\n";
+        return 1;
+    }
+
+    // record a single parse of stdin
+    if (isRecord) {
+        const int logFD = open(logPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (logFD == -1) {
+            std::cerr << "eventlog: Unable to open " << logPath << '\n';
+            return 1;
+        }
+        EventLogWriter writer(logFD);
+        CompositeHandler<EventLogWriter> parser(writer);
+        parser.parse(0);
+        close(logFD);
+
+        const auto finish = std::chrono::steady_clock::now();
+        const auto elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double> >(finish - start).count();
+        const long long sourceBytes = parser.getParser().getTotalBytes();
+        std::clog << writer.getEventCount() << " events\n";
+        std::clog << sourceBytes << " source bytes\n";
+        std::clog << writer.getBytesWritten() << " log bytes\n";
+        std::clog << std::setprecision(3) << elapsed_seconds << " sec\n";
+        std::clog << std::setprecision(3) << sourceBytes / elapsed_seconds / 1000000 << " MB/sec source\n";
+        return 0;
+    }
+
+    // replay of the log of stdin to the handlers
+    FileFacts file;
+    file.path = "-";
+    file.ranges.resize(1);
+    XMLStatsHandler stats;
+    EventLogReader reader(logPath, 0);
+    const auto replayStart = std::chrono::steady_clock::now();
+    {
+        FactsHandler facts;
+        facts.startRange(file.path);
+        if (identityFD != -1) {
+            IdentityHandler identity(identityFD, false);
+            reader.replay(facts, stats, identity);
+        } else {
+            reader.replay(facts, stats);
+        }
+        facts.finishRange(file.ranges.front());
+    }
+    if (identityFD != -1)
+        close(identityFD);
+    finishFile(file);
+
+    const auto finish = std::chrono::steady_clock::now();
+    const auto elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double> >(finish - start).count();
+    const auto replay_seconds = std::chrono::duration_cast<std::chrono::duration<double> >(finish - replayStart).count();
+
+    // srcFacts report with grouped numbers, then the xmlstats report
+    const auto locale = std::cout.imbue(std::locale{""});
+    writeFactsReport(std::cout, file.url, file.facts, file.languages);
+    std::cout << "\n";
+    std::cout.imbue(locale);
+    stats.report(std::cout);
+
+    std::clog << '\n';
+    std::clog << reader.getEventCount() << " events\n";
+    std::clog << std::setprecision(3) << elapsed_seconds << " sec, with the check of the source\n";
+    std::clog << std::setprecision(3) << replay_seconds << " sec replay\n";
+    std::clog << std::setprecision(3) << reader.getLogSize() / replay_seconds / 1000000 << " MB/sec log\n";
+    std::clog << std::setprecision(3) << reader.getEventCount() / replay_seconds / 1000000 << " Mevents/sec\n";
+    return 0;
+}
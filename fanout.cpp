@@ -0,0 +1,108 @@
+/*
+    fanout.cpp
+
+    Produces the srcFacts report, the xmlstats report, and the identity
+    copy of XML from a single parse, so the input is read and tokenized
+    once for all three.
+
+    Input is an XML file in the srcML format on stdin.
+
+    Output is the srcFacts report followed by the xmlstats report on
+    stdout, and the identity copy of the input to the file given as an
+    argument, rebuilt from the events with --rebuild.
+
+    With --pipeline, each handler runs on its own consumer thread, fed
+    by the parser thread through a ring of --ring-size event records,
+    and the statistics of the rings are output to stderr.
+
+    Output performance statistics to stderr.
+
+    Usage: fanout [--rebuild] [--pipeline] [--ring-size N] IDENTITY_OUTPUT < file.xml
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string_view>
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "CompositeHandler.hpp"
+#include "FactsHandler.hpp"
+#include "XMLStatsHandler.hpp"
+#include "IdentityHandler.hpp"
+#include "PipelineHandler.hpp"
+
+using namespace std::literals::string_view_literals;
+
+int main(int argc, char* argv[]) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // command line: [--rebuild] [--pipeline] [--ring-size N] IDENTITY_OUTPUT
+    bool isRebuild = false;
+    bool isPipeline = false;
+    std::size_t ringSize = 64 * 1024;
+    int identityFD = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i] == "--rebuild"sv) {
+            isRebuild = true;
+        } else if (argv[i] == "--pipeline"sv) {
+            isPipeline = true;
+        } else if (argv[i] == "--ring-size"sv && i + 1 < argc) {
+            ringSize = std::max(1L, atol(argv[++i]));
+        } else if (identityFD == -1) {
+            identityFD = open(argv[i], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (identityFD == -1) {
+                std::cerr << "fanout: Unable to open " << argv[i] << '\n';
+                return 1;
+            }
+        }
+    }
+    if (identityFD == -1) {
+        std::cerr << "Usage: fanout [--rebuild] [--pipeline] [--ring-size N] IDENTITY_OUTPUT < file.xml\n";
+        return 1;
+    }
+
+    // all three handlers on a single parse of stdin, called by the parser,
+    // or each on its own consumer thread
+    FileFacts file;
+    file.path = "-";
+    file.ranges.resize(1);
+    XMLStatsHandler stats;
+    {
+        FactsHandler facts;
+        IdentityHandler identity(identityFD, isRebuild);
+        facts.startRange(file.path);
+        if (isPipeline) {
+            PipelineHandler<FactsHandler, XMLStatsHandler, IdentityHandler> pipeline(ringSize, facts, stats, identity);
+            CompositeHandler<PipelineHandler<FactsHandler, XMLStatsHandler, IdentityHandler>> parser(pipeline);
+            parser.parse(0);
+            facts.finishRange(file.ranges.front());
+            std::clog << "\n## Pipeline\n";
+            pipeline.writeStatistics(std::clog);
+        } else {
+            CompositeHandler<FactsHandler, XMLStatsHandler, IdentityHandler> parser(facts, stats, identity);
+            parser.parse(0);
+            facts.finishRange(file.ranges.front());
+        }
+    }
+    close(identityFD);
+    finishFile(file);
+
+    const auto finish = std::chrono::steady_clock::now();
+    const auto elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double> >(finish - start).count();
+    const double mlocPerSec = file.facts.loc / elapsed_seconds / 1000000;
+
+    // srcFacts report with grouped numbers, then the xmlstats report
+    const auto locale = std::cout.imbue(std::locale{""});
+    writeFactsReport(std::cout, file.url, file.facts, file.languages);
+    std::cout << "\n";
+    std::cout.imbue(locale);
+    stats.report(std::cout);
+
+    std::clog << '\n';
+    std::clog << std::setprecision(3) << elapsed_seconds << " sec\n";
+    std::clog << std::setprecision(3) << mlocPerSec << " MLOC/sec\n";
+    return 0;
+}
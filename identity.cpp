@@ -4,111 +4,50 @@
     An identity transformation of XML. The input is XML and the
     output is the equivalent XML.
 
-    Limitation:
-    * CDATA is not complete
+    Output is to the file given as an argument, or to stdout.
+
+    By default no event is changed, so the output is the input copied
+    directly from the parser buffer by a PassthroughWriter. With
+    --rebuild, the output is rebuilt from the parsed events through an
+    OutputWriter, escaping text. Attribute values are not unescaped by
+    the parser, so they are copied with their source.
+
+    Limitation of --rebuild:
+    * Whitespace inside of tags and around the root element is normalized
 */
 
 #include <iostream>
-#include <fstream>
-#include <string>
 #include <string_view>
-#include "XMLParser.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include "CompositeHandler.hpp"
+#include "IdentityHandler.hpp"
 
 using namespace std::literals::string_view_literals;
 
-int main() {
-
-    std::fstream demoCopy;
-    
-    XMLParser parser(
-    [&](int depth, std::string_view qName, std::string_view prefix, std::string_view localName) {
-        
-        demoCopy << "<" << qName << ">";
-    },
-    [&](int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value) {
-        
-        demoCopy.seekp(-1, std::ios_base::cur);
-        demoCopy << " " << qName << "=\"" << value << "\">";
-    },
-    [&](int depth, std::string_view characters) {
-        
-        for (auto i = characters.begin(); i != characters.end(); i++) {
-            if (*i == '<') {
-                demoCopy << "&lt;";
-            } else if (*i == '>') {
-                demoCopy << "&gt;";
-            } else if (*i == '&') {
-                demoCopy << "&amp;";
-            } else {
-                demoCopy << *i;
-            }
-        }
-    },
-    [&](int depth, std::string_view characters) {
-        
-        for (auto i = characters.begin(); i != characters.end(); i++) {
-            if (*i == '<') {
-                demoCopy << "&lt;";
-            } else if (*i == '>') {
-                demoCopy << "&gt;";
-            } else if (*i == '&') {
-                demoCopy << "&amp;";
-            } else {
-                demoCopy << *i;
-            }
-        }
-    },
-    [&](int depth, std::string_view characters) {
-
-        for (auto i = characters.begin(); i != characters.end(); i++) {
-            if (*i == '<') {
-                demoCopy << "&lt;";
-            } else if (*i == '>') {
-                demoCopy << "&gt;";
-            } else if (*i == '&') {
-                demoCopy << "&amp;";
-            } else {
-                demoCopy << *i;
-            }
+int main(int argc, char* argv[]) {
+
+    // command line: [--rebuild] [OUTPUT]
+    bool isRebuild = false;
+    int outputFD = STDOUT_FILENO;
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i] == "--rebuild"sv) {
+            isRebuild = true;
+        } else if ((outputFD = open(argv[i], O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1) {
+            std::cerr << "identity: Unable to open " << argv[i] << '\n';
+            return 1;
         }
-    },
-    [&](int depth, std::string_view prefix, std::string_view uri) {
-        
-        demoCopy.seekp(-1, std::ios_base::cur);
-        demoCopy << " xmlns"; 
-        if (prefix.empty())
-            demoCopy << "=\"" << uri << "\">";
-        else
-            demoCopy << ":" << prefix << "=\"" << uri << "\">";
-    },
-    [&](int depth, std::string_view comment) {
-        demoCopy << comment;
-    },
-    [&](int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone) {
-        
-        demoCopy << "<?xml version=\"" << version << "\" encoding=\"" << encoding.value() << "\" standalone=\"" << standalone.value() << "\"?>\n";
-    },
-    [&](int depth, std::string_view target, std::string_view data) {
-        
-        demoCopy.seekp(-1, std::ios_base::cur);
-        demoCopy << " " << target << "=\"" << data << "\">\n";
-    },
-    [&](int depth, std::string_view prefix, std::string_view qName, std::string_view localName) {
-        demoCopy << "</" << qName << ">";
-    },
-    [&](int depth) {
+    }
 
-        demoCopy.open("democopy.xml");
-        return;
-    },
-    [&](int depth) {
+    {
+        IdentityHandler identity(outputFD, isRebuild);
+        CompositeHandler<IdentityHandler> parser(identity);
 
-        demoCopy << "\n";
-        demoCopy.close();
-        return;
-    });
+        parser.parse();
+    }
 
-    parser.parse();
+    if (outputFD != STDOUT_FILENO)
+        close(outputFD);
 
     return 0;
 }
@@ -6,6 +6,8 @@
 
 #include "refillBuffer.hpp"
 #include <unistd.h>
+#include <algorithm>
+#include <cstring>
 
 #if !defined(_MSC_VER)
 #define READ read
@@ -21,11 +23,14 @@ typedef SSIZE_T ssize_t;
     @param[in,out] cursor Iterator to current position in buffer
     @param[in, out] cursorEnd Iterator to end of buffer for this read
     @param[in, out] buffer Container for characters
+    @param[in] fd File descriptor to read from
+    @param[in] sentinelSize Size of the sentinel written after the data,
+               at the end of the buffer, or 0 for none
     @return Number of bytes read
     @retval 0 EOF
     @retval -1 Read error
 */
-int refillBuffer(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer) {
+int refillBuffer(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer, int fd, std::size_t sentinelSize) {
 
     // number of unprocessed characters [cursor, cursorEnd)
     auto unprocessed = std::distance(cursor, cursorEnd);
@@ -39,21 +44,72 @@ int refillBuffer(std::string::const_iterator& cursor, std::string::const_iterato
 
     // read in whole blocks
     ssize_t readBytes = 0;
-    while (((readBytes = READ(0, static_cast<void*>(buffer.data() + unprocessed),
-        std::distance(cursorEnd, buffer.cend()))) == -1) && (errno == EINTR)) {
+    while (((readBytes = READ(fd, static_cast<void*>(buffer.data() + unprocessed),
+        std::distance(cursorEnd, buffer.cend()) - sentinelSize)) == -1) && (errno == EINTR)) {
     }
     if (readBytes == -1)
         // error in read
         return -1;
-    if (readBytes == 0) {
-        // EOF
-        cursor = buffer.cend();
-        cursorEnd = buffer.cend();
-        return 0;
-    }
 
-    // adjust the end of the cursor to the new bytes
+    // adjust the end of the cursor to the new bytes, none at EOF, leaving
+    // any unprocessed characters for the parser
     cursorEnd += readBytes;
+    if (sentinelSize)
+        writeSentinel(cursorEnd, buffer, sentinelSize);
 
     return readBytes;
 }
+
+/*
+    Refill the buffer from input already in memory, preserving the unused data.
+    Current content [cursor, cursorEnd) is shifted left and as much of the
+    input as fits is appended to the rest of the buffer.
+    @param[in,out] cursor Iterator to current position in buffer
+    @param[in, out] cursorEnd Iterator to end of buffer for this read
+    @param[in, out] buffer Container for characters
+    @param[in, out] input Remaining input, advanced past the copied characters
+    @param[in] sentinelSize Size of the sentinel written after the data,
+               at the end of the buffer, or 0 for none
+    @return Number of bytes copied
+    @retval 0 EOF
+*/
+int refillBuffer(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer, std::string_view& input, std::size_t sentinelSize) {
+
+    // number of unprocessed characters [cursor, cursorEnd)
+    auto unprocessed = std::distance(cursor, cursorEnd);
+
+    // move unprocessed characters, [cursor, cursorEnd), to start of the buffer
+    std::copy(cursor, cursorEnd, buffer.begin());
+
+    // reset cursors
+    cursor = buffer.begin();
+    cursorEnd = cursor + unprocessed;
+
+    // copy as much input as fits
+    const auto copyBytes = std::min(input.size(), static_cast<std::size_t>(std::distance(cursorEnd, buffer.cend())) - sentinelSize);
+    std::copy(input.begin(), input.begin() + copyBytes, buffer.begin() + unprocessed);
+    input.remove_prefix(copyBytes);
+
+    // adjust the end of the cursor to the new bytes
+    cursorEnd += copyBytes;
+    if (sentinelSize)
+        writeSentinel(cursorEnd, buffer, sentinelSize);
+
+    return static_cast<int>(copyBytes);
+}
+
+/*
+    Write the sentinel at cursorEnd, a '<' followed by zeros, so scans
+    that stop at a '<' or at a character that is not in a name need no
+    check for the end of the data, and lookahead past the end of the data
+    reads the sentinel instead of stale characters
+    @param[in] cursorEnd Iterator to end of the data
+    @param[in, out] buffer Container for characters, with room for the sentinel
+    @param[in] sentinelSize Size of the sentinel
+*/
+void writeSentinel(std::string::const_iterator cursorEnd, std::string& buffer, std::size_t sentinelSize) {
+
+    char* const sentinel = buffer.data() + std::distance(buffer.cbegin(), cursorEnd);
+    sentinel[0] = '<';
+    std::memset(sentinel + 1, 0, sentinelSize - 1);
+}
@@ -8,7 +8,13 @@
 #define INCLUDED_REFILLBUFFER_HPP
 
 #include <string>
+#include <string_view>
 
-int refillBuffer(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer);
+int refillBuffer(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer, int fd = 0, std::size_t sentinelSize = 0);
+
+int refillBuffer(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer, std::string_view& input, std::size_t sentinelSize = 0);
+
+// write the sentinel at cursorEnd, a '<' followed by zeros
+void writeSentinel(std::string::const_iterator cursorEnd, std::string& buffer, std::size_t sentinelSize);
 
 #endif
@@ -0,0 +1,289 @@
+/*
+    regression.cpp
+
+    Regression and throughput harness for the three generations of the
+    srcFacts parser: the original monolithic srcFacts, srcFacts built on
+    the free functions of xml_parser.cpp, and srcFacts built on the
+    XMLParser class.
+
+    Each program is run on a corpus of demo.xml and generated files with
+    markup that crosses the first buffer boundary, and the measures of
+    their reports are compared. A generated archive of copies of demo.xml
+    measures the throughput of each in MB per CPU second, and the slowdown
+    of the class version is the median over the runs of its CPU time
+    relative to the original.
+
+    Fails when the class version fails or its report differs from the
+    others, or when it is slower than the original by more than the
+    tolerance percentage, by default REGRESSION_TOLERANCE of the build.
+
+    Usage: regression [--tolerance PERCENT] [--size MB] [--runs N]
+                      ORIGINAL FUNCTIONS CLASS DEMO_XML DIRECTORY
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <filesystem>
+#include <sys/resource.h>
+
+using namespace std::literals::string_view_literals;
+
+// size of the parser buffer in all three generations
+const std::size_t BUFFER_SIZE = 16 * 16 * 4096;
+
+// CPU time, user and system, of the terminated child processes
+double childSeconds() {
+
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// measures of a report with the CPU time to produce it
+struct Report {
+    std::map<std::string, long long> measures;
+    double seconds = 0;
+    bool isFailed = false;
+};
+
+// a program under test
+struct Program {
+    std::string name;
+    std::string path;
+};
+
+/*
+    Run a program with the input file as stdin, and parse its markdown report
+    @param[in] program Path of the program
+    @param[in] input Path of the input file
+    @return Measures of the report and the CPU time, which is less
+            sensitive to the load on the machine than the elapsed time
+*/
+Report runReport(const std::string& program, const std::string& input) {
+
+    const std::string command = "'" + program + "' < '" + input + "' 2>/dev/null";
+    const double start = childSeconds();
+    FILE* output = popen(command.c_str(), "r");
+    if (!output) {
+        std::cerr << "regression: Unable to run " << program << '\n';
+        exit(1);
+    }
+    std::string text;
+    char block[4096];
+    std::size_t size;
+    while ((size = fread(block, 1, sizeof(block), output)) > 0)
+        text.append(block, size);
+    const int status = pclose(output);
+    Report report;
+    report.seconds = childSeconds() - start;
+    if (status != 0) {
+        report.isFailed = true;
+        return report;
+    }
+
+    // rows of the form "| Measure | Value |", skipping the header and separator.
+    // Reports with a column per language end with the Total column, so only
+    // the last column is the value.
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        const auto separator = line.find('|', 1);
+        const auto valueEnd = line.rfind('|');
+        if (line.substr(0, 1) != "|"sv || separator == std::string::npos || valueEnd == separator)
+            continue;
+        const auto valueStart = line.rfind('|', valueEnd - 1);
+        std::string name = line.substr(1, separator - 1);
+        name.erase(name.find_last_not_of(' ') + 1);
+        name.erase(0, name.find_first_not_of(' '));
+        std::string digits;
+        for (auto c : line.substr(valueStart + 1, valueEnd - valueStart - 1)) {
+            if (isdigit(c))
+                digits += c;
+        }
+        if (name == "Measure"sv || digits.empty())
+            continue;
+        report.measures[name] = std::stoll(digits);
+    }
+    return report;
+}
+
+/*
+    Write a srcML unit with the markup at the given offset
+    @param[in] path Path of the file
+    @param[in] prefix Markup before the focus, not aligned
+    @param[in] focus Markup that starts at offset
+    @param[in] offset Offset in the file of the start of the focus
+*/
+void writeEdgeFile(const std::string& path, std::string_view prefix, std::string_view focus, std::size_t offset) {
+
+    std::string document = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)" "\n"
+        R"(<unit xmlns="http://www.srcML.org/srcML/src" xmlns:cpp="http://www.srcML.org/srcML/cpp" revision="1.0.0" language="C++" filename="edge.cpp">)";
+
+    // pad with lines of text so the focus starts at the offset
+    const auto padding = offset - document.size() - prefix.size();
+    for (std::size_t i = 0; i < padding; ++i)
+        document += i % 64 == 63 ? '\n' : 'x';
+    document += prefix;
+    document += focus;
+    document += R"(<expr><name>a</name> <operator>=</operator> <literal type="number">1</literal></expr>)" "\n"
+                R"(<comment type="line">// end</comment>)" "\n"
+                "</unit>\n";
+    std::ofstream(path, std::ios::binary) << document;
+}
+
+/*
+    Write an archive of copies of the unit in demo.xml
+    @param[in] path Path of the archive
+    @param[in] demo Path of demo.xml
+    @param[in] size Minimum size of the archive in bytes
+*/
+void writeArchive(const std::string& path, const std::string& demo, std::size_t size) {
+
+    std::ifstream demoFile(demo, std::ios::binary);
+    std::string unit((std::istreambuf_iterator<char>(demoFile)), std::istreambuf_iterator<char>());
+    unit.erase(0, unit.find("<unit"sv));
+    std::ofstream archive(path, std::ios::binary);
+    archive << R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>)" "\n"
+            << R"(<unit xmlns="http://www.srcML.org/srcML/src" revision="1.0.0">)" "\n\n";
+    for (std::size_t written = 0; written < size; written += unit.size())
+        archive << unit << '\n';
+    archive << "</unit>\n";
+}
+
+int main(int argc, char* argv[]) {
+
+    // command line
+    double tolerance = REGRESSION_TOLERANCE;
+    std::size_t sizeMB = 64;
+    int runs = 11;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--tolerance"sv && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (arg == "--size"sv && i + 1 < argc) {
+            sizeMB = std::max(1L, atol(argv[++i]));
+        } else if (arg == "--runs"sv && i + 1 < argc) {
+            runs = std::max(1, atoi(argv[++i]));
+        } else {
+            args.emplace_back(arg);
+        }
+    }
+    if (args.size() != 5) {
+        std::cerr << "Usage: regression [--tolerance PERCENT] [--size MB] [--runs N] ORIGINAL FUNCTIONS CLASS DEMO_XML DIRECTORY\n";
+        return 1;
+    }
+    const std::vector<Program> programs = { { "Original", args[0] }, { "Functions", args[1] }, { "Class", args[2] } };
+    const std::string demo = args[3];
+    const std::string directory = args[4];
+    std::filesystem::create_directories(directory);
+
+    // corpus of demo.xml, and each kind of markup at offsets just before the first buffer boundary
+    struct Markup {
+        std::string_view name;
+        std::string_view prefix;
+        std::string_view focus;
+    };
+    const Markup markups[] = {
+        { "start",     "",           R"(<expr type="x"><literal type="string">"s"</literal></expr>)" },
+        { "end",       "<name>abc",  "</name>" },
+        { "attribute", "<comment ",  R"(type="line">// c</comment>)" },
+        { "cer",       "<name>a",    "&lt;&amp;&gt;</name>" },
+        { "comment",   "",           "<!-- comment\n-->" },
+        { "cdata",     "",           "<![CDATA[a <b>\n]]>" },
+        { "text",      "<name>",     "text\nwith\nnewlines</name>" },
+    };
+    std::vector<std::string> corpus = { demo };
+    for (const auto& markup : markups) {
+        for (const std::size_t before : { 1, 2, 3, 4, 5, 6, 9, 12 }) {
+            const auto path = directory + "/edge-" + std::string(markup.name) + "-" + std::to_string(before) + ".xml";
+            writeEdgeFile(path, markup.prefix, markup.focus, BUFFER_SIZE - before);
+            corpus.push_back(path);
+        }
+    }
+
+    // compare the measures of the reports of each program with the class version.
+    // Failures of the earlier generations on inputs the class version parses are
+    // reported as fixed, since the earlier generations are kept as they were.
+    int differences = 0;
+    int fixed = 0;
+    for (const auto& input : corpus) {
+        std::vector<Report> reports;
+        for (const auto& program : programs)
+            reports.push_back(runReport(program.path, input));
+        if (reports.back().isFailed) {
+            std::cout << "FAIL " << input << ": " << programs.back().name << '\n';
+            ++differences;
+            continue;
+        }
+        for (std::size_t i = 0; i + 1 < reports.size(); ++i) {
+            if (reports[i].isFailed) {
+                std::cout << "FIXED " << input << ": " << programs[i].name << " fails\n";
+                ++fixed;
+                continue;
+            }
+            for (const auto& measure : reports.back().measures) {
+                const auto value = reports[i].measures.find(measure.first);
+                if (value == reports[i].measures.end() || value->second == measure.second)
+                    continue;
+                std::cout << "DIFF " << input << ": " << measure.first << " " << programs[i].name << " "
+                          << value->second << " " << programs.back().name << " " << measure.second << '\n';
+                ++differences;
+            }
+        }
+    }
+    std::cout << "# Regression\n";
+    std::cout << corpus.size() << " inputs, " << differences << " differences, " << fixed << " fixed failures\n\n";
+
+    // throughput of each program on a generated archive, best of the runs, with
+    // the programs interleaved in each run so they see the same machine load.
+    // The slowdown is the median of the ratios of the class version to the
+    // original in each run, which is steadier than the ratio of the best times
+    const std::string archive = directory + "/throughput.xml";
+    writeArchive(archive, demo, sizeMB * 1024 * 1024);
+    const double archiveMB = std::filesystem::file_size(archive) / 1000000.0;
+    std::vector<double> seconds(programs.size());
+    std::vector<double> ratios;
+    for (int run = 0; run < runs; ++run) {
+        std::vector<double> runSeconds;
+        for (std::size_t i = 0; i < programs.size(); ++i) {
+            runSeconds.push_back(runReport(programs[i].path, archive).seconds);
+            seconds[i] = run ? std::min(seconds[i], runSeconds.back()) : runSeconds.back();
+        }
+        ratios.push_back(runSeconds.front() / runSeconds.back());
+    }
+    std::nth_element(ratios.begin(), ratios.begin() + ratios.size() / 2, ratios.end());
+    std::vector<double> throughputs;
+    std::cout << "| Program   |     MB/s |\n";
+    std::cout << "|:----------|---------:|\n";
+    for (std::size_t i = 0; i < programs.size(); ++i) {
+        throughputs.push_back(archiveMB / seconds[i]);
+        std::cout << "| " << std::setw(9) << std::left << programs[i].name << " | " << std::setw(8) << std::right
+                  << std::fixed << std::setprecision(1) << throughputs.back() << " |\n";
+    }
+    std::cout << '\n';
+    std::filesystem::remove(archive);
+
+    const double slowdown = 100 * (1 - ratios[ratios.size() / 2]);
+    std::cout << programs.back().name << " is " << std::setprecision(1) << slowdown << "% slower than "
+              << programs.front().name << " (tolerance " << tolerance << "%)\n";
+    if (differences) {
+        std::cerr << "regression: Reports differ\n";
+        return 1;
+    }
+    if (slowdown > tolerance) {
+        std::cerr << "regression: " << programs.back().name << " is slower than the tolerance\n";
+        return 1;
+    }
+    return 0;
+}
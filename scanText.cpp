@@ -0,0 +1,127 @@
+/*
+    scanText.cpp
+
+    Implementation file for scanText function
+*/
+
+#include "scanText.hpp"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+    Find the first delimiter in the text, counting the newlines before it,
+    so the text is only read once.
+    Whole blocks are compared at once with SIMD instructions when available.
+    @param[in] first Start of the text
+    @param[in] last End of the text
+    @param[in] delimiter1 Character that ends the text
+    @param[in] delimiter2 Other character that ends the text
+    @param[out] newlines Number of newlines in [first, delimiter)
+    @return Pointer to the first delimiter, or last if there is none
+*/
+const char* scanText(const char* first, const char* last, char delimiter1, char delimiter2, int& newlines) {
+
+    newlines = 0;
+
+#if defined(__AVX2__)
+    const __m256i delimiters1 = _mm256_set1_epi8(delimiter1);
+    const __m256i delimiters2 = _mm256_set1_epi8(delimiter2);
+    const __m256i newlineChars = _mm256_set1_epi8('\n');
+    for (; last - first >= 32; first += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const unsigned int delimiterMask = static_cast<unsigned int>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, delimiters1), _mm256_cmpeq_epi8(block, delimiters2))));
+        const unsigned int newlineMask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newlineChars)));
+        if (delimiterMask) {
+            const int offset = __builtin_ctz(delimiterMask);
+            newlines += __builtin_popcount(newlineMask & ((1U << offset) - 1));
+            return first + offset;
+        }
+        newlines += __builtin_popcount(newlineMask);
+    }
+#elif defined(__SSE2__)
+    const __m128i delimiters1 = _mm_set1_epi8(delimiter1);
+    const __m128i delimiters2 = _mm_set1_epi8(delimiter2);
+    const __m128i newlineChars = _mm_set1_epi8('\n');
+    for (; last - first >= 16; first += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const unsigned int delimiterMask = static_cast<unsigned int>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(block, delimiters1), _mm_cmpeq_epi8(block, delimiters2))));
+        const unsigned int newlineMask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newlineChars)));
+        if (delimiterMask) {
+            const int offset = __builtin_ctz(delimiterMask);
+            newlines += __builtin_popcount(newlineMask & ((1U << offset) - 1));
+            return first + offset;
+        }
+        newlines += __builtin_popcount(newlineMask);
+    }
+#endif
+
+    // remaining characters
+    for (; first != last; ++first) {
+        if (*first == delimiter1 || *first == delimiter2)
+            return first;
+        if (*first == '\n')
+            ++newlines;
+    }
+
+    return last;
+}
+
+/*
+    Find the first delimiter in text that is known to contain one, e.g.,
+    text followed by a sentinel, counting the newlines before it, with no
+    check for the end of the text. Blocks are read whole, so there must be
+    a SIMD block of readable characters after the delimiter.
+    @param[in] first Start of the text
+    @param[in] delimiter1 Character that ends the text
+    @param[in] delimiter2 Other character that ends the text
+    @param[out] newlines Number of newlines in [first, delimiter)
+    @return Pointer to the first delimiter
+*/
+const char* scanText(const char* first, char delimiter1, char delimiter2, int& newlines) {
+
+    newlines = 0;
+
+#if defined(__AVX2__)
+    const __m256i delimiters1 = _mm256_set1_epi8(delimiter1);
+    const __m256i delimiters2 = _mm256_set1_epi8(delimiter2);
+    const __m256i newlineChars = _mm256_set1_epi8('\n');
+    for (;; first += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const unsigned int delimiterMask = static_cast<unsigned int>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, delimiters1), _mm256_cmpeq_epi8(block, delimiters2))));
+        const unsigned int newlineMask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newlineChars)));
+        if (delimiterMask) {
+            const int offset = __builtin_ctz(delimiterMask);
+            newlines += __builtin_popcount(newlineMask & ((1U << offset) - 1));
+            return first + offset;
+        }
+        newlines += __builtin_popcount(newlineMask);
+    }
+#elif defined(__SSE2__)
+    const __m128i delimiters1 = _mm_set1_epi8(delimiter1);
+    const __m128i delimiters2 = _mm_set1_epi8(delimiter2);
+    const __m128i newlineChars = _mm_set1_epi8('\n');
+    for (;; first += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const unsigned int delimiterMask = static_cast<unsigned int>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(block, delimiters1), _mm_cmpeq_epi8(block, delimiters2))));
+        const unsigned int newlineMask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newlineChars)));
+        if (delimiterMask) {
+            const int offset = __builtin_ctz(delimiterMask);
+            newlines += __builtin_popcount(newlineMask & ((1U << offset) - 1));
+            return first + offset;
+        }
+        newlines += __builtin_popcount(newlineMask);
+    }
+#else
+    for (; *first != delimiter1 && *first != delimiter2; ++first) {
+        if (*first == '\n')
+            ++newlines;
+    }
+    return first;
+#endif
+}
@@ -0,0 +1,14 @@
+/*
+    scanText.hpp
+
+    Include file for scanText function
+*/
+
+#ifndef INCLUDED_SCANTEXT_HPP
+#define INCLUDED_SCANTEXT_HPP
+
+const char* scanText(const char* first, const char* last, char delimiter1, char delimiter2, int& newlines);
+
+const char* scanText(const char* first, char delimiter1, char delimiter2, int& newlines);
+
+#endif
@@ -0,0 +1,143 @@
+/*
+    splitRanges.cpp
+
+    Implementation file for splitRanges function
+*/
+
+#include "splitRanges.hpp"
+#include <algorithm>
+#include <ctype.h>
+
+using namespace std::literals::string_view_literals;
+
+/*
+    Split an XML document into ranges of about rangeSize bytes.
+    Ranges start at element start tags below the root element, so
+    each range can be parsed starting at its depth without any
+    other parser context.
+    The scan only tracks markup, without checking well-formedness.
+    @param[in] document Complete XML document
+    @param[in] rangeSize Minimum size of each range, except the last
+    @param[in] maxDepth Deepest start tag where a range can start, e.g., 1
+               to only split a srcML archive between units
+    @return Ranges covering the document in order
+*/
+std::vector<ParseRange> splitRanges(std::string_view document, std::size_t rangeSize, int maxDepth) {
+
+    std::vector<ParseRange> ranges;
+    ranges.push_back({ 0, document.size(), 0, {} });
+    std::vector<std::size_t> openTags;
+    std::size_t nextSplit = rangeSize;
+    std::size_t pos = 0;
+    while ((pos = document.find('<', pos)) != std::string_view::npos) {
+        const auto markup = document.substr(pos);
+        std::size_t markupEnd = std::string_view::npos;
+        if (markup.substr(0, 4) == "<!--"sv) {
+
+            // skip XML comment
+            markupEnd = document.find("-->"sv, pos + 4);
+            if (markupEnd != std::string_view::npos)
+                markupEnd += 3;
+        } else if (markup.substr(0, 9) == "<![CDATA["sv) {
+
+            // skip CDATA
+            markupEnd = document.find("]]>"sv, pos + 9);
+            if (markupEnd != std::string_view::npos)
+                markupEnd += 3;
+        } else if (markup.substr(0, 2) == "<?"sv) {
+
+            // skip XML declaration and processing instructions
+            markupEnd = document.find("?>"sv, pos + 2);
+            if (markupEnd != std::string_view::npos)
+                markupEnd += 2;
+        } else if (markup.substr(0, 2) == "<!"sv) {
+
+            // skip DTD declarations
+            markupEnd = document.find('>', pos + 2);
+            if (markupEnd != std::string_view::npos)
+                ++markupEnd;
+        } else if (markup.substr(0, 2) == "</"sv) {
+
+            // end tag
+            markupEnd = document.find('>', pos + 2);
+            if (markupEnd != std::string_view::npos)
+                ++markupEnd;
+            if (!openTags.empty())
+                openTags.pop_back();
+        } else {
+
+            // start tag, where the split can occur
+            const auto depth = static_cast<int>(openTags.size());
+            if (pos >= nextSplit && depth >= 1 && depth <= maxDepth) {
+                ranges.back().end = pos;
+                ranges.push_back({ pos, document.size(), depth, openTags });
+                nextSplit = pos + rangeSize;
+            }
+
+            // find the end of the start tag, skipping over attribute values
+            const auto nameEnd = std::find_if(markup.begin() + 1, markup.end(), [] (char c) { return isspace(c) || c == '/' || c == '>'; });
+            char delimiter = 0;
+            for (auto p = pos + std::distance(markup.begin(), nameEnd); p < document.size(); ++p) {
+                const char c = document[p];
+                if (delimiter) {
+                    if (c == delimiter)
+                        delimiter = 0;
+                } else if (c == '"' || c == '\'') {
+                    delimiter = c;
+                } else if (c == '>') {
+                    markupEnd = p + 1;
+                    break;
+                }
+            }
+            if (markupEnd != std::string_view::npos && document[markupEnd - 2] != '/')
+                openTags.push_back(pos);
+        }
+        if (markupEnd == std::string_view::npos)
+            break;
+        pos = markupEnd;
+    }
+
+    return ranges;
+}
+
+// local name of the start tag at tagBegin
+std::string_view startTagName(std::string_view document, std::size_t tagBegin) {
+
+    const auto nameBegin = tagBegin + 1;
+    const auto nameEnd = std::min(document.find_first_of(" \t\r\n/>"sv, nameBegin), document.size());
+    const auto name = document.substr(nameBegin, nameEnd - nameBegin);
+    const auto colon = name.find(':');
+    return colon == std::string_view::npos ? name : name.substr(colon + 1);
+}
+
+/*
+    Value of an attribute of the start tag at tagBegin
+    @param[in] document Complete XML document
+    @param[in] tagBegin Offset of the start tag
+    @param[in] localName Local name of the attribute
+    @return Value of the attribute, empty when the start tag does not have it
+*/
+std::string_view startTagAttribute(std::string_view document, std::size_t tagBegin, std::string_view localName) {
+
+    constexpr auto SPACES = " \t\r\n"sv;
+    auto pos = std::min(document.find_first_of(SPACES, tagBegin), document.size());
+    while ((pos = document.find_first_not_of(SPACES, pos)) != std::string_view::npos && document[pos] != '>' && document[pos] != '/') {
+
+        // qName="value" or qName='value', with spaces around the '='
+        const auto nameEnd = std::min(document.find_first_of("= \t\r\n"sv, pos), document.size());
+        auto name = document.substr(pos, nameEnd - pos);
+        const auto colon = name.find(':');
+        if (colon != std::string_view::npos)
+            name.remove_prefix(colon + 1);
+        const auto delimiterPos = document.find_first_of("\"'"sv, nameEnd);
+        if (delimiterPos == std::string_view::npos)
+            break;
+        const auto valueEnd = document.find(document[delimiterPos], delimiterPos + 1);
+        if (valueEnd == std::string_view::npos)
+            break;
+        if (name == localName)
+            return document.substr(delimiterPos + 1, valueEnd - delimiterPos - 1);
+        pos = valueEnd + 1;
+    }
+    return std::string_view();
+}
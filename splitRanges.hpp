@@ -0,0 +1,38 @@
+/*
+    splitRanges.hpp
+
+    Include file for splitRanges function
+*/
+
+#ifndef INCLUDED_SPLITRANGES_HPP
+#define INCLUDED_SPLITRANGES_HPP
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// part of an XML document that can be parsed on its own
+struct ParseRange {
+    std::size_t begin;
+    std::size_t end;
+
+    // parser context at begin, with the offsets of the start tags of the open elements, outermost first
+    int depth;
+    std::vector<std::size_t> openTags;
+};
+
+std::vector<ParseRange> splitRanges(std::string_view document, std::size_t rangeSize, int maxDepth = 1 << 30);
+
+// local name of the start tag at tagBegin
+std::string_view startTagName(std::string_view document, std::size_t tagBegin);
+
+/*
+    Value of an attribute of the start tag at tagBegin
+    @param[in] document Complete XML document
+    @param[in] tagBegin Offset of the start tag
+    @param[in] localName Local name of the attribute
+    @return Value of the attribute, empty when the start tag does not have it
+*/
+std::string_view startTagAttribute(std::string_view document, std::size_t tagBegin, std::string_view localName);
+
+#endif
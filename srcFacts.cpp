@@ -4,9 +4,68 @@
     Produces a report with various measures of source code.
     Supports C++, C, Java, and C#.
 
-    Input is an XML file in the srcML format.
+    Input is an XML file in the srcML format, read from stdin, or
+    a list of srcML files, directories of srcML files, and list files
+    (--list) given on the command line. Multiple files are parsed
+    concurrently, with one parser per worker thread. Files larger than
+    the split size (--split-size, in MB) are split at start tags below
+    the root element, and idle workers steal the remaining ranges. A range
+    that starts inside a unit of an archive counts for the language of the
+    unit. With --functions or --per-unit, files are only split between the
+    units of an archive, so each function and unit is in a single range.
+    With a single worker, files are not split, since no other worker can
+    steal a range.
 
-    Output is a markdown table with the measures.
+    Output is a markdown table with the measures, with a column for each
+    language of the units when there is more than one, and with --per-file
+    a second table with the measures of each file.
+
+    With --functions FILE, a CSV row with the LOC, statements, maximum
+    nesting, cyclomatic complexity, and returns of each function is
+    written to FILE as soon as the function ends.
+
+    With --per-unit FILE, a record with the measures of each unit of an
+    archive is written to FILE as soon as the unit ends, as JSON lines
+    when FILE ends in .jsonl, and otherwise as CSV.
+
+    With --decode, the input is validated as UTF-8, and UTF-16 input,
+    with a BOM or an XML declaration, is transcoded to UTF-8. Decoded
+    files are not split, since ranges are split in the bytes of the input.
+
+    With --checkpoint FILE, the facts of a single input file are written
+    to FILE at the end of a unit of the archive after each checkpoint
+    interval (--checkpoint-interval, in MB) of input, and with --resume
+    the pass continues from the checkpoint in FILE, with the same report.
+    The --functions and --per-unit output is not resumed.
+
+    With --trace FILE, each parser records a sampled binary trace of its
+    events in a ring of --trace-size records, one in every --trace-sample
+    events with an offset in the --trace-range FIRST:LAST of bytes. The
+    ring is dumped to FILE, with the worker number after it for the other
+    workers, on a parse error and on SIGUSR2, and SIGUSR1 turns tracing
+    off and on, starting off with --trace-off. tracedump prints a dump.
+    Tracing supports at most 64 workers.
+
+    With --progress, a line of the bytes read, the throughput, and for
+    input of a known size, the percent done and the time left, is written
+    to stderr at each --progress-interval (in seconds), and with
+    --metrics FILE, FILE is rewritten with the same measures as metrics
+    in the Prometheus text format, and once more when the pass finishes.
+
+    With --speculative, each input file is parsed in turn, cut into chunks
+    of --chunk-size MB that the workers parse in parallel from a guess of
+    the lexical state at each cut, with the events delivered in document
+    order, so a single document that is not an archive is parsed in
+    parallel. Chunks cut in markup are parsed again.
+
+    With --measure SPEC, the start tags of an element are counted as an
+    extra measure of the report, the per-file table, and the per-unit
+    records, with SPEC [PREFIX:]NAME[@ATTRIBUTE[=VALUE]] [LABEL], e.g.,
+    "if If statements", "cpp:if", or "comment@type=line". With --measures
+    FILE, FILE has a spec on each line, with blank lines and lines that
+    start with '#' skipped. The built-in and configured element names are
+    compiled into a perfect hash, so the lookup of a start tag does not
+    depend on the number of measures.
 
     Output performance statistics to stderr.
 
@@ -17,147 +76,550 @@
 
 #include <iostream>
 #include <iomanip>
-#include <cmath>
+#include <fstream>
 #include <chrono>
+#include <string>
 #include <string_view>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <filesystem>
 #include <algorithm>
+#include <cstdlib>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
-#include "XMLParser.hpp"
+#include "CompositeHandler.hpp"
+#include "FactsHandler.hpp"
+#include "ThreadPool.hpp"
+#include "splitRanges.hpp"
+#include "OutputWriter.hpp"
+#include "Checkpoint.hpp"
+#include "EventTrace.hpp"
+#include "ProgressReporter.hpp"
+#include "SpeculativeParser.hpp"
+#include "MeasureSet.hpp"
 
 using namespace std::literals::string_view_literals;
 
-int main() {
+// handler and parser owned by a single worker, reused for every range it parses
+struct FactsWorker {
+    FactsHandler handler;
+    std::unique_ptr<CompositeHandler<FactsHandler>> parser;
+    std::unique_ptr<EventTrace> trace;
+};
+
+/*
+    Parse a single input file with checkpoints, resuming from the last checkpoint
+    @param[in,out] worker Worker of the parse
+    @param[in] path Path of the input, or "-" for stdin
+    @param[in] checkpoints Checkpoints of the pass, with the checkpoint resumed from
+    @param[in] base Checkpoint resumed from, with the facts before its offset
+    @param[in] input Whole input
+    @return Facts of the input
+*/
+FileFacts parseWithCheckpoints(FactsWorker& worker, const std::string& path, Checkpointer& checkpoints,
+                               const Checkpoint& base, std::string_view input) {
+
+    FileFacts file;
+    file.path = path;
+    if (base.offset)
+        file.ranges.push_back(base.facts);
+    file.ranges.emplace_back();
+    worker.handler.checkpoints = &checkpoints;
+    worker.handler.startRange(path);
+    worker.parser->parse(input.substr(base.offset), base.depth, input);
+    worker.handler.finishRange(file.ranges.back());
+    worker.handler.checkpoints = nullptr;
+    finishFile(file);
+    return file;
+}
+
+// add an input path, expanding directories to the srcML files they contain
+void addInput(const std::string& path, std::vector<std::string>& paths) {
+
+    if (!std::filesystem::is_directory(path)) {
+        paths.push_back(path);
+        return;
+    }
+    std::vector<std::string> directoryPaths;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".xml")
+            directoryPaths.push_back(entry.path().string());
+    }
+    std::sort(directoryPaths.begin(), directoryPaths.end());
+    paths.insert(paths.end(), directoryPaths.begin(), directoryPaths.end());
+}
+
+int main(int argc, char* argv[]) {
     const auto start = std::chrono::steady_clock::now();
+
+    // command line: [--per-file] [--functions FILE] [--per-unit FILE] [--jobs N] [--split-size MB] [--decode]
+    //               [--checkpoint FILE] [--checkpoint-interval MB] [--resume]
+    //               [--trace FILE] [--trace-size RECORDS] [--trace-sample N] [--trace-range FIRST:LAST] [--trace-off]
+    //               [--progress] [--progress-interval SECONDS] [--metrics FILE] [--speculative] [--chunk-size MB]
+    //               [--measure SPEC]... [--measures FILE]
+    //               [--list FILE] [FILE | DIRECTORY]...
+    bool isPerFile = false;
+    int jobs = std::max(1U, std::thread::hardware_concurrency());
+    long splitSize = 16 * 1024 * 1024;
+    int functionsFD = -1;
+    int unitsFD = -1;
+    bool isUnitsJSON = false;
+    bool isDecoding = false;
+    std::string checkpointPath;
+    long long checkpointInterval = 64 * 1024 * 1024;
+    bool isResume = false;
+    std::string tracePath;
+    long traceSize = 64 * 1024;
+    long traceSample = 1;
+    long long traceFirst = 0;
+    long long traceLast = LLONG_MAX;
+    bool isTraceOff = false;
+    bool isProgress = false;
+    double progressInterval = 1;
+    std::string metricsPath;
+    bool isSpeculative = false;
+    double chunkSize = 1;
+    MeasureSet measures;
+    const auto addMeasure = [&measures](std::string_view spec) {
+        if (measures.getMeasures().size() == MAX_MEASURES) {
+            std::cerr << "srcFacts: More than " << MAX_MEASURES << " measures\n";
+            return false;
+        }
+        if (!measures.add(spec)) {
+            std::cerr << "srcFacts: Invalid measure \"" << spec << "\", expected [PREFIX:]NAME[@ATTRIBUTE[=VALUE]] [LABEL]\n";
+            return false;
+        }
+        return true;
+    };
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--per-file"sv) {
+            isPerFile = true;
+        } else if ((arg == "--jobs"sv || arg == "-j"sv) && i + 1 < argc) {
+            jobs = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--split-size"sv && i + 1 < argc) {
+            splitSize = std::max(0L, atol(argv[++i])) * 1024 * 1024;
+        } else if (arg == "--decode"sv) {
+            isDecoding = true;
+        } else if (arg == "--checkpoint"sv && i + 1 < argc) {
+            checkpointPath = argv[++i];
+        } else if (arg == "--checkpoint-interval"sv && i + 1 < argc) {
+            checkpointInterval = std::max(1L, atol(argv[++i])) * 1024 * 1024;
+        } else if (arg == "--resume"sv) {
+            isResume = true;
+        } else if (arg == "--trace"sv && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--trace-size"sv && i + 1 < argc) {
+            traceSize = std::max(1L, atol(argv[++i]));
+        } else if (arg == "--trace-sample"sv && i + 1 < argc) {
+            traceSample = std::max(1L, atol(argv[++i]));
+        } else if (arg == "--trace-range"sv && i + 1 < argc) {
+            char* last = nullptr;
+            traceFirst = strtoll(argv[++i], &last, 10);
+            if (*last != ':' || traceFirst < 0) {
+                std::cerr << "srcFacts: Invalid trace range " << argv[i] << ", expected FIRST:LAST\n";
+                return 1;
+            }
+            traceLast = last[1] ? strtoll(last + 1, nullptr, 10) : LLONG_MAX;
+        } else if (arg == "--trace-off"sv) {
+            isTraceOff = true;
+        } else if (arg == "--progress"sv) {
+            isProgress = true;
+        } else if (arg == "--progress-interval"sv && i + 1 < argc) {
+            progressInterval = std::max(0.01, atof(argv[++i]));
+        } else if (arg == "--metrics"sv && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (arg == "--speculative"sv) {
+            isSpeculative = true;
+        } else if (arg == "--chunk-size"sv && i + 1 < argc) {
+            chunkSize = atof(argv[++i]);
+        } else if (arg == "--measure"sv && i + 1 < argc) {
+            if (!addMeasure(argv[++i]))
+                return 1;
+        } else if (arg == "--measures"sv && i + 1 < argc) {
+            std::ifstream specs(argv[++i]);
+            if (!specs) {
+                std::cerr << "srcFacts: Unable to open measures file " << argv[i] << '\n';
+                return 1;
+            }
+            std::string line;
+            while (std::getline(specs, line)) {
+                const auto first = line.find_first_not_of(" \t\r"sv);
+                if (first != std::string::npos && line[first] != '#' && !addMeasure(line))
+                    return 1;
+            }
+        } else if (arg == "--functions"sv && i + 1 < argc) {
+            functionsFD = open(argv[++i], O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+            if (functionsFD == -1) {
+                std::cerr << "srcFacts: Unable to open functions file " << argv[i] << '\n';
+                return 1;
+            }
+            OutputWriter(functionsFD).write("file,function,LOC,statements,nesting,complexity,returns\n"sv);
+        } else if (arg == "--per-unit"sv && i + 1 < argc) {
+            unitsFD = open(argv[++i], O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+            if (unitsFD == -1) {
+                std::cerr << "srcFacts: Unable to open per-unit file " << argv[i] << '\n';
+                return 1;
+            }
+            const std::string_view unitsPath(argv[i]);
+            isUnitsJSON = unitsPath.size() >= 6 && unitsPath.substr(unitsPath.size() - 6) == ".jsonl"sv;
+        } else if (arg == "--list"sv && i + 1 < argc) {
+            std::ifstream list(argv[++i]);
+            if (!list) {
+                std::cerr << "srcFacts: Unable to open list file " << argv[i] << '\n';
+                return 1;
+            }
+            std::string line;
+            while (std::getline(list, line)) {
+                if (!line.empty())
+                    addInput(line, paths);
+            }
+        } else {
+            addInput(std::string(arg), paths);
+        }
+    }
+
+    // CSV header of the per-unit records, with the configured measures
+    if (unitsFD != -1 && !isUnitsJSON) {
+        OutputWriter output(unitsFD);
+        writeUnitHeader(output, measures);
+    }
+
+    // checkpoints are of the offsets of a single input, before any decoding
+    if ((!checkpointPath.empty() || isResume) && (checkpointPath.empty() || paths.size() > 1 || isDecoding)) {
+        std::cerr << "srcFacts: --checkpoint and --resume need a single input file, without --decode\n";
+        return 1;
+    }
+
+    // each worker has a trace, and the traces are in a fixed registry for the signal handlers
+    if (!tracePath.empty() && !paths.empty() && jobs > static_cast<int>(EventTrace::MAX_TRACES)) {
+        std::cerr << "srcFacts: --trace supports at most " << EventTrace::MAX_TRACES << " workers (--jobs)\n";
+        return 1;
+    }
+
+    // chunks are cut in the bytes of the input, as mapped
+    if (isSpeculative && (isDecoding || !checkpointPath.empty())) {
+        std::cerr << "srcFacts: --speculative is not supported with --decode or --checkpoint\n";
+        return 1;
+    }
+
+    // parse stdin, or each file on a pool of workers with a parser per worker.
+    // Files larger than the split size are split into ranges that idle workers steal.
+    FactCounters total;
+    std::vector<LanguageFacts> languages;
     std::string url;
-    int textsize = 0;
-    int loc = 0;
-    int exprCount = 0;
-    int functionCount = 0;
-    int classCount = 0;
-    int unitCount = 0;
-    int declCount = 0;
-    int commentCount = 0;
-    int lineCommentCount = 0;
-    int returnCount = 0;
-    int literalCount = 0;
-    bool isArchive = false;
-
-    XMLParser parser([&](int depth, std::string_view qName, std::string_view prefix, std::string_view localName) {
-
-        // update counts for srcFacts report
-        if (localName == "expr"sv) {
-            ++exprCount;
-        } else if (localName == "decl"sv) {
-            ++declCount;
-        } else if (localName == "comment"sv) {
-            ++commentCount;
-        } else if (localName == "function"sv) {
-            ++functionCount;
-        } else if (localName == "unit"sv) {
-            ++unitCount;
-            if (depth == 1)
-                isArchive == true;
-        } else if (localName == "class"sv) {
-            ++classCount;
-        } else if (localName == "return"sv) {
-            ++returnCount;
-        } else if (localName == "literal"sv) {
-            ++literalCount;
+    std::vector<FileFacts> results;
+    long stolenTasks = 0;
+    std::vector<FactsWorker> workers(paths.empty() ? 1 : jobs);
+    for (auto& worker : workers) {
+        worker.parser = std::make_unique<CompositeHandler<FactsHandler>>(worker.handler);
+        if (functionsFD != -1)
+            worker.handler.functionsOutput = std::make_unique<OutputWriter>(functionsFD);
+        if (unitsFD != -1)
+            worker.handler.unitsOutput = std::make_unique<OutputWriter>(unitsFD);
+        worker.handler.isUnitsJSON = isUnitsJSON;
+        worker.handler.measures = &measures;
+        worker.parser->getParser().setDecoding(isDecoding);
+        if (!tracePath.empty()) {
+            const auto index = &worker - workers.data();
+            worker.trace = std::make_unique<EventTrace>(index ? tracePath + '.' + std::to_string(index) : tracePath,
+                                                        traceSize, traceSample, traceFirst, traceLast);
+            worker.trace->setEnabled(!isTraceOff);
+            worker.parser->getParser().setTrace(worker.trace.get());
         }
-    },
-    [&url, &lineCommentCount](int depth, std::string_view qName, std::string_view prefix, std::string_view localName, std::string_view value) {
-
-        // check url and update line comment counter
-        if (localName == "url"sv) {
-        url = value;
-        }  
-        if (value == "line"sv) {
-        ++lineCommentCount;
+    }
+    if (!tracePath.empty())
+        EventTrace::installSignalHandlers();
+
+    // progress of the bytes read by the refills of all parsers, of the sizes of the
+    // input files, or of stdin when it is a regular file
+    std::unique_ptr<ProgressReporter> progress;
+    if (isProgress || !metricsPath.empty()) {
+        long long inputSize = 0;
+        struct stat info;
+        if (paths.empty() && fstat(0, &info) == 0 && S_ISREG(info.st_mode))
+            inputSize = info.st_size;
+        for (const auto& path : paths) {
+            if (stat(path.c_str(), &info) == 0)
+                inputSize += info.st_size;
         }
-    },
-    [&textsize, &loc](int depth, std::string_view characters) {
-
-        // update textsize and loc
-        textsize += static_cast<int>(characters.size());
-        loc += static_cast<int>(std::count(characters.begin(), characters.end(), '\n'));
-    },
-    [&textsize, &loc](int depth, std::string_view characters) {
-
-        // update textsize and loc
-        textsize += static_cast<int>(characters.size());
-        loc += static_cast<int>(std::count(characters.begin(), characters.end(), '\n'));
-    },
-    [&textsize](int depth, std::string_view characters) {
-
-        // increment textsize
-        ++textsize;
-    },
-    [](int depth, std::string_view prefix, std::string_view uri) {
-        
-        // Nothing done with these in srcFacts
-        return;
-    },
-    [](int depth, std::string_view comment) {
+        progress = std::make_unique<ProgressReporter>(inputSize, progressInterval, isProgress, metricsPath, "srcfacts");
+        for (auto& worker : workers)
+            worker.parser->getParser().setBytesReadHandler([reporter = progress.get()](long long bytesRead) {
+                reporter->add(bytesRead);
+            });
+    }
+    // decoded files are split in the bytes of the input, and with one worker
+    // no other worker steals a range, so the split is only overhead
+    if (isDecoding || workers.size() == 1)
+        splitSize = 0;
+    int checkpoints = 0;
+    double checkpointSeconds = 0;
+    SpeculativeParser::Statistics speculativeStatistics;
 
-        // Nothing done with this in srcFacts
-        return;
-    },
-    [](int depth, std::string_view version, std::optional<std::string_view> encoding, std::optional<std::string_view> standalone) {
+    // values retained by the handlers in the arenas of the parsers
+    long long retainedValues = 0;
+    long long retainedBytes = 0;
+    long long retainReserved = 0;
+    long long unitResets = 0;
+    const auto addRetained = [&](const auto& parser) {
+        for (const auto lifetime : { EventContext::UNIT, EventContext::DOCUMENT }) {
+            const auto& arena = parser.getRetainArena(lifetime);
+            retainedValues += arena.getValuesStored();
+            retainedBytes += arena.getBytesStored();
+            retainReserved += arena.getBytesReserved();
+        }
+        unitResets += parser.getRetainArena(EventContext::UNIT).getResets();
+    };
+    if (!checkpointPath.empty()) {
 
-        // Nothing done with these in srcFacts
-        return;
-    },
-    [](int depth, std::string_view target, std::string_view data) {
+        // input mapped, so a resumed pass starts at the offset of the checkpoint
+        const std::string path = paths.empty() ? "-" : paths.front();
+        const int fd = paths.empty() ? 0 : open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd == -1 || fstat(fd, &info) == -1 || !S_ISREG(info.st_mode)) {
+            std::cerr << "srcFacts: Unable to open " << path << " as a regular file for checkpoints\n";
+            return 1;
+        }
+        const auto size = static_cast<std::size_t>(info.st_size);
+        void* data = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        if (data == MAP_FAILED) {
+            std::cerr << "srcFacts: Unable to map " << path << '\n';
+            return 1;
+        }
+        const std::string_view input(static_cast<const char*>(data), size);
 
-        // Nothing done with these in srcFacts
-        return;
-    },
-    [](int depth, std::string_view prefix, std::string_view qName, std::string_view localName) {
+        // the counts of the configured measures are in the checkpoint, so they must be the same
+        std::vector<std::pair<std::string, std::string>> measureSpecs;
+        for (const auto& measure : measures.getMeasures())
+            measureSpecs.emplace_back(measure.spec, measure.label);
+        Checkpoint base;
+        if (isResume && readCheckpoint(checkpointPath, base)) {
+            if (!isCheckpointOf(base, input)) {
+                std::cerr << "srcFacts: Checkpoint " << checkpointPath << " is not of the input " << path << '\n';
+                return 1;
+            }
+            if (base.measures != measureSpecs) {
+                std::cerr << "srcFacts: Checkpoint " << checkpointPath << " has other measures than --measure and --measures\n";
+                return 1;
+            }
+            std::clog << "Resuming at offset " << base.offset << '\n';
+        } else if (isResume) {
+            std::clog << "No checkpoint " << checkpointPath << ", starting at the beginning\n";
+        }
+        base.measures = std::move(measureSpecs);
+        Checkpointer checkpointer(checkpointPath, checkpointInterval, input, base);
+        results.push_back(parseWithCheckpoints(workers.front(), path, checkpointer, base, input));
+        if (data)
+            munmap(data, size);
+        if (fd != 0)
+            close(fd);
+        checkpoints = checkpointer.getCheckpoints();
+        checkpointSeconds = checkpointer.getSeconds();
+        total = results.front().facts;
+        languages = results.front().languages;
+        url = results.front().url;
+    } else if (isSpeculative && !paths.empty()) {
 
-        // Nothing done with these in srcFacts
-        return;
-    },
-    [](int depth) {
+        // each file mapped, and parsed in chunks by the workers, with the
+        // events delivered in order to the handler of the first worker
+        SpeculativeParser speculativeParser(static_cast<int>(workers.size()),
+                                            static_cast<std::size_t>(std::max(1.0, chunkSize * 1024 * 1024)));
+        if (progress) {
+            speculativeParser.setBytesReadHandler([reporter = progress.get()](long long bytesRead) {
+                reporter->add(bytesRead);
+            });
+        }
+        auto& handler = workers.front().handler;
+        results.resize(paths.size());
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            auto& file = results[i];
+            file.path = paths[i];
+            const int fd = open(paths[i].c_str(), O_RDONLY);
+            struct stat info;
+            if (fd == -1 || fstat(fd, &info) == -1) {
+                std::cerr << "srcFacts: Unable to open " << paths[i] << '\n';
+                return 1;
+            }
+            const auto size = static_cast<std::size_t>(info.st_size);
+            void* data = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+            close(fd);
+            if (data == MAP_FAILED) {
+                std::cerr << "srcFacts: Unable to map " << paths[i] << '\n';
+                return 1;
+            }
+            file.ranges.resize(1);
+            handler.startRange(file.path);
+            speculativeParser.parse(std::string_view(static_cast<const char*>(data), size), handler);
+            handler.finishRange(file.ranges.front());
+            if (data)
+                munmap(data, size);
+            finishFile(file);
+            total += file.facts;
+            mergeLanguages(languages, file.languages);
+        }
+        url = results.size() == 1 ? results.front().url : std::to_string(results.size()) + " files";
+        speculativeStatistics = speculativeParser.getStatistics();
+        addRetained(speculativeParser);
+    } else if (paths.empty()) {
+        auto& worker = workers.front();
+        FileFacts file;
+        file.path = "-";
+        file.ranges.resize(1);
+        worker.handler.startRange("-");
+        worker.parser->parse(0);
+        worker.handler.finishRange(file.ranges.front());
+        finishFile(file);
+        results.push_back(std::move(file));
+        total = results.front().facts;
+        languages = results.front().languages;
+        url = results.front().url;
+    } else {
+        results.resize(paths.size());
 
-        // Nothing done here
-        return;
-    },
-    [](int depth) {
+        // the metrics of a function and the record of a unit are written when they end, so
+        // with these outputs, ranges only start at depth 1, between the units of an archive
+        const int splitDepth = functionsFD != -1 || unitsFD != -1 ? 1 : 1 << 30;
+        ThreadPool pool(static_cast<int>(workers.size()));
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&pool, &workers, &paths, &results, splitSize, splitDepth, i](int workerIndex) {
+                auto& file = results[i];
+                file.path = paths[i];
+                const int fd = open(paths[i].c_str(), O_RDONLY);
+                struct stat info;
+                if (fd == -1 || fstat(fd, &info) == -1) {
+                    std::cerr << "srcFacts: Unable to open " << paths[i] << '\n';
+                    exit(1);
+                }
 
-        // Nothing done here
-        return;
-    });
+                // parse an oversized file as ranges of the mapped file
+                if (splitSize && info.st_size > splitSize) {
+                    const auto size = static_cast<std::size_t>(info.st_size);
+                    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    close(fd);
+                    if (data == MAP_FAILED) {
+                        std::cerr << "srcFacts: Unable to map " << paths[i] << '\n';
+                        exit(1);
+                    }
+                    std::shared_ptr<const char> document(static_cast<const char*>(data), [size](const char* p) {
+                        munmap(const_cast<char*>(p), size);
+                    });
+                    const auto ranges = splitRanges(std::string_view(document.get(), size), splitSize, splitDepth);
+                    file.ranges.resize(ranges.size());
+                    for (std::size_t j = 0; j < ranges.size(); ++j) {
+                        pool.submit([&workers, &file, document, size, range = ranges[j], j](int rangeWorkerIndex) {
+                            auto& worker = workers[rangeWorkerIndex];
+                            worker.handler.startRange(file.path);
+
+                            // a range inside a unit of an archive resumes the language and filename of the unit
+                            const std::string_view input(document.get(), size);
+                            if (range.depth > 1 && startTagName(input, range.openTags[0]) == "unit"sv
+                                && startTagName(input, range.openTags[1]) == "unit"sv) {
+                                const auto unitTag = range.openTags[1];
+                                worker.handler.resumeUnit(startTagAttribute(input, unitTag, "language"sv),
+                                                          startTagAttribute(input, unitTag, "filename"sv),
+                                                          static_cast<long long>(unitTag) - static_cast<long long>(range.begin));
+                            }
+                            worker.parser->parse(std::string_view(document.get() + range.begin, range.end - range.begin), range.depth,
+                                                 std::string_view(document.get(), size));
+                            worker.handler.finishRange(file.ranges[j]);
+                        });
+                    }
+                    return;
+                }
+
+                auto& worker = workers[workerIndex];
+                file.ranges.resize(1);
+                worker.handler.startRange(file.path);
+                worker.parser->parse(fd);
+                close(fd);
+                worker.handler.finishRange(file.ranges.front());
+            });
+        }
+        pool.wait();
+        stolenTasks = pool.getStolenTasks();
 
-    parser.parse();
+        // merge in input order
+        for (auto& file : results) {
+            finishFile(file);
+            total += file.facts;
+            mergeLanguages(languages, file.languages);
+        }
+        url = results.size() == 1 ? results.front().url : std::to_string(results.size()) + " files";
+    }
+
+    // the unit of a file that is not an archive is the whole file
+    if (unitsFD != -1) {
+        OutputWriter output(unitsFD);
+        for (const auto& file : results) {
+            if (file.facts.unitCount && !file.facts.archiveUnitCount)
+                writeUnitRecord(workers.front().handler.row, output, isUnitsJSON, file.filename.empty() ? file.path : file.filename,
+                                file.languages.size() == 1 ? file.languages.front().language : ""sv, file.facts, measures);
+        }
+    }
+
+    for (const auto& worker : workers)
+        addRetained(worker.parser->getParser());
+    workers.clear();
+    if (progress)
+        progress->stop();
 
     const auto finish = std::chrono::steady_clock::now();
     const auto elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double> >(finish - start).count();
-    const double mlocPerSec = loc / elapsed_seconds / 1000000;
-    auto files = unitCount;
-    if (isArchive)
-        --files;
+    const double mlocPerSec = total.loc / elapsed_seconds / 1000000;
 
     // output report
     std::cout.imbue(std::locale{""});
-    int valueWidth = std::max(5, static_cast<int>(log10(parser.getTotalBytes()) * 1.3 + 1));
-    std::cout << "# srcFacts: " << url << '\n';
-    std::cout << "| Measure      | " << std::setw(valueWidth + 3) << "Value |\n";
-    std::cout << "|:-------------|-" << std::setw(valueWidth + 3) << std::setfill('-') << ":|\n" << std::setfill(' ');
-    std::cout << "| srcML bytes  | " << std::setw(valueWidth) << parser.getTotalBytes()   << " |\n";
-    std::cout << "| Characters   | " << std::setw(valueWidth) << textsize          << " |\n";
-    std::cout << "| Files        | " << std::setw(valueWidth) << files             << " |\n";
-    std::cout << "| LOC          | " << std::setw(valueWidth) << loc               << " |\n";
-    std::cout << "| Classes      | " << std::setw(valueWidth) << classCount        << " |\n";
-    std::cout << "| Functions    | " << std::setw(valueWidth) << functionCount     << " |\n";
-    std::cout << "| Declarations | " << std::setw(valueWidth) << declCount         << " |\n";
-    std::cout << "| Expressions  | " << std::setw(valueWidth) << exprCount         << " |\n";
-    std::cout << "| Comments     | " << std::setw(valueWidth) << commentCount      << " |\n";
-    std::cout << "| Line Comments| " << std::setw(valueWidth) << lineCommentCount  << " |\n";
-    std::cout << "| Returns      | " << std::setw(valueWidth) << returnCount       << " |\n";
-    std::cout << "| Literals     | " << std::setw(valueWidth) << literalCount      << " |\n";
+    writeFactsReport(std::cout, url, total, languages, measures);
+
+    // output per-file report
+    if (isPerFile && !paths.empty()) {
+        std::cout << "\n## Files\n";
+        std::cout << "| File | srcML bytes | Characters | LOC | Classes | Functions | Declarations | Expressions | Comments | Line Comments | Returns | Literals |";
+        for (const auto& measure : measures.getMeasures())
+            std::cout << ' ' << measure.label << " |";
+        std::cout << "\n|:-----|------------:|-----------:|----:|--------:|----------:|-------------:|------------:|---------:|--------------:|--------:|---------:|";
+        for (const auto& measure : measures.getMeasures())
+            std::cout << std::string(measure.label.size() + 1, '-') << ":|";
+        std::cout << '\n';
+        for (const auto& result : results) {
+            const auto& facts = result.facts;
+            std::cout << "| " << result.path
+                      << " | " << facts.bytes
+                      << " | " << facts.textsize
+                      << " | " << facts.loc
+                      << " | " << facts.classCount
+                      << " | " << facts.functionCount
+                      << " | " << facts.declCount
+                      << " | " << facts.exprCount
+                      << " | " << facts.commentCount
+                      << " | " << facts.lineCommentCount
+                      << " | " << facts.returnCount
+                      << " | " << facts.literalCount
+                      << " |";
+            for (std::size_t i = 0; i < measures.getMeasures().size(); ++i)
+                std::cout << ' ' << facts.measures[i] << " |";
+            std::cout << '\n';
+        }
+    }
     std::clog << '\n';
     std::clog << std::setprecision(3) << elapsed_seconds << " sec\n";
     std::clog << std::setprecision(3) << mlocPerSec << " MLOC/sec\n";
+    if (stolenTasks)
+        std::clog << stolenTasks << " stolen tasks\n";
+    if (speculativeStatistics.chunks)
+        std::clog << speculativeStatistics.chunks << " chunks, " << speculativeStatistics.reparsedChunks << " parsed again, "
+                  << speculativeStatistics.reparsedBytes << " bytes\n";
+    if (!checkpointPath.empty())
+        std::clog << checkpoints << " checkpoints, " << std::setprecision(3) << checkpointSeconds << " sec\n";
+    std::clog << retainedValues << " values retained, " << retainedBytes << " bytes, "
+              << retainReserved << " bytes reserved, " << unitResets << " unit resets\n";
     std::cout << "\n";
     return 0;
 }
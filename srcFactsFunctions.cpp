@@ -0,0 +1,148 @@
+/*
+    srcFactsFunctions.cpp
+
+    Produces the srcFacts report with the free functions of xml_parser.cpp,
+    the generation of the parser between the original srcFacts and the
+    XMLParser class. Used by the regression harness to check that all
+    generations agree.
+
+    Input is an XML file in the srcML format on stdin.
+
+    Output is a markdown table with the measures.
+
+    Output performance statistics to stderr.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include "xml_parser.hpp"
+#include "refillBuffer.hpp"
+#include "FactCounters.hpp"
+
+const int BUFFER_SIZE = 16 * 16 * 4096;
+
+int main() {
+    const auto start = std::chrono::steady_clock::now();
+    std::string url;
+    int textsize = 0;
+    int loc = 0;
+    int exprCount = 0;
+    int functionCount = 0;
+    int classCount = 0;
+    int unitCount = 0;
+    int declCount = 0;
+    int commentCount = 0;
+    int lineCommentCount = 0;
+    int returnCount = 0;
+    int literalCount = 0;
+    int depth = 0;
+    long totalBytes = 0;
+    bool inTag = false;
+    bool isInXMLComment = false;
+    bool isInCDATA = false;
+    std::string inTagQName;
+    std::string_view inTagPrefix;
+    std::string_view inTagLocalName;
+    bool isArchive = false;
+    std::string buffer(BUFFER_SIZE, ' ');
+    std::string::const_iterator cursor = buffer.cend();
+    std::string::const_iterator cursorEnd = buffer.cend();
+    startTracing();
+    while (true) {
+        if (isShort(cursor, cursorEnd)) {
+
+            // refill buffer and adjust iterator
+            refillAndAdjust(cursor, cursorEnd, buffer, totalBytes);
+
+        } if (isEndOfCode(isInXMLComment, isInCDATA, cursor, cursorEnd)) {
+                break;
+        } else if (inXMLNS(inTag, cursor)) {
+
+            // parse XML namespace
+            parseXMLNS(cursor, cursorEnd, inTag, depth);
+
+        } else if (inAttribute(inTag)) {
+
+            // parse attribute
+            parseAttribute(cursor, cursorEnd, inTag, depth, url, inTagLocalName, lineCommentCount);
+
+        } else if (inXMLComment(isInXMLComment, cursor)) {
+
+            // parse XML comment
+            parseXMLComment(cursor, cursorEnd, isInXMLComment);
+
+        } else if (inCDATA(isInCDATA, cursor)) {
+
+            // parse CDATA
+            parseCDATA(cursor, cursorEnd, isInCDATA, textsize, loc);
+
+        } else if (inXMLDeclaration(cursor)) {
+
+            // parse XML declaration
+            parseXMLDeclaration(cursor, cursorEnd, buffer, totalBytes);
+
+        } else if (inProcessingInstruction(cursor)) {
+
+            // parse processing instruction
+            parseProcessingInstruction(cursor, cursorEnd, buffer, totalBytes);
+
+        } else if (inEndTag(cursor)) {
+
+            // parse end tag
+            parseEndTag(cursor, cursorEnd, buffer, totalBytes, depth);
+
+        } else if (inStartTag(cursor)) {
+
+            // parse start tag
+            parseStartTag(cursor, cursorEnd, buffer, totalBytes, depth, exprCount, declCount, commentCount, functionCount, unitCount, classCount, returnCount, literalCount, isArchive, inTag, inTagQName, inTagPrefix, inTagLocalName);
+
+        } else if (isBeforeOrAfter(depth)) {
+
+            // parse characters before or after XML
+            parseBeforeOrAfter(cursor, cursorEnd);
+
+        } else if (isCharEntityRef(cursor)) {
+
+            // parse character entity references
+            parseCharEntityRefs(cursor, textsize);
+
+        } else {
+
+            // parse character non-entity references (NonCER)
+            parseNonCER(cursor, cursorEnd, loc, textsize);
+
+        }
+    }
+    stopTracing();
+    const auto finish = std::chrono::steady_clock::now();
+    const auto elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double> >(finish - start).count();
+    const double mlocPerSec = loc / elapsed_seconds / 1000000;
+    int files = unitCount;
+    if (isArchive)
+        --files;
+    std::cout.imbue(std::locale{""});
+    const int valueWidth = reportWidth(totalBytes);
+    std::cout << "# srcFacts: " << url << '\n';
+    std::cout << "| Measure      | " << std::setw(valueWidth + 3) << "Value |\n";
+    std::cout << "|:-------------|-" << std::setw(valueWidth + 3) << std::setfill('-') << ":|\n" << std::setfill(' ');
+    std::cout << "| srcML bytes  | " << std::setw(valueWidth) << totalBytes       << " |\n";
+    std::cout << "| Characters   | " << std::setw(valueWidth) << textsize         << " |\n";
+    std::cout << "| Files        | " << std::setw(valueWidth) << files            << " |\n";
+    std::cout << "| LOC          | " << std::setw(valueWidth) << loc              << " |\n";
+    std::cout << "| Classes      | " << std::setw(valueWidth) << classCount       << " |\n";
+    std::cout << "| Functions    | " << std::setw(valueWidth) << functionCount    << " |\n";
+    std::cout << "| Declarations | " << std::setw(valueWidth) << declCount        << " |\n";
+    std::cout << "| Expressions  | " << std::setw(valueWidth) << exprCount        << " |\n";
+    std::cout << "| Comments     | " << std::setw(valueWidth) << commentCount     << " |\n";
+    std::cout << "| Line Comments| " << std::setw(valueWidth) << lineCommentCount << " |\n";
+    std::cout << "| Returns      | " << std::setw(valueWidth) << returnCount      << " |\n";
+    std::cout << "| Literals     | " << std::setw(valueWidth) << literalCount     << " |\n";
+    std::clog << '\n';
+    std::clog << std::setprecision(3) << elapsed_seconds << " sec\n";
+    std::clog << std::setprecision(3) << mlocPerSec << " MLOC/sec\n";
+    std::cout << "\n";
+    return 0;
+}
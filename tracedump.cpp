@@ -0,0 +1,77 @@
+/*
+    tracedump.cpp
+
+    Prints the records of a dump of an EventTrace ring, oldest first, one
+    event per line with the time since the trace started, the kind, depth,
+    offset, and source length of the event, followed by the number of
+    records of each kind.
+
+    The dump is written by a parser with a trace, e.g., srcFacts --trace,
+    on a parse error, or on the dump signal.
+
+    Usage: tracedump DUMP
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string_view>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include "EventTrace.hpp"
+
+namespace {
+
+    // names of the kinds of events, indexed by kind
+    constexpr std::array<std::string_view, 12> KIND_NAMES = {
+        "START_DOCUMENT", "START_TAG", "ATTRIBUTE", "CHARACTERS", "CDATA", "CHAR_ENTITY_REF",
+        "NAMESPACE", "COMMENT", "DECLARATION", "PI", "END_TAG", "END_DOCUMENT"
+    };
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc != 2) {
+        std::cerr << "usage: tracedump DUMP\n";
+        return 1;
+    }
+    std::ifstream dump(argv[1], std::ios::binary);
+    if (!dump) {
+        std::cerr << "tracedump: Unable to open " << argv[1] << '\n';
+        return 1;
+    }
+    EventTrace::Header header;
+    if (!dump.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || !std::equal(std::begin(EventTrace::MAGIC), std::end(EventTrace::MAGIC), header.magic)) {
+        std::cerr << "tracedump: " << argv[1] << " is not a trace dump\n";
+        return 1;
+    }
+    if (header.version != EventTrace::VERSION || header.recordSize != sizeof(EventTrace::Record)) {
+        std::cerr << "tracedump: Unsupported trace dump version " << header.version << '\n';
+        return 1;
+    }
+    std::vector<EventTrace::Record> records(header.records);
+    if (!dump.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(EventTrace::Record))) {
+        std::cerr << "tracedump: Truncated trace dump " << argv[1] << '\n';
+        return 1;
+    }
+
+    std::cout << "# " << header.records << " of " << header.recorded << " records, 1 in "
+              << header.sampleInterval << " events at offsets [" << header.firstOffset << ", " << header.lastOffset << ")\n";
+    std::cout << "# nanoseconds kind depth offset length\n";
+    std::array<long long, KIND_NAMES.size()> kindCounts{};
+    for (const auto& record : records) {
+        const auto name = record.kind < KIND_NAMES.size() ? KIND_NAMES[record.kind] : std::string_view("UNKNOWN");
+        std::cout << std::setw(14) << record.timestamp << ' ' << std::setw(15) << std::left << name << std::right
+                  << ' ' << std::setw(5) << record.depth << ' ' << std::setw(12) << record.offset
+                  << ' ' << record.length << '\n';
+        if (record.kind < KIND_NAMES.size())
+            ++kindCounts[record.kind];
+    }
+    for (std::size_t kind = 0; kind < KIND_NAMES.size(); ++kind) {
+        if (kindCounts[kind])
+            std::cout << "# " << KIND_NAMES[kind] << ' ' << kindCounts[kind] << '\n';
+    }
+    return 0;
+}
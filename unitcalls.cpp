@@ -0,0 +1,90 @@
+/*
+    unitcalls.cpp
+
+    Markdown report of the calls of each unit to the functions defined
+    in the same unit, from the tree of one unit at a time.
+
+    Input is an XML file in the srcML format on stdin.
+
+    Output performance statistics to stderr.
+
+    Usage: unitcalls < file.xml
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <cstdint>
+#include "CompositeHandler.hpp"
+#include "UnitTreeBuilder.hpp"
+
+using namespace std::literals::string_view_literals;
+
+namespace {
+
+    // name of a function or call, the text of its first child name element
+    std::string nameOf(const UnitTree& tree, UnitTree::NodeID node, std::uint32_t nameID) {
+
+        for (auto child = tree.firstChild(node); child != UnitTree::NONE; child = tree.nextSibling(child)) {
+            if (tree.kind(child) == UnitTree::ELEMENT && tree.nameID(child) == nameID)
+                return tree.textOf(child);
+        }
+        return std::string();
+    }
+}
+
+int main() {
+    const auto start = std::chrono::steady_clock::now();
+
+    std::int64_t functionCount = 0;
+    std::int64_t callCount = 0;
+    std::int64_t localCallCount = 0;
+    std::unordered_set<std::string> functions;
+    UnitTreeBuilder builder([&](const UnitTree& tree) {
+
+        // functions of the unit, then the calls to them
+        const std::uint32_t FUNCTION = 0, CALL = 1, NAME = 2;
+        functions.clear();
+        for (UnitTree::NodeID node = 0; node < tree.size(); ++node) {
+            if (tree.kind(node) == UnitTree::ELEMENT && tree.nameID(node) == FUNCTION) {
+                functions.insert(nameOf(tree, node, NAME));
+                ++functionCount;
+            }
+        }
+        for (UnitTree::NodeID node = 0; node < tree.size(); ++node) {
+            if (tree.kind(node) == UnitTree::ELEMENT && tree.nameID(node) == CALL) {
+                ++callCount;
+                if (functions.count(nameOf(tree, node, NAME)))
+                    ++localCallCount;
+            }
+        }
+    });
+
+    // names interned in the order of their IDs in the unit handler
+    builder.getTree().intern("function"sv);
+    builder.getTree().intern("call"sv);
+    builder.getTree().intern("name"sv);
+
+    CompositeHandler<UnitTreeBuilder> parser(builder);
+    parser.parse();
+
+    const auto finish = std::chrono::steady_clock::now();
+    const auto elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double> >(finish - start).count();
+
+    std::cout << "# unitcalls\n";
+    std::cout << "| Measure           | Value |\n";
+    std::cout << "|:------------------|------:|\n";
+    std::cout << "| Units             | " << builder.getUnits() << " |\n";
+    std::cout << "| Functions         | " << functionCount << " |\n";
+    std::cout << "| Calls             | " << callCount << " |\n";
+    std::cout << "| Calls in the unit | " << localCallCount << " |\n";
+
+    std::clog << '\n';
+    std::clog << std::setprecision(3) << elapsed_seconds << " sec\n";
+    std::clog << std::setprecision(3) << parser.getParser().getTotalBytes() / elapsed_seconds / 1000000 << " MB/sec\n";
+    std::clog << builder.getLargestUnit() << " nodes in the largest unit, " << builder.getTree().getBytesReserved() << " bytes reserved\n";
+    return 0;
+}
@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <bitset>
 #include <string.h>
+#include <optional>
 
 using namespace std::literals::string_view_literals;
 
@@ -550,10 +551,11 @@ void parseNonCER(std::string::const_iterator& cursor, std::string::const_iterato
     std::advance(cursor, characters.size());
 }
 
-// predicate function checks the length of our buffer for refill
+// predicate function checks the length of our buffer for refill,
+// long enough for the longest lookahead, "<![CDATA["
 bool isShort(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd)
 {
-    return (std::distance(cursor, cursorEnd) < 5);
+    return (std::distance(cursor, cursorEnd) < 9);
 }
 
 // refill buffer and adjust iterator